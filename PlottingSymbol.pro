@@ -8,6 +8,14 @@ win32-msvc* {
     DEFINES -= UNICODE
 }
 
+win32 {
+    LIBS += -lws2_32
+}
+
+unix:!macx {
+    LIBS += -lrt
+}
+
 LIB_PATH = $$PWD/sdk/libs
 message($$LIB_PATH)
 
@@ -61,8 +69,26 @@ SOURCES += \
     $$PWD/src/GeoLune.cpp \
     $$PWD/src/GeoParallelSearch.cpp \
     $$PWD/src/GeoSectorSearch.cpp \
+    $$PWD/src/GeoRangeRings.cpp \
     $$PWD/src/PlottingSymbol.cpp \
     $$PWD/src/DrawLineTool.cpp \
     $$PWD/src/DrawPolygonTool.cpp \
     $$PWD/src/DrawRectangleTool.cpp \
     $$PWD/src/DrawCircleTool.cpp \
+    $$PWD/src/FeaturePool.cpp \
+    $$PWD/src/DrawProfiler.cpp \
+    $$PWD/src/InputRecorder.cpp \
+    $$PWD/src/LocationProvider.cpp \
+    $$PWD/src/SymbolTypeRegistry.cpp \
+    $$PWD/src/PointBuffer.cpp \
+    $$PWD/src/KernelCheck.cpp \
+    $$PWD/src/PlottingSimplify.cpp \
+    $$PWD/src/PlottingClip.cpp \
+    $$PWD/src/VectorTiler.cpp \
+    $$PWD/src/GenerationService.cpp \
+    $$PWD/src/SymbolFeed.cpp \
+    $$PWD/src/TrackSymbols.cpp \
+    $$PWD/src/TemporalSymbols.cpp \
+    $$PWD/src/PlottingWrap.cpp \
+    $$PWD/src/PlottingGeodesic.cpp \
+    $$PWD/src/DisplayLod.cpp \
@@ -1,4 +1,5 @@
 #include "CommandManager.h"
+#include <osgEarth/Metrics>
 
 CommandManager *CommandManager::instance()
 {
@@ -8,6 +9,7 @@ CommandManager *CommandManager::instance()
 
 void CommandManager::undo()
 {
+    METRIC_SCOPED("CommandManager::undo");
     Command * command = popUndoCommand();
     if (command) {
         if (command->unexecute()) {
@@ -20,6 +22,7 @@ void CommandManager::undo()
 
 void CommandManager::redo()
 {
+    METRIC_SCOPED("CommandManager::redo");
     Command * command = popRedoCommand();
     if (command) {
         if (command->execute()) {
@@ -32,6 +35,7 @@ void CommandManager::redo()
 
 void CommandManager::callCommand(Command *command)
 {
+    METRIC_SCOPED("CommandManager::callCommand");
     if (command != NULL) {
         if (command->execute()) {
             pushUndoCommand(command);
@@ -8,6 +8,7 @@
  */\
 
 struct Command {
+    virtual ~Command() {}
     virtual bool execute() = 0;
     virtual bool unexecute() = 0;
 };
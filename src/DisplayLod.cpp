@@ -0,0 +1,206 @@
+#include "DisplayLod.h"
+#include "PlottingSimplify.h"
+#include <osg/CullStack>
+
+using namespace osgEarth::Symbology;
+using namespace osgEarth::Annotation;
+
+namespace {
+
+// 几何的各部分，MultiGeometry为各分量，其余为几何本身
+void collectParts(const Geometry* geom, std::vector<Geometry*>& parts)
+{
+    parts.clear();
+    const MultiGeometry* multi = dynamic_cast<const MultiGeometry*>(geom);
+    if (!multi) {
+        parts.push_back(const_cast<Geometry*>(geom));
+        return;
+    }
+    const GeometryCollection& components = multi->getComponents();
+    for (unsigned int i = 0; i < components.size(); i++)
+        parts.push_back(components[i].get());
+}
+
+Geometry* getGeometry(osg::Node* node)
+{
+    FeatureNode* featureNode = dynamic_cast<FeatureNode*>(node);
+    if (!featureNode || !featureNode->getFeature())
+        return NULL;
+    return featureNode->getFeature()->getGeometry();
+}
+
+}
+
+// 与剔除回调配对的更新回调，剔除回调的嵌套链与更新链分开
+class DisplayLodCallback::Update : public osg::NodeCallback {
+public:
+    explicit Update(DisplayLodCallback* lod) : _lod(lod) {}
+
+    DisplayLodCallback* getLod() { return _lod.get(); }
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        _lod->update(node);
+        traverse(node, nv);
+    }
+
+private:
+    osg::ref_ptr<DisplayLodCallback> _lod;
+};
+
+DisplayLodCallback::DisplayLodCallback(float pixels, float baseTolerance, double equatorRadius)
+    : _pixels(pixels)
+    , _baseTolerance(baseTolerance)
+    , _equatorRadius(equatorRadius)
+    , _requested(0.0f)
+    , _applied(0.0f)
+    , _closed(false)
+{
+}
+
+DisplayLodCallback* DisplayLodCallback::get(osg::Node* node)
+{
+    for (osg::Callback* callback = node->getCullCallback(); callback; callback = callback->getNestedCallback()) {
+        DisplayLodCallback* lod = dynamic_cast<DisplayLodCallback*>(callback);
+        if (lod)
+            return lod;
+    }
+    return NULL;
+}
+
+void DisplayLodCallback::attach(FeatureNode* node, float pixels, float baseTolerance, double equatorRadius, float tolerance)
+{
+    Geometry* geom = getGeometry(node);
+    if (!geom)
+        return;
+    DisplayLodCallback* lod = get(node);
+    if (!lod) {
+        lod = new DisplayLodCallback(pixels, baseTolerance, equatorRadius);
+        lod->_requested = tolerance;
+        node->addCullCallback(lod);
+        node->addUpdateCallback(new Update(lod));
+    }
+    lod->_pixels = pixels;
+    lod->_baseTolerance = baseTolerance;
+    lod->_equatorRadius = equatorRadius;
+    lod->setSource(geom);
+    lod->apply(geom, lod->_requested);
+}
+
+void DisplayLodCallback::detach(osg::Node* node)
+{
+    osg::ref_ptr<DisplayLodCallback> lod = get(node);
+    if (!lod.valid())
+        return;
+    node->removeCullCallback(lod.get());
+    for (osg::Callback* callback = node->getUpdateCallback(); callback; callback = callback->getNestedCallback()) {
+        Update* update = dynamic_cast<Update*>(callback);
+        if (update && update->getLod() == lod.get()) {
+            node->removeUpdateCallback(update);
+            break;
+        }
+    }
+}
+
+Geometry* DisplayLodCallback::createFullGeometry(const Geometry* current) const
+{
+    if (!unchanged(current))
+        return NULL;
+    Geometry* full = current->clone();
+    std::vector<Geometry*> parts;
+    collectParts(full, parts);
+    for (unsigned int p = 0; p < parts.size() && p < _source.size(); p++)
+        parts[p]->assign(_source[p].begin(), _source[p].end());
+    return full;
+}
+
+void DisplayLodCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+{
+    osg::CullStack* cullStack = dynamic_cast<osg::CullStack*>(nv);
+    if (cullStack) {
+        // 节点中心处一米对应的像素数
+        float pixelsPerMeter = fabsf(cullStack->pixelSize(node->getBound().center(), 1.0f));
+        if (pixelsPerMeter > 0.0f) {
+            double degrees = osg::RadiansToDegrees(_pixels / pixelsPerMeter / _equatorRadius);
+            _requested = Math::quantizeTolerance(degrees, _baseTolerance);
+        }
+    }
+    traverse(node, nv);
+}
+
+void DisplayLodCallback::update(osg::Node* node)
+{
+    if (_requested == _applied)
+        return;
+    Geometry* geom = getGeometry(node);
+    if (!geom)
+        return;
+    if (!unchanged(geom))
+        setSource(geom);
+    apply(geom, _requested);
+    static_cast<FeatureNode*>(node)->init();
+}
+
+void DisplayLodCallback::setSource(const Geometry* geom)
+{
+    std::vector<Geometry*> parts;
+    collectParts(geom, parts);
+    _closed = geom->getType() == Geometry::TYPE_POLYGON || geom->getType() == Geometry::TYPE_RING;
+    _source.resize(parts.size());
+    _keep.resize(parts.size());
+    for (unsigned int p = 0; p < parts.size(); p++) {
+        _source[p].assign(parts[p]->begin(), parts[p]->end());
+        _keep[p].assign(_source[p].size(), 1);
+    }
+}
+
+bool DisplayLodCallback::unchanged(const Geometry* geom) const
+{
+    std::vector<Geometry*> parts;
+    collectParts(geom, parts);
+    if (parts.size() != _source.size())
+        return false;
+    for (unsigned int p = 0; p < parts.size(); p++) {
+        const Geometry& part = *parts[p];
+        unsigned int j = 0;
+        for (unsigned int i = 0; i < _source[p].size(); i++) {
+            if (!_keep[p][i])
+                continue;
+            if (j >= part.size() || part[j] != _source[p][i])
+                return false;
+            j++;
+        }
+        if (j != part.size())
+            return false;
+    }
+    return true;
+}
+
+void DisplayLodCallback::apply(Geometry* geom, float tolerance)
+{
+    std::vector<Geometry*> parts;
+    collectParts(geom, parts);
+    for (unsigned int p = 0; p < parts.size() && p < _source.size(); p++) {
+        const std::vector<osg::Vec3d>& source = _source[p];
+        std::vector<unsigned char>& keep = _keep[p];
+        if (tolerance <= 0.0f || source.size() <= 4) {
+            keep.assign(source.size(), 1);
+        } else {
+            _buffer.clear();
+            _buffer.setOrigin(source[0]);
+            _buffer.reserve(source.size());
+            for (unsigned int i = 0; i < source.size(); i++)
+                _buffer.push_back(source[i]);
+            Math::simplify(_buffer, tolerance, _closed, keep);
+        }
+
+        // 只用标记挑选完整精度的点，坐标仍是double精度
+        Geometry* part = parts[p];
+        part->clear();
+        for (unsigned int i = 0; i < source.size(); i++) {
+            if (keep[i])
+                part->push_back(source[i]);
+        }
+    }
+    _applied = tolerance;
+}
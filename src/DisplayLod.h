@@ -0,0 +1,68 @@
+#ifndef DISPLAYLOD_H
+#define DISPLAYLOD_H 1
+
+#include <osg/NodeCallback>
+#include <osgEarthAnnotation/FeatureNode>
+#include <osgEarthSymbology/Geometry>
+#include <vector>
+
+#include "PointBuffer.h"
+
+/**
+ * 落图符号的显示LOD
+ * 挂在要素节点上作为剔除回调，剔除时按节点到视点的距离估算一个像素对应的经纬度跨度，量化为LOD级别；
+ * 级别变化时由配套的更新回调在下一次更新中从完整精度的外形重新简化并重建节点。
+ * 同一级别内缩放不重建，视图静止时只有一次距离计算。
+ * 几何被编辑器等外部修改后，下一次换级别时以修改后的几何为新的完整精度外形。
+ */
+class DisplayLodCallback : public osg::NodeCallback {
+public:
+    /**
+     * 以node当前的几何为完整精度外形，按最近一次剔除得到的级别原位简化，之后由调用者重建节点
+     * 节点上还没有回调时新建并挂接
+     * @param pixels 简化容差，像素
+     * @param baseTolerance 最细一级的容差（度），更细时不简化
+     * @param equatorRadius 椭球赤道半径，米换算为度
+     * @param tolerance 新建回调时的初始容差（度），之后由剔除决定
+     */
+    static void attach(osgEarth::Annotation::FeatureNode* node, float pixels, float baseTolerance, double equatorRadius,
+        float tolerance);
+    // 移除node上的回调，几何保持当前状态
+    static void detach(osg::Node* node);
+    static DisplayLodCallback* get(osg::Node* node);
+
+    /**
+     * 完整精度的几何，用于导出等需要原始外形的场合
+     * @param current 节点当前（已简化）的几何
+     * @return 新建的几何，current已被外部修改时以它为准，返回NULL
+     */
+    osgEarth::Symbology::Geometry* createFullGeometry(const osgEarth::Symbology::Geometry* current) const;
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+private:
+    class Update;
+
+    DisplayLodCallback(float pixels, float baseTolerance, double equatorRadius);
+
+    // 更新遍历中级别变化时重建
+    void update(osg::Node* node);
+
+    void setSource(const osgEarth::Symbology::Geometry* geom);
+    // 几何是否仍是上次写入的结果
+    bool unchanged(const osgEarth::Symbology::Geometry* geom) const;
+    // 按tolerance从完整精度外形写回几何
+    void apply(osgEarth::Symbology::Geometry* geom, float tolerance);
+
+    float _pixels;
+    float _baseTolerance;
+    double _equatorRadius;
+    float _requested; // 最近一次剔除得到的容差
+    float _applied; // 几何当前的容差
+    bool _closed;
+    std::vector<std::vector<osg::Vec3d> > _source; // 各部分的完整精度外形
+    std::vector<std::vector<unsigned char> > _keep; // 各部分当前保留的点
+    Math::PointBuffer _buffer;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "DrawCircleTool.h"
+#include "DrawProfiler.h"
 #include <osgEarth/GeoMath>
 #include <osgEarth/Units>
 
@@ -46,8 +47,7 @@ void DrawCircleTool::beginDraw(const osg::Vec3d& lla)
             Distance(0, Units::METERS), _circleStyle,
             Angle(0.0, Units::DEGREES));
 
-        _circleEdit = new CircleNodeEditor(_circleNode);
-        drawCommand(osg::NodeList{_circleNode, _circleEdit});
+        drawCommand(_circleNode);
     }
 
     double radius = GeoMath::distance(_centerPoint, lla, getMapNode()->getMapSRS());
@@ -64,7 +64,10 @@ void DrawCircleTool::beginDraw(const osg::Vec3d& lla)
     _radiusNode->setText(osgEarth::Stringify()<<"r="<< osgEarth::Distance(radius).as(Units::KILOMETERS) << "km");
 #endif
 
-    _circleNode->setRadius(radius);
+    {
+        DRAW_PROFILE_STAGE(STAGE_BUILD, "DrawCircleTool::beginDraw");
+        _circleNode->setRadius(radius);
+    }
     if (_centerPoint != lla) {
         _circleNode = NULL;
         _centerPoint = osg::Vec3d();
@@ -78,7 +81,10 @@ void DrawCircleTool::moveDraw(const osg::Vec3d& lla)
         osg::Vec3d midVec((lla.x() + _centerPoint.x()) / 2, (lla.y() + _centerPoint.y()) /2 , (lla.z() +_centerPoint.z()) / 2);
         osgEarth::GeoPoint midPoint(getMapNode()->getMapSRS(), midVec);
          double radius = GeoMath::distance(_centerPoint, lla, getMapNode()->getMapSRS());
-        _circleNode->setRadius(radius);
+        {
+            DRAW_PROFILE_STAGE(STAGE_BUILD, "DrawCircleTool::moveDraw");
+            _circleNode->setRadius(radius);
+        }
 #ifdef SHOW_CIRCLE_RADIUS
         _radiusNode->setPosition(midPoint);
         _radiusNode->setText(osgEarth::Stringify()<<"r="<< osgEarth::Distance(radius).as(Units::KILOMETERS) << "km");
@@ -90,6 +96,21 @@ void DrawCircleTool::endDraw(const osg::Vec3d& lla)
 {
 }
 
+bool DrawCircleTool::hitTest(osg::Node* node, const osg::Vec3d& lla)
+{
+    CircleNode* circle = dynamic_cast<CircleNode*>(node);
+    if (!circle)
+        return false;
+    double distance = GeoMath::distance(circle->getPosition().vec3d(), lla, getMapNode()->getMapSRS());
+    return distance <= circle->getRadius().as(Units::METERS);
+}
+
+osg::Node* DrawCircleTool::createEditor(osg::Node* node)
+{
+    CircleNode* circle = dynamic_cast<CircleNode*>(node);
+    return circle ? new CircleNodeEditor(circle) : NULL;
+}
+
 void DrawCircleTool::resetDraw()
 {
     _centerPoint = osg::Vec3d();
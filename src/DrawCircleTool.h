@@ -18,11 +18,14 @@ public:
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
 
+protected:
+    virtual bool hitTest(osg::Node* node, const osg::Vec3d& lla);
+    virtual osg::Node* createEditor(osg::Node* node);
+
 private:
     osg::Vec3d _centerPoint;
     osgEarth::Symbology::Style _circleStyle;
     osg::ref_ptr<osgEarth::Annotation::CircleNode> _circleNode;
-    osg::ref_ptr<osgEarth::Annotation::CircleNodeEditor> _circleEdit;
     osg::ref_ptr<osgEarth::Annotation::PlaceNode> _radiusNode;
 };
 #endif
@@ -55,11 +55,8 @@ void DrawLineTool::beginDraw(const osg::Vec3d& lla)
         return;
     }
     if (_featureNode == 0) {
-        _feature = new Feature(
-            new LineString,
-            getMapNode()->getMapSRS(), _lineStyle);
-        _featureNode = new FeatureNode(
-            getMapNode(), _feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_LINESTRING, _lineStyle);
+        _feature = _featureNode->getFeature();
 
         drawCommand(_featureNode);
     }
@@ -68,8 +65,9 @@ void DrawLineTool::beginDraw(const osg::Vec3d& lla)
     for (auto& n : _vecPoint) {
         _feature->getGeometry()->push_back(n);
     }
+    densifyGeodesic(_feature->getGeometry(), false);
 
-    _featureNode->init();
+    buildNode(_featureNode);
 
     if (_stippleFeatureNode != 0) {
         _stippleFeature->getGeometry()->clear();
@@ -82,11 +80,8 @@ void DrawLineTool::moveDraw(const osg::Vec3d& lla)
         return;
     }
     if (_stippleFeatureNode == 0) {
-        _stippleFeature = new Feature(
-            new LineString,
-            getMapNode()->getMapSRS(), _lineStyle);
-        _stippleFeatureNode = new FeatureNode(
-            getMapNode(), _stippleFeature);
+        _stippleFeatureNode = acquireFeatureNode(Geometry::TYPE_LINESTRING, _lineStyle);
+        _stippleFeature = _stippleFeatureNode->getFeature();
 
         drawCommand(_stippleFeatureNode);
     }
@@ -94,8 +89,9 @@ void DrawLineTool::moveDraw(const osg::Vec3d& lla)
     _stippleFeature->getGeometry()->clear();
     _stippleFeature->getGeometry()->push_back(_vecPoint[_vecPoint.size() - 1]);
     _stippleFeature->getGeometry()->push_back(lla);
+    densifyGeodesic(_stippleFeature->getGeometry(), false);
 
-    _stippleFeatureNode->init();
+    buildNode(_stippleFeatureNode);
 }
 
 void DrawLineTool::endDraw(const osg::Vec3d& lla)
@@ -110,3 +106,10 @@ void DrawLineTool::resetDraw()
     }
     _featureNode = 0;
 }
+
+void DrawLineTool::releaseNodes()
+{
+    resetDraw();
+    _stippleFeatureNode = 0;
+    _stippleFeature = 0;
+}
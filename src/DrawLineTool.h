@@ -15,6 +15,7 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void releaseNodes();
 
 private:
     osgEarth::Symbology::Style _lineStyle;
@@ -7,9 +7,6 @@ using namespace osgEarth::Annotation;
 
 DrawPolygonTool::DrawPolygonTool(osgEarth::MapNode* mapNode, osg::Group* drawGroup)
     : DrawTool(mapNode, drawGroup)
-    , _featureNode(nullptr)
-    , _stippleFeatureNode(nullptr)
-    , _polygonEdit(nullptr)
 {
 
     _polygonStyle.getOrCreate<PolygonSymbol>()
@@ -65,34 +62,19 @@ void DrawPolygonTool::beginDraw(const osg::Vec3d& lla)
         return;
     }
 
-    if (_polygonEdit != nullptr) {
-        _polygonEdit->removeChildren(0, _polygonEdit->getNumChildren());
-        _polygonEdit = nullptr;
-    }
-    if (_featureNode == nullptr) {
-        Feature* feature = new Feature(
-            new Polygon,
-            getMapNode()->getMapSRS(), _polygonStyle);
-
-        _featureNode = new FeatureNode(
-            getMapNode(), feature);
+    if (!_featureNode.valid()) {
+        _featureNode = acquireFeatureNode(Geometry::TYPE_POLYGON, _polygonStyle);
+        drawCommand(_featureNode);
     }
 
     Geometry* geom = _featureNode->getFeature()->getGeometry();
-    geom->clear();
     _featureNode->setStyle(_polygonStyle);
-    for (auto& n : _vecPoints) {
-        geom->push_back(n);
-    }
+    geom->assign(_vecPoints.begin(), _vecPoints.end());
 
-    _featureNode->init();
-    if (_stippleFeatureNode != nullptr) {
+    buildNode(_featureNode);
+    if (_stippleFeatureNode.valid()) {
         _stippleFeatureNode->getFeature()->getGeometry()->clear();
     }
-    if (_polygonEdit == nullptr) {
-        _polygonEdit = new FeatureEditor(_featureNode);
-    }
-    drawCommand(osg::NodeList{_featureNode, _polygonEdit});
 }
 
 void DrawPolygonTool::moveDraw(const osg::Vec3d& lla)
@@ -100,12 +82,8 @@ void DrawPolygonTool::moveDraw(const osg::Vec3d& lla)
     if (_vecPoints.size() < 2) {
         return;
     }
-    if (_stippleFeatureNode == nullptr) {
-        Feature* feature = new Feature(
-            new LineString,
-            getMapNode()->getMapSRS(), _stippleLineStyle);
-        _stippleFeatureNode = new FeatureNode(
-            getMapNode(), feature);
+    if (!_stippleFeatureNode.valid()) {
+        _stippleFeatureNode = acquireFeatureNode(Geometry::TYPE_LINESTRING, _stippleLineStyle);
 
         drawCommand(_stippleFeatureNode);
     }
@@ -117,18 +95,41 @@ void DrawPolygonTool::moveDraw(const osg::Vec3d& lla)
     geom->push_back(lla);
     geom->push_back(_vecPoints[_vecPoints.size() - 1]);
 
-    _stippleFeatureNode->init();
+    buildNode(_stippleFeatureNode);
 }
 
 void DrawPolygonTool::endDraw(const osg::Vec3d& lla)
 {
 }
 
+bool DrawPolygonTool::hitTest(osg::Node* node, const osg::Vec3d& lla)
+{
+    FeatureNode* featureNode = dynamic_cast<FeatureNode*>(node);
+    if (!featureNode || !featureNode->getFeature())
+        return false;
+    Geometry* geom = featureNode->getFeature()->getGeometry();
+    if (!geom || geom->getType() != Geometry::TYPE_POLYGON)
+        return false;
+    return static_cast<Polygon*>(geom)->contains2D(lla.x(), lla.y());
+}
+
+osg::Node* DrawPolygonTool::createEditor(osg::Node* node)
+{
+    FeatureNode* featureNode = dynamic_cast<FeatureNode*>(node);
+    return featureNode ? new FeatureEditor(featureNode) : NULL;
+}
+
 void DrawPolygonTool::resetDraw()
 {
     _vecPoints.clear();
-    if (_stippleFeatureNode != nullptr) {
+    if (_stippleFeatureNode.valid()) {
         _stippleFeatureNode->getFeature()->getGeometry()->clear();
     }
-    _featureNode = nullptr;
+    _featureNode = NULL;
+}
+
+void DrawPolygonTool::releaseNodes()
+{
+    resetDraw();
+    _stippleFeatureNode = NULL;
 }
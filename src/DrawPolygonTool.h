@@ -15,14 +15,18 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void releaseNodes();
+
+protected:
+    virtual bool hitTest(osg::Node* node, const osg::Vec3d& lla);
+    virtual osg::Node* createEditor(osg::Node* node);
 
 private:
     std::vector<osg::Vec3d> _vecPoints;
     osgEarth::Symbology::Style _polygonStyle;
-    osgEarth::Annotation::FeatureNode* _featureNode;
-    osgEarth::Annotation::FeatureEditor* _polygonEdit;
+    osg::ref_ptr<osgEarth::Annotation::FeatureNode> _featureNode;
     osgEarth::Symbology::Style _stippleLineStyle;
-    osgEarth::Annotation::FeatureNode* _stippleFeatureNode;
+    osg::ref_ptr<osgEarth::Annotation::FeatureNode> _stippleFeatureNode;
 };
 
 #endif
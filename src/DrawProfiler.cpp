@@ -0,0 +1,119 @@
+#include "DrawProfiler.h"
+#include <osgEarth/Metrics>
+#include <iomanip>
+#include <string.h>
+
+DrawProfiler::DrawProfiler()
+    : _enabled(true)
+{
+    reset();
+}
+
+DrawProfiler *DrawProfiler::instance()
+{
+    static DrawProfiler ins;
+    return &ins;
+}
+
+const char* DrawProfiler::stageName(Stage stage)
+{
+    switch (stage) {
+    case STAGE_HANDLE: return "handle";
+    case STAGE_PICK: return "pick";
+    case STAGE_COMPUTE: return "compute";
+    case STAGE_BUILD: return "build";
+    case STAGE_COMMIT: return "commit";
+    case STAGE_LABEL: return "label";
+    default: return "unknown";
+    }
+}
+
+void DrawProfiler::record(Stage stage, double ms)
+{
+    if (stage < 0 || stage >= STAGE_COUNT)
+        return;
+    unsigned int bucket = 0;
+    for (double us = ms * 1000.0; us >= 2.0 && bucket < NUM_BUCKETS - 1; us /= 2.0)
+        bucket++;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Histogram& h = _stages[stage];
+        h.count++;
+        h.total += ms;
+        if (ms > h.max)
+            h.max = ms;
+        h.buckets[bucket]++;
+    }
+
+    if (osgEarth::Metrics::enabled())
+        osgEarth::Metrics::counter("DrawTool", stageName(stage), ms);
+}
+
+void DrawProfiler::dump(std::ostream& out) const
+{
+    // 取快照后再输出，不在锁内写流
+    Histogram stages[STAGE_COUNT];
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        memcpy(stages, _stages, sizeof(stages));
+    }
+
+    out << "[DrawProfiler] stage      count    mean(ms)   p50(ms)    p90(ms)    p99(ms)    max(ms)" << std::endl;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Histogram& h = stages[i];
+        out << "[DrawProfiler] "
+            << std::left << std::setw(10) << stageName((Stage)i) << std::right
+            << std::setw(6) << h.count
+            << std::fixed << std::setprecision(3)
+            << std::setw(11) << (h.count ? h.total / h.count : 0.0)
+            << std::setw(11) << percentile(h, 0.5)
+            << std::setw(11) << percentile(h, 0.9)
+            << std::setw(11) << percentile(h, 0.99)
+            << std::setw(11) << h.max
+            << std::endl;
+    }
+}
+
+void DrawProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    memset(_stages, 0, sizeof(_stages));
+}
+
+ScopedStageTimer::ScopedStageTimer(DrawProfiler::Stage stage, const char* span)
+    : _stage(stage)
+    , _enabled(DrawProfiler::instance()->getEnabled())
+    , _span(_enabled && osgEarth::Metrics::enabled() ? span : NULL)
+    , _start(_enabled ? osg::Timer::instance()->tick() : 0)
+{
+    if (_span)
+        osgEarth::Metrics::begin(_span);
+}
+
+ScopedStageTimer::~ScopedStageTimer()
+{
+    if (!_enabled)
+        return;
+    DrawProfiler::instance()->record(_stage, osg::Timer::instance()->delta_m(_start, osg::Timer::instance()->tick()));
+    if (_span)
+        osgEarth::Metrics::end(_span);
+}
+
+double DrawProfiler::percentile(const Histogram& h, double p)
+{
+    if (h.count == 0)
+        return 0.0;
+    unsigned int target = (unsigned int)(p * h.count + 0.5);
+    if (target == 0)
+        target = 1;
+    unsigned int seen = 0;
+    for (int k = 0; k < NUM_BUCKETS; k++) {
+        seen += h.buckets[k];
+        if (seen >= target) {
+            double upper = (double)(2u << k) / 1000.0;
+            return upper < h.max ? upper : h.max;
+        }
+    }
+    return h.max;
+}
@@ -0,0 +1,81 @@
+#ifndef DRAWPROFILER_H
+#define DRAWPROFILER_H 1
+
+#include <osg/Timer>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+/**
+ * 绘制工具热点路径统计
+ * 按阶段（拾取、计算、构建、提交等）统计耗时直方图和调用次数，
+ * 每次记录同时输出到osgEarth::Metrics（计数器和以函数名命名的trace区间），
+ * 也可以通过快捷键打印汇总。
+ * 生成服务和跟踪符号的工作线程同样经过外形函数中的计时，record、dump和reset加锁，可在任意线程调用。
+ */
+class DrawProfiler {
+public:
+    enum Stage {
+        STAGE_HANDLE, // DrawTool::handle整体
+        STAGE_PICK, // 屏幕坐标拾取地理坐标
+        STAGE_COMPUTE, // 符号外形计算
+        STAGE_BUILD, // 要素节点重建
+        STAGE_COMMIT, // 提交到绘制组（命令栈）
+        STAGE_LABEL, // 坐标标注更新
+        STAGE_COUNT
+    };
+
+    static DrawProfiler* instance();
+    static const char* stageName(Stage stage);
+
+    // 记录一次阶段耗时，单位毫秒
+    void record(Stage stage, double ms);
+    // 打印各阶段的次数、平均、最大和分位耗时
+    void dump(std::ostream& out) const;
+    void reset();
+
+    // 关闭后ScopedStageTimer不再计时和记录
+    void setEnabled(bool on) { _enabled.store(on, std::memory_order_relaxed); }
+    bool getEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+private:
+    DrawProfiler();
+    DrawProfiler(const DrawProfiler&);
+    DrawProfiler& operator=(const DrawProfiler&);
+
+    // 以微秒为单位按2的幂分桶，第k个桶为[2^k, 2^(k+1))
+    enum { NUM_BUCKETS = 24 };
+    struct Histogram {
+        unsigned int count;
+        double total;
+        double max;
+        unsigned int buckets[NUM_BUCKETS];
+    };
+    // 由直方图估计分位耗时（取所在桶的上界），单位毫秒
+    static double percentile(const Histogram& h, double p);
+
+    mutable std::mutex _mutex;
+    Histogram _stages[STAGE_COUNT];
+    std::atomic<bool> _enabled;
+};
+
+/**
+ * 作用域计时，析构时记录到DrawProfiler
+ * span不为空且启用了Metrics时，同时输出一个同名的trace区间
+ */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(DrawProfiler::Stage stage, const char* span);
+    ~ScopedStageTimer();
+
+private:
+    DrawProfiler::Stage _stage;
+    bool _enabled;
+    const char* _span;
+    osg::Timer_t _start;
+};
+
+// SPAN为trace区间名，与METRIC_SCOPED一样写成"类名::函数名"（__FUNCTION__在GCC上不带类名）
+#define DRAW_PROFILE_STAGE(STAGE, SPAN) ScopedStageTimer drawStageTimer__(DrawProfiler::STAGE, SPAN)
+
+#endif
@@ -1,5 +1,6 @@
 
 #include "DrawRectangleTool.h"
+#include "DrawProfiler.h"
 #include <osgEarth/GeoMath>
 #include <osgEarthAnnotation/AnnotationEditing>
 
@@ -33,6 +34,7 @@ DrawRectangleTool::DrawRectangleTool(MapNode* mapNode, osg::Group* drawGroup)
 void DrawRectangleTool::beginDraw(const osg::Vec3d& lla)
 {
     if (_rectangleNode) {
+        DRAW_PROFILE_STAGE(STAGE_BUILD, "DrawRectangleTool::beginDraw");
         GeoPoint end = GeoPoint(getMapNode()->getMapSRS(), lla);
         _rectangleNode->setCorner(getPointCorner(end), end);
         return;
@@ -50,7 +52,7 @@ void DrawRectangleTool::beginDraw(const osg::Vec3d& lla)
             Distance(0, Units::KILOMETERS),
             _rectangleStyle);
         _rectangleNode->setCorner(getPointCorner(end), end);
-        drawCommand(osg::NodeList{_rectangleNode, new RectangleNodeEditor(_rectangleNode)});
+        drawCommand(_rectangleNode);
     }
 }
 
@@ -68,6 +70,23 @@ void DrawRectangleTool::resetDraw()
     _rectangleNode = nullptr;
 }
 
+bool DrawRectangleTool::hitTest(osg::Node* node, const osg::Vec3d& lla)
+{
+    RectangleNode* rectangle = dynamic_cast<RectangleNode*>(node);
+    if (!rectangle)
+        return false;
+    GeoPoint lowerLeft = rectangle->getLowerLeft();
+    GeoPoint upperRight = rectangle->getUpperRight();
+    return lla.x() >= lowerLeft.x() && lla.x() <= upperRight.x()
+        && lla.y() >= lowerLeft.y() && lla.y() <= upperRight.y();
+}
+
+osg::Node* DrawRectangleTool::createEditor(osg::Node* node)
+{
+    RectangleNode* rectangle = dynamic_cast<RectangleNode*>(node);
+    return rectangle ? new RectangleNodeEditor(rectangle) : NULL;
+}
+
 RectangleNode::Corner DrawRectangleTool::getPointCorner(const GeoPoint& corner)
 {
     GeoPoint center = _rectangleNode->getPosition();
@@ -19,6 +19,10 @@ public:
     // 判断点在矩形所在角位置
     osgEarth::Annotation::RectangleNode::Corner getPointCorner(const osgEarth::GeoPoint& corner);
 
+protected:
+    virtual bool hitTest(osg::Node* node, const osg::Vec3d& lla);
+    virtual osg::Node* createEditor(osg::Node* node);
+
 private:
     std::vector<osg::Vec3d> _vecPoints;
     osgEarth::Symbology::Style _rectangleStyle;
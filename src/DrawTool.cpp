@@ -1,17 +1,39 @@
 #include "DrawTool.h"
+#include "FeaturePool.h"
+#include "DrawProfiler.h"
+#include "DisplayLod.h"
+#include "PlottingSimplify.h"
+#include "PlottingWrap.h"
 #include <osg/Math>
-#include <osgUtil/LineSegmentIntersector>
+#include <osg/ValueObject>
+#include <osgEarth/Metrics>
 #include <osgEarthSymbology/TextSymbol>
 #include <osgEarthSymbology/IconSymbol>
 
+namespace {
+// 最细一级LOD的简化容差（度），约2米；经度180度附近float坐标的1ulp约1.5e-5度，更细的容差没有意义
+const float MIN_DISPLAY_TOLERANCE = 2e-5f;
+// 视图范围向四周扩展的比例
+const float VIEW_EXTENT_MARGIN = 0.1f;
+}
+
 DrawTool::DrawTool(osgEarth::MapNode* mapNode, osg::Group* drawGroup)
     : _mapNode(mapNode)
     , _drawGroup(drawGroup)
     , _active(true)
     , _dbClick(false)
-    , _intersectionMask(0x1)
+    , _view(NULL)
+    , _locationProvider(new SceneLocationProvider(mapNode))
     , _tmpGroup(new osg::Group)
+    , _simplifyPixels(0.5f)
+    , _displayTolerance(0.0f)
+    , _previewGeometry(false)
+    , _clipToView(true)
+    , _viewExtentCached(false)
+    , _geodesicSegment(0.0)
 {
+    const osg::EllipsoidModel* ellipsoid = _mapNode->getMapSRS()->getEllipsoid();
+    _geodesic = Math::Geodesic(ellipsoid->getRadiusEquator(), 1.0 - ellipsoid->getRadiusPolar() / ellipsoid->getRadiusEquator());
     _pnStyle.getOrCreate<osgEarth::Symbology::IconSymbol>()->url()->setLiteral("images/placemark32.png");
     _pnStyle.getOrCreate<osgEarth::Symbology::TextSymbol>()->size() = 14;
     _mapNode->addChild(_tmpGroup);
@@ -22,20 +44,25 @@ bool DrawTool::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter&
     if (!_active)
         return false;
 
+    DRAW_PROFILE_STAGE(STAGE_HANDLE, "DrawTool::handle");
     _view = static_cast<osgViewer::View*>(aa.asView());
 
     const osgGA::GUIEventAdapter::EventType eventType = ea.getEventType();
 
-    if (eventType == osgGA::GUIEventAdapter::KEYDOWN == eventType && ea.getKey() == osgGA::GUIEventAdapter::KEY_Escape) {
+    if (eventType == osgGA::GUIEventAdapter::KEYDOWN && ea.getKey() == osgGA::GUIEventAdapter::KEY_Escape) {
+        clearSelection();
+        finishDraw();
         resetDraw();
     }
 
     if (eventType == osgGA::GUIEventAdapter::KEYDOWN
            && (ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_ALT) != 0) {
         if ( ea.getKey() == osgGA::GUIEventAdapter::KEY_Z) {
+            clearSelection();
             CommandManager::instance()->undo();
             return true;
         } else if ( ea.getKey() == osgGA::GUIEventAdapter::KEY_X) {
+            clearSelection();
             CommandManager::instance()->redo();
             return true;
         }
@@ -53,38 +80,66 @@ bool DrawTool::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter&
     // 鼠标移动
     case osgGA::GUIEventAdapter::MOVE: {
         osg::Vec3d pos;
-        getLocationAt(_view, ea.getX(), ea.getY(), pos.x(), pos.y(), pos.z());
+        getEventLocation(ea, pos);
         std::string coord  = osgEarth::Stringify ()<< pos.x() << " " << pos.y() << " " << pos.z();
         if (_coordPn.valid()) {
+            DRAW_PROFILE_STAGE(STAGE_LABEL, "DrawTool::updateCoordLabel");
             _coordPn->setPosition(osgEarth::GeoPoint::GeoPoint(getMapNode()->getMapSRS(), pos));
             _coordPn->setText(coord);
         }
-        moveDraw(pos);
+        updateViewExtent();
+        _displayTolerance = Math::quantizeTolerance(getPixelSize(pos) * _simplifyPixels, MIN_DISPLAY_TOLERANCE);
+        // 跨过日期变更线时经度接着上一个控制点展开，外形不会绕地球一周
+        if (!_controlPoints.empty())
+            pos.x() = Math::unwrapLongitude(pos.x(), _controlPoints.back().x());
+        {
+            METRIC_SCOPED("DrawTool::moveDraw");
+            moveDraw(pos);
+        }
+        // 预览没有变化时不会重建节点，标记不能留到下一次提交
+        _previewGeometry = false;
         aa.requestRedraw();
         break;
     }
     // 鼠标释放
     case osgGA::GUIEventAdapter::RELEASE: {
         osg::Vec3d pos;
-        getLocationAt(_view, ea.getX(), ea.getY(), pos.x(), pos.y(), pos.z());
+        getEventLocation(ea, pos);
         float eps = 1.0f;
 
         if (ea.getButton() == osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON) {
             if (osg::equivalent(ea.getX(), _mouseDownX, eps) && osg::equivalent(ea.getY(), _mouseDownY, eps)) {
+                // Ctrl+单击选中符号进行编辑
+                if ((ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_CTRL) != 0) {
+                    if (!selectAt(pos))
+                        clearSelection();
+                    aa.requestRedraw();
+                    break;
+                }
                 if (!_coordPn.valid()) {
                     std::string coord  = osgEarth::Stringify ()<< pos.x() << " " << pos.y() << " " << pos.z();
                     _coordPn = new osgEarth::Annotation::PlaceNode(getMapNode(), osgEarth::GeoPoint::GeoPoint(getMapNode()->getMapSRS(), pos), coord, _pnStyle);
                     _tmpGroup->addChild(_coordPn);
                 }
-                beginDraw(pos);
+                if (!_controlPoints.empty())
+                    pos.x() = Math::unwrapLongitude(pos.x(), _controlPoints.back().x());
+                {
+                    METRIC_SCOPED("DrawTool::beginDraw");
+                    beginDraw(pos);
+                }
                 aa.requestRedraw();
             }
         } else if (ea.getButton() == osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON) {
+            clearSelection();
             if (_coordPn.valid()) {
                 _tmpGroup->removeChild(_coordPn);
                 _coordPn = NULL;
             }
-            resetDraw();
+            {
+                METRIC_SCOPED("DrawTool::resetDraw");
+                finishDraw();
+                resetDraw();
+            }
             aa.requestRedraw();
         }
         break;
@@ -96,32 +151,269 @@ bool DrawTool::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter&
 
 void DrawTool::drawCommand(osg::Node *node)
 {
+    DRAW_PROFILE_STAGE(STAGE_COMMIT, "DrawTool::drawCommand");
+    // 记录绘制该符号的工具类型，选中时只处理本工具绘制的符号
+    node->setUserValue("drawType", (int)getType());
     CommandManager::instance()->callCommand(new DrawCommand(_drawGroup, node));
 }
 
 void DrawTool::drawCommand(const osg::NodeList &nodes)
 {
+    DRAW_PROFILE_STAGE(STAGE_COMMIT, "DrawTool::drawCommand");
+    for (auto& node : nodes)
+        node->setUserValue("drawType", (int)getType());
     CommandManager::instance()->callCommand(new DrawCommand(_drawGroup, nodes));
 }
 
-bool DrawTool::getLocationAt(osgViewer::View* view, double x, double y, double& lon, double& lat, double& alt)
+bool DrawTool::selectAt(const osg::Vec3d& lla)
+{
+    clearSelection();
+    // 后绘制的符号在上层，优先选中
+    for (int i = (int)_drawGroup->getNumChildren() - 1; i >= 0; i--) {
+        osg::Node* node = _drawGroup->getChild(i);
+        int drawType = -1;
+        if (!node->getUserValue("drawType", drawType) || drawType != getType())
+            continue;
+        if (!hitTest(node, lla))
+            continue;
+        osg::Node* editor = createEditor(node);
+        if (editor) {
+            _selected = node;
+            _editor = editor;
+            _tmpGroup->addChild(_editor);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DrawTool::clearSelection()
+{
+    if (_editor.valid()) {
+        _tmpGroup->removeChild(_editor);
+        _editor = NULL;
+    }
+    _selected = NULL;
+}
+
+osgEarth::Annotation::FeatureNode* DrawTool::acquireFeatureNode(osgEarth::Symbology::Geometry::Type type, const osgEarth::Symbology::Style& style)
+{
+    return FeaturePool::instance()->acquire(getMapNode(), type, style);
+}
+
+void DrawTool::buildNode(osgEarth::Annotation::FeatureNode* node)
+{
+    DRAW_PROFILE_STAGE(STAGE_BUILD, "DrawTool::buildNode");
+    // 完整精度的几何交给显示LOD，按视图距离简化；预览已经按光标处的级别简化和裁剪过
+    // 预览画在要提交的节点上时，完成绘制（点击或finishDraw）会以完整精度再构建一次，届时挂接
+    if (!_previewGeometry && _simplifyPixels > 0.0f)
+        DisplayLodCallback::attach(node, _simplifyPixels, MIN_DISPLAY_TOLERANCE,
+                                   _mapNode->getMapSRS()->getEllipsoid()->getRadiusEquator(), _displayTolerance);
+    _previewGeometry = false;
+    node->init();
+}
+
+void DrawTool::setGeometryPoints(osgEarth::Symbology::Geometry* geom, const std::vector<osg::Vec2>& points)
+{
+    geom->resize(points.size());
+    for (unsigned int i = 0; i < points.size(); i++)
+        (*geom)[i].set(points[i].x(), points[i].y(), 0.0);
+}
+
+bool DrawTool::updateMultiGeometry(osgEarth::Symbology::MultiGeometry* multiGeom, const Math::MultiLineString& multiLine)
+{
+    osgEarth::Symbology::GeometryCollection& parts = multiGeom->getComponents();
+    bool changed = parts.size() != multiLine.size();
+
+    //多余的分量还给对象池
+    if (parts.size() > multiLine.size())
+        FeaturePool::instance()->releaseComponents(multiGeom, multiLine.size());
+    while (parts.size() < multiLine.size()) {
+        parts.push_back(FeaturePool::instance()->acquireLineString(multiLine[parts.size()].size()));
+    }
+
+    for (unsigned int i = 0; i < multiLine.size(); i++) {
+        osgEarth::Symbology::Geometry* seg = parts[i].get();
+        const Math::LineString& line = multiLine[i];
+        if (seg->size() != line.size()) {
+            seg->resize(line.size());
+            changed = true;
+        }
+        for (unsigned int j = 0; j < line.size(); j++) {
+            osg::Vec3d p(line[j].x(), line[j].y(), 0);
+            if ((*seg)[j] != p) {
+                (*seg)[j] = p;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+double DrawTool::getPixelSize(const osg::Vec3d& lla) const
+{
+    if (!_view || _simplifyPixels <= 0.0f)
+        return 0.0;
+    const osg::Camera* camera = _view->getCamera();
+    const osg::Viewport* viewport = camera->getViewport();
+    double fovy, aspect, zNear, zFar;
+    if (!viewport || viewport->height() <= 0 || !camera->getProjectionMatrixAsPerspective(fovy, aspect, zNear, zFar))
+        return 0.0;
+
+    osg::Vec3d world;
+    _mapNode->getMapSRS()->getEllipsoid()->convertLatLongHeightToXYZ(
+                osg::DegreesToRadians(lla.y()), osg::DegreesToRadians(lla.x()), lla.z(), world.x(), world.y(), world.z());
+    osg::Vec3d eye = osg::Vec3d() * camera->getInverseViewMatrix();
+    double meters = 2.0 * (world - eye).length() * tan(osg::DegreesToRadians(fovy) * 0.5) / viewport->height();
+    // 经度方向随纬度收缩，按赤道换算得到的容差偏小，不会过度简化
+    return osg::RadiansToDegrees(meters / _mapNode->getMapSRS()->getEllipsoid()->getRadiusEquator());
+}
+
+void DrawTool::simplifyForDisplay(osgEarth::Symbology::Geometry* geom, bool closed)
+{
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "DrawTool::simplifyForDisplay");
+    _previewGeometry = true;
+    if (_displayTolerance <= 0.0f || geom->size() <= 4)
+        return;
+
+    _simplifyBuffer.clear();
+    _simplifyBuffer.setOrigin((*geom)[0]);
+    _simplifyBuffer.reserve(geom->size());
+    for (unsigned int i = 0; i < geom->size(); i++)
+        _simplifyBuffer.push_back((*geom)[i]);
+    unsigned int kept = Math::simplify(_simplifyBuffer, _displayTolerance, closed, _simplifyKeep);
+    if (kept == geom->size())
+        return;
+
+    // 只用标记压缩原几何，坐标仍是double精度
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < geom->size(); i++) {
+        if (_simplifyKeep[i])
+            (*geom)[j++] = (*geom)[i];
+    }
+    geom->resize(j);
+}
+
+void DrawTool::updateViewExtent()
+{
+    if (!_view || !_clipToView) {
+        _viewExtent = Math::Extent();
+        _viewExtentCached = false;
+        return;
+    }
+    const osg::Camera* camera = _view->getCamera();
+    const osg::Viewport* viewport = camera->getViewport();
+    if (!viewport) {
+        _viewExtent = Math::Extent();
+        _viewExtentCached = false;
+        return;
+    }
+    // 角点拾取不到（视口内有天空）时结果同样缓存，视图不变就不再重复拾取
+    const osg::Vec4d viewportRect(viewport->x(), viewport->y(), viewport->width(), viewport->height());
+    if (_viewExtentCached && camera->getViewMatrix() == _viewExtentMatrix && viewportRect == _viewExtentViewport)
+        return;
+
+    _viewExtentCached = true;
+    _viewExtentMatrix = camera->getViewMatrix();
+    _viewExtentViewport = viewportRect;
+    _viewExtent = Math::Extent();
+    const double xs[2] = { viewport->x(), viewport->x() + viewport->width() - 1 };
+    const double ys[2] = { viewport->y(), viewport->y() + viewport->height() - 1 };
+    Math::LineString corners;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            osg::Vec3d lla;
+            if (!getLocationAt(_view, xs[i], ys[j], lla.x(), lla.y(), lla.z()))
+                return;
+            corners.push_back(osg::Vec2(lla.x(), lla.y()));
+        }
+    }
+    Math::Extent extent = Math::calculateExtent(corners);
+    if (extent.xMax - extent.xMin > 180.0f)
+        return;
+    _viewExtent = extent.expanded(VIEW_EXTENT_MARGIN);
+}
+
+void DrawTool::clipForDisplay(osgEarth::Symbology::Geometry* geom)
+{
+    _previewGeometry = true;
+    if (!_viewExtent.valid() || geom->empty())
+        return;
+
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "DrawTool::clipForDisplay");
+    osgEarth::Bounds bounds = geom->getBounds();
+    if (bounds.xMin() >= _viewExtent.xMin && bounds.xMax() <= _viewExtent.xMax
+            && bounds.yMin() >= _viewExtent.yMin && bounds.yMax() <= _viewExtent.yMax)
+        return;
+
+    _clipInput.resize(geom->size());
+    for (unsigned int i = 0; i < geom->size(); i++)
+        _clipInput[i].set((*geom)[i].x(), (*geom)[i].y());
+    Math::clipPolygon(_clipInput, _viewExtent, _clipOutput);
+    setGeometryPoints(geom, _clipOutput);
+}
+
+void DrawTool::clipForDisplay(Math::MultiLineString& multiLine)
 {
-    osgUtil::LineSegmentIntersector::Intersections results;
-    if (getMapNode() && view->computeIntersections(x, y, results, _intersectionMask)) {
-        osgUtil::LineSegmentIntersector::Intersection first = *(results.begin());
-        osg::Vec3d point = first.getWorldIntersectPoint();
+    _previewGeometry = true;
+    if (!_viewExtent.valid())
+        return;
 
-        double lat_rad, lon_rad;
-        getMapNode()->getMap()->getProfile()->getSRS()->getEllipsoid()->convertXYZToLatLongHeight(
-            point.x(), point.y(), point.z(), lat_rad, lon_rad, alt);
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "DrawTool::clipForDisplay");
+    for (unsigned int i = 0; i < multiLine.size(); i++) {
+        if (!_viewExtent.contains(Math::calculateExtent(multiLine[i]))) {
+            multiLine = Math::clipMultiLineString(multiLine, _viewExtent);
+            return;
+        }
+    }
+}
+
+void DrawTool::densifyGeodesic(osgEarth::Symbology::Geometry* geom, bool closed)
+{
+    if (_geodesicSegment <= 0.0 || geom->size() < 2)
+        return;
 
-        lat = osg::RadiansToDegrees(lat_rad);
-        lon = osg::RadiansToDegrees(lon_rad);
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "DrawTool::densifyGeodesic");
+    _clipInput.resize(geom->size());
+    for (unsigned int i = 0; i < geom->size(); i++)
+        _clipInput[i].set((*geom)[i].x(), (*geom)[i].y());
+    _geodesic.densify(_clipInput, closed, _geodesicSegment, _clipOutput);
+    if (_clipOutput.size() != _clipInput.size())
+        setGeometryPoints(geom, _clipOutput);
+}
+
+void DrawTool::densifyGeodesic(Math::MultiLineString& multiLine)
+{
+    if (_geodesicSegment <= 0.0)
+        return;
+
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "DrawTool::densifyGeodesic");
+    for (unsigned int i = 0; i < multiLine.size(); i++) {
+        _geodesic.densify(multiLine[i], false, _geodesicSegment, _clipOutput);
+        multiLine[i].swap(_clipOutput);
+    }
+}
+
+bool DrawTool::getLocationAt(osgViewer::View* view, double x, double y, double& lon, double& lat, double& alt)
+{
+    DRAW_PROFILE_STAGE(STAGE_PICK, "DrawTool::getLocationAt");
+    osg::Vec3d lla;
+    if (_locationProvider.valid() && _locationProvider->getLocationAt(view, x, y, lla)) {
+        lon = lla.x();
+        lat = lla.y();
+        alt = lla.z();
         return true;
     }
     return false;
 }
 
+bool DrawTool::getEventLocation(const osgGA::GUIEventAdapter& ea, osg::Vec3d& lla)
+{
+    if (ea.getUserValue("lla", lla))
+        return true;
+    return getLocationAt(_view, ea.getX(), ea.getY(), lla.x(), lla.y(), lla.z());
+}
+
 DrawCommand::DrawCommand(osg::Group *parent, osg::Node *node)
     : parent_(parent) , node_(node), multi_(false){}
 
@@ -142,8 +434,31 @@ bool DrawCommand::unexecute() {
     if (multi_) {
         for (auto& node : nodes_)
             parent_->removeChild(node);
+        return true;
     } else {
         return parent_->removeChild(node_);
     }
 
 }
+
+ClearCommand::ClearCommand(osg::Group *parent)
+    : parent_(parent) {}
+
+bool ClearCommand::execute() {
+    // 首次执行时记下当前的符号，重做时清除同一批
+    if (nodes_.empty()) {
+        for (unsigned int i = 0; i < parent_->getNumChildren(); i++)
+            nodes_.push_back(parent_->getChild(i));
+    }
+    if (nodes_.empty())
+        return false;
+    for (auto& node : nodes_)
+        parent_->removeChild(node);
+    return true;
+}
+
+bool ClearCommand::unexecute() {
+    for (auto& node : nodes_)
+        parent_->addChild(node);
+    return true;
+}
@@ -7,8 +7,14 @@
 #include <osgViewer/View>
 #include <osgEarthSymbology/Style>
 #include <osgEarthAnnotation/PlaceNode>
+#include <osgEarthAnnotation/FeatureNode>
 
 #include "CommandManager.h"
+#include "PlottingMath.h"
+#include "PointBuffer.h"
+#include "PlottingClip.h"
+#include "PlottingGeodesic.h"
+#include "LocationProvider.h"
 
 struct DrawCommand : public Command {
     DrawCommand(osg::Group* parent, osg::Node* node);
@@ -23,12 +29,24 @@ struct DrawCommand : public Command {
     bool multi_;
 };
 
+// 清除绘制组中的全部符号，撤销时原样恢复；命令持有被清除的节点，对象池不会复用它们
+struct ClearCommand : public Command {
+    explicit ClearCommand(osg::Group* parent);
+
+    virtual bool execute();
+    virtual bool unexecute();
+
+    osg::ref_ptr<osg::Group> parent_;
+    osg::NodeList nodes_;
+};
+
 class DrawTool : public osgGA::GUIEventHandler {
 public:
 //    DrawTool();
     virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
 
-    enum DrawType {
+    // 底层类型固定为int，插件工具的getType()返回的类型号超出枚举值时转换仍有定义
+    enum DrawType : int {
         DRAW_LINE, // 线
         DRAW_CIRCLE, // 圈
         DRAW_POLYGON, // 多边形
@@ -49,6 +67,8 @@ public:
         DRAW_GEOLUNE, // 弓形
         DRAW_PARALLELSEARCH, //平行搜寻区
         DRAW_SECTORSEARCH, //扇形搜寻区
+        DRAW_RANGERINGS, //距离环
+        DRAW_USER = 1000, // 插件注册的符号类型从这里开始编号
     };
 
     virtual DrawType getType() = 0;
@@ -67,29 +87,150 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla) = 0;
     virtual void endDraw(const osg::Vec3d& lla) = 0;
     virtual void resetDraw() = 0;
+    /**
+     * 右键或Esc结束绘制时在resetDraw之前调用
+     * 鼠标移动的预览画在要提交的节点上时，节点里是按当时视图裁剪和简化过的外形，
+     * 工具在这里由控制点按完整精度重建最终外形；控制点不足以成形时清空几何
+     */
+    virtual void finishDraw() {}
+    // 绘制组清空前调用，放弃持有的全部预览节点，之后对象池可以安全地回收它们
+    virtual void releaseNodes() { resetDraw(); }
 
     void drawCommand(osg::Node* node);
     void drawCommand(const osg::NodeList& nodes);
 
+    // 选中lla处本工具绘制的符号并挂接编辑器，没有可编辑的符号时返回false
+    bool selectAt(const osg::Vec3d& lla);
+    // 取消选中，移除编辑器
+    void clearSelection();
+
 public:
+    // 屏幕坐标拾取方式，默认与场景求交
+    void setLocationProvider(LocationProvider* provider) { _locationProvider = provider; }
+    LocationProvider* getLocationProvider() { return _locationProvider.get(); }
+
     // 获取点所在地理坐标
     bool getLocationAt(osgViewer::View* view, double x, double y, double& lon, double& lat, double& alt);
+    // 获取事件所在地理坐标，回放的事件带有录制时的拾取结果，直接使用
+    bool getEventLocation(const osgGA::GUIEventAdapter& ea, osg::Vec3d& lla);
+
+    // 预览轮廓的简化容差，单位为像素，不大于0时不简化
+    void setSimplifyPixels(float pixels) { _simplifyPixels = pixels; }
+    float getSimplifyPixels() const { return _simplifyPixels; }
+
+    // 是否把预览轮廓裁剪到当前视图范围
+    void setClipToView(bool on) { _clipToView = on; }
+    bool getClipToView() const { return _clipToView; }
+
+    // 大地线模式：外形的各边加密为大地线，相邻点相距不超过meters米；不大于0时按经纬度直线绘制（默认）
+    void setGeodesicSegment(double meters) { _geodesicSegment = meters; }
+    double getGeodesicSegment() const { return _geodesicSegment; }
+
+    // 用点数组设置几何的坐标，几何只调整一次大小
+    static void setGeometryPoints(osgEarth::Symbology::Geometry* geom, const std::vector<osg::Vec2>& points);
+
+    /**
+     * 用折线集合原位更新MultiGeometry的分量
+     * 已有分量直接覆盖坐标，只有分量数变化时才增删分量
+     * @return 是否有分量发生变化，没有时无需重建要素节点
+     */
+    static bool updateMultiGeometry(osgEarth::Symbology::MultiGeometry* multiGeom, const Math::MultiLineString& multiLine);
 
 protected:
     DrawTool(osgEarth::MapNode* mapNode, osg::Group* drawGroup);
 
+    // 从对象池获取预览要素节点
+    osgEarth::Annotation::FeatureNode* acquireFeatureNode(osgEarth::Symbology::Geometry::Type type, const osgEarth::Symbology::Style& style);
+
+    /**
+     * 重建要素节点，计入构建阶段耗时
+     * 本次几何没有经过clipForDisplay、simplifyForDisplay时视为完整精度的外形，挂接显示LOD
+     */
+    void buildNode(osgEarth::Annotation::FeatureNode* node);
+
+    /**
+     * 把osgEarth几何包装成PlottingKernels中生成核的输出类型
+     * 生成核直接把点写入几何的存储，按核的CAPACITY预留后整个生成过程不再分配内存，
+     * 也不经过中间的点数组
+     */
+    class GeometryPoints {
+    public:
+        explicit GeometryPoints(osgEarth::Symbology::Geometry* geom) : _geom(geom) {}
+
+        void push_back(const osg::Vec2& point) { _geom->push_back(osg::Vec3d(point.x(), point.y(), 0.0)); }
+        osg::Vec2 back() const { const osg::Vec3d& p = _geom->back(); return osg::Vec2(p.x(), p.y()); }
+        unsigned int size() const { return _geom->size(); }
+        bool empty() const { return _geom->empty(); }
+        void clear() { _geom->clear(); }
+        void reserve(unsigned int capacity) { _geom->reserve(capacity); }
+
+    private:
+        osgEarth::Symbology::Geometry* _geom;
+    };
+
+    // lla处一个像素对应的经纬度跨度（度），按视点距离和透视张角估算，不需要额外拾取
+    double getPixelSize(const osg::Vec3d& lla) const;
+
+    /**
+     * 按当前视图的LOD级别原位简化预览几何
+     * 只用于moveDraw中的预览；落图的符号由buildNode挂接DisplayLodCallback，按各自到视点的距离简化
+     * @param closed 几何是否为多边形外环
+     */
+    void simplifyForDisplay(osgEarth::Symbology::Geometry* geom, bool closed);
+
+    /**
+     * 视图变化后重新计算视图范围
+     * 拾取视口四角的经纬度取包围范围并向外扩展，边界处的裁剪痕迹落在屏幕外；
+     * 有角点拾取不到地面（看到天空）或范围跨越日期变更线时不裁剪
+     */
+    void updateViewExtent();
+
+    /**
+     * 把预览外形裁剪到视图范围，在simplifyForDisplay之前调用
+     * 完全在视图内的外形原样保留，不产生拷贝
+     */
+    void clipForDisplay(osgEarth::Symbology::Geometry* geom);
+    void clipForDisplay(Math::MultiLineString& multiLine);
+
+    /**
+     * 大地线模式下把几何的各边加密为大地线，在clipForDisplay之前调用
+     * @param closed 几何是否为多边形外环
+     */
+    void densifyGeodesic(osgEarth::Symbology::Geometry* geom, bool closed);
+    // 同上，各部分按折线处理
+    void densifyGeodesic(Math::MultiLineString& multiLine);
+
+    // 判断lla是否落在符号node上
+    virtual bool hitTest(osg::Node* /*node*/, const osg::Vec3d& /*lla*/) { return false; }
+    // 为选中的符号创建编辑器，不支持编辑时返回NULL
+    virtual osg::Node* createEditor(osg::Node* /*node*/) { return NULL; }
+
     bool _active;
     bool _dbClick;
     osgViewer::View* _view;
     osgEarth::MapNode* _mapNode;
-    osg::Node::NodeMask _intersectionMask;
+    osg::ref_ptr<LocationProvider> _locationProvider;
     osg::Group* _drawGroup;
     float _mouseDownX, _mouseDownY;
     osg::ref_ptr<osg::Group> _tmpGroup; // 临时绘制节点
     osgEarth::Symbology::Style _pnStyle;
     std::vector<osg::Vec2> _controlPoints;
-    std::vector<osg::Vec2> _drawParts;
     osg::ref_ptr<osgEarth::Annotation::PlaceNode> _coordPn;
+    osg::ref_ptr<osg::Node> _selected; // 当前选中的符号
+    osg::ref_ptr<osg::Node> _editor; // 选中符号的编辑器，只在选中期间存在
+    float _simplifyPixels;
+    float _displayTolerance; // 最近一次鼠标移动时的简化容差（度），已按LOD级别量化
+    bool _previewGeometry; // 上次buildNode之后几何被裁剪或简化过
+    Math::PointBuffer _simplifyBuffer;
+    std::vector<unsigned char> _simplifyKeep;
+    bool _clipToView;
+    Math::Extent _viewExtent; // 无效时不裁剪
+    bool _viewExtentCached; // 以下视图状态下的_viewExtent（包括无效）可以直接使用
+    osg::Matrixd _viewExtentMatrix; // 计算_viewExtent时的视图矩阵
+    osg::Vec4d _viewExtentViewport; // 计算_viewExtent时的视口
+    Math::LineString _clipInput, _clipOutput;
+    double _geodesicSegment;
+    Math::Geodesic _geodesic; // 地图的椭球
 };
 
 #endif
@@ -0,0 +1,114 @@
+#include "FeaturePool.h"
+#include "DisplayLod.h"
+
+using namespace osgEarth;
+using namespace osgEarth::Symbology;
+using namespace osgEarth::Features;
+using namespace osgEarth::Annotation;
+
+FeaturePool::FeaturePool()
+    : _maxNodes(64)
+    , _maxLines(512)
+{
+}
+
+FeaturePool *FeaturePool::instance()
+{
+    static FeaturePool ins;
+    return &ins;
+}
+
+FeatureNode* FeaturePool::acquire(MapNode* mapNode, Geometry::Type type, const Style& style)
+{
+    for (unsigned int i = 0; i < _nodes.size(); i++) {
+        FeatureNode* node = _nodes[i].get();
+        //仍被场景或撤销命令引用的节点不能复用
+        if (node->referenceCount() > 1 || node->getNumParents() > 0)
+            continue;
+        Feature* feature = node->getFeature();
+        if (!feature || !feature->getGeometry() || feature->getGeometry()->getType() != type)
+            continue;
+
+        resetGeometry(feature->getGeometry());
+        DisplayLodCallback::detach(node);
+        feature->style() = style;
+        node->setStyle(style);
+
+        //从池中移除，引用交给调用者
+        osg::ref_ptr<FeatureNode> ref = _nodes[i];
+        _nodes[i] = _nodes.back();
+        _nodes.pop_back();
+        return ref.release();
+    }
+
+    Feature* feature = new Feature(createGeometry(type), mapNode->getMapSRS(), style);
+    return new FeatureNode(mapNode, feature);
+}
+
+void FeaturePool::release(FeatureNode* node)
+{
+    if (node == NULL || _nodes.size() >= _maxNodes)
+        return;
+    for (auto& n : _nodes) {
+        if (n.get() == node)
+            return;
+    }
+    _nodes.push_back(node);
+}
+
+LineString* FeaturePool::acquireLineString(unsigned int capacity)
+{
+    while (!_lines.empty()) {
+        osg::ref_ptr<LineString> line = _lines.back();
+        _lines.pop_back();
+        //分量仍被其他MultiGeometry引用时放弃复用
+        if (line->referenceCount() > 1)
+            continue;
+        line->clear();
+        line->reserve(capacity);
+        return line.release();
+    }
+    return new LineString(capacity);
+}
+
+void FeaturePool::releaseComponents(MultiGeometry* multiGeom, unsigned int first)
+{
+    if (multiGeom == NULL)
+        return;
+    GeometryCollection& parts = multiGeom->getComponents();
+    if (first >= parts.size())
+        return;
+    for (auto it = parts.begin() + first; it != parts.end(); ++it) {
+        LineString* line = dynamic_cast<LineString*>(it->get());
+        if (line && _lines.size() < _maxLines)
+            _lines.push_back(line);
+    }
+    parts.resize(first);
+}
+
+Geometry* FeaturePool::createGeometry(Geometry::Type type)
+{
+    switch (type) {
+    case Geometry::TYPE_POINTSET:
+        return new PointSet;
+    case Geometry::TYPE_LINESTRING:
+        return new LineString;
+    case Geometry::TYPE_RING:
+        return new Ring;
+    case Geometry::TYPE_MULTI:
+        return new MultiGeometry;
+    case Geometry::TYPE_POLYGON:
+    default:
+        return new Polygon;
+    }
+}
+
+void FeaturePool::resetGeometry(Geometry* geom)
+{
+    geom->clear();
+    if (geom->getType() == Geometry::TYPE_MULTI) {
+        instance()->releaseComponents(static_cast<MultiGeometry*>(geom));
+    } else if (geom->getType() == Geometry::TYPE_POLYGON) {
+        static_cast<Polygon*>(geom)->getHoles().clear();
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef FEATUREPOOL_H
+#define FEATUREPOOL_H 1
+
+#include <osgEarth/MapNode>
+#include <osgEarthAnnotation/FeatureNode>
+#include <osgEarthSymbology/Geometry>
+#include <osgEarthSymbology/Style>
+#include <vector>
+
+/**
+ * FeatureNode/Feature/Geometry对象池
+ * 绘制工具的预览要素和MultiGeometry分量统一从这里获取，
+ * 回收的对象在不再被场景和撤销栈引用后重置复用，使连续绘制时的内存分配保持平稳。
+ */
+class FeaturePool {
+public:
+    static FeaturePool* instance();
+
+    /**
+     * 获取一个几何类型为type的要素节点
+     * 复用的节点几何已清空、样式已重置，与新建节点等价
+     * @param mapNode 地图节点
+     * @param type 几何类型（Polygon、LineString、MultiGeometry等）
+     * @param style 要素样式
+     * @return 要素节点（引用计数为0，由调用者持有）
+     */
+    osgEarth::Annotation::FeatureNode* acquire(osgEarth::MapNode* mapNode,
+        osgEarth::Symbology::Geometry::Type type, const osgEarth::Symbology::Style& style);
+
+    /**
+     * 回收要素节点
+     * 节点只有在脱离场景且没有其他引用（如撤销栈中的命令）时才会被复用
+     */
+    void release(osgEarth::Annotation::FeatureNode* node);
+
+    /**
+     * 获取一条折线，用作MultiGeometry的分量
+     * @param capacity 预留的点数
+     */
+    osgEarth::Symbology::LineString* acquireLineString(unsigned int capacity);
+
+    // 回收MultiGeometry从first开始的分量，并从MultiGeometry中移除
+    void releaseComponents(osgEarth::Symbology::MultiGeometry* multiGeom, unsigned int first = 0);
+
+private:
+    FeaturePool();
+    FeaturePool(const FeaturePool&);
+    FeaturePool& operator=(const FeaturePool&);
+
+    static osgEarth::Symbology::Geometry* createGeometry(osgEarth::Symbology::Geometry::Type type);
+    static void resetGeometry(osgEarth::Symbology::Geometry* geom);
+
+    // 池中最多保留的对象数，超出的对象直接释放
+    unsigned int _maxNodes;
+    unsigned int _maxLines;
+    std::vector<osg::ref_ptr<osgEarth::Annotation::FeatureNode> > _nodes;
+    std::vector<osg::ref_ptr<osgEarth::Symbology::LineString> > _lines;
+};
+
+#endif
@@ -0,0 +1,548 @@
+#include "GenerationService.h"
+#include "PlottingWrap.h"
+#include "SymbolTypeRegistry.h"
+#include <osg/Timer>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#define SHUTDOWN_BOTH SD_BOTH
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define SHUTDOWN_BOTH SHUT_RDWR
+#endif
+
+namespace {
+
+// 单个请求最多的控制点数
+const long MAX_CONTROL_POINTS = 10000;
+// 没有换行的请求最长的字节数，超过时断开连接
+const size_t MAX_LINE_LENGTH = 1 << 20;
+// 每个连接已读入、应答尚未发出的请求数上限，达到时暂停读取
+const unsigned int MAX_PENDING_RESPONSES = 1024;
+// accept失败后的最长等待，毫秒
+const unsigned int MAX_ACCEPT_BACKOFF = 1000;
+// 对端已关闭时send返回错误，而不是触发SIGPIPE结束进程
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+void initSockets()
+{
+#ifdef _WIN32
+    static bool initialized = false;
+    if (!initialized) {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+        initialized = true;
+    }
+#endif
+}
+
+void closeSocket(SocketHandle s)
+{
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+// 关闭Nagle算法，小的应答立即发出
+void setNoDelay(SocketHandle s)
+{
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+}
+
+bool sendAll(SocketHandle s, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(s, data.data() + sent, (int)(data.size() - sent), SEND_FLAGS);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+sockaddr_in loopbackAddress(unsigned short port)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+// 按行读取套接字
+class LineReader {
+public:
+    explicit LineReader(SocketHandle s) : _socket(s), _pos(0) {}
+
+    bool readLine(std::string& line)
+    {
+        for (;;) {
+            size_t end = _buffer.find('\n', _pos);
+            if (end != std::string::npos) {
+                line.assign(_buffer, _pos, end - _pos);
+                _pos = end + 1;
+                return true;
+            }
+            _buffer.erase(0, _pos);
+            _pos = 0;
+            if (_buffer.size() > MAX_LINE_LENGTH)
+                return false;
+            char chunk[65536];
+            int n = recv(_socket, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                return false;
+            _buffer.append(chunk, n);
+        }
+    }
+
+private:
+    SocketHandle _socket;
+    std::string _buffer;
+    size_t _pos;
+};
+
+}
+
+struct GenerationService::Connection {
+    explicit Connection(SocketHandle s) : socket(s), pending(0), queued(0), readerDone(false), failed(false) {}
+    // 最后一个引用（读写线程或未处理的请求）释放时关闭
+    ~Connection() { closeSocket(socket); }
+
+    SocketHandle socket;
+    std::mutex mutex;
+    std::condition_variable changed; // 以下状态变化时通知
+    std::string outbox; // 待发送的应答
+    unsigned int pending; // 已读入、应答尚未发出的请求数
+    unsigned int queued; // outbox中的应答数
+    bool readerDone; // 读线程已结束，不再有新请求
+    bool failed; // 发送失败，对端已断开
+};
+
+GenerationService::GenerationService(unsigned short port, unsigned int numWorkers, unsigned int maxBatch, unsigned int queueCapacity,
+    unsigned int maxConnections)
+    : _port(port)
+    , _numWorkers(numWorkers ? numWorkers : osg::maximum(std::thread::hardware_concurrency(), 1u))
+    , _maxBatch(osg::maximum(maxBatch, 1u))
+    , _queueCapacity(osg::maximum(queueCapacity, 1u))
+    , _maxConnections(osg::maximum(maxConnections, 1u))
+    , _geodesicSegment(0.0)
+    , _numConnections(0)
+{
+}
+
+bool GenerationService::run(std::ostream& log)
+{
+    initSockets();
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        log << "Failed to create socket" << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    sockaddr_in addr = loopbackAddress(_port);
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        log << "Failed to listen on 127.0.0.1:" << _port << std::endl;
+        closeSocket(listener);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < _numWorkers; i++)
+        std::thread(&GenerationService::work, this).detach();
+    log << "Serving symbol outlines on 127.0.0.1:" << _port << " with " << _numWorkers << " workers, batches of "
+        << _maxBatch << ", queue capacity " << _queueCapacity << ", at most " << _maxConnections << " connections" << std::endl;
+
+    unsigned int backoff = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_connectionMutex);
+            while (_numConnections >= _maxConnections)
+                _connectionClosed.wait(lock);
+        }
+        SocketHandle s = accept(listener, NULL, NULL);
+        if (s == INVALID_SOCKET) {
+            // 文件描述符耗尽等错误会连续出现，等待后重试
+            backoff = backoff ? osg::minimum(backoff * 2, MAX_ACCEPT_BACKOFF) : 10;
+            std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+            continue;
+        }
+        backoff = 0;
+        setNoDelay(s);
+        {
+            std::lock_guard<std::mutex> lock(_connectionMutex);
+            _numConnections++;
+        }
+        std::thread(&GenerationService::serveConnection, this, std::make_shared<Connection>(s)).detach();
+    }
+}
+
+void GenerationService::serveConnection(std::shared_ptr<Connection> connection)
+{
+    std::thread writer(&GenerationService::sendResponses, this, connection);
+    LineReader reader(connection->socket);
+    std::string line;
+    bool failed = false;
+    while (!failed && reader.readLine(line)) {
+        if (!line.empty() && line[line.size()-1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty())
+            continue;
+        Request request;
+        request.connection = connection;
+        if (!parse(line, request))
+            request.status = STATUS_BAD_REQUEST;
+        {
+            // 客户端不读取应答时停止读取请求
+            std::unique_lock<std::mutex> lock(connection->mutex);
+            while (connection->pending >= MAX_PENDING_RESPONSES && !connection->failed)
+                connection->changed.wait(lock);
+            failed = connection->failed;
+            connection->pending++;
+        }
+        if (!failed)
+            push(request);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->readerDone = true;
+    }
+    connection->changed.notify_all();
+    writer.join();
+
+    {
+        std::lock_guard<std::mutex> lock(_connectionMutex);
+        _numConnections--;
+    }
+    _connectionClosed.notify_one();
+}
+
+void GenerationService::sendResponses(std::shared_ptr<Connection> connection)
+{
+    std::string data;
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    for (;;) {
+        // 读线程结束后发完已读入请求的应答再退出
+        while (connection->outbox.empty() && !(connection->readerDone && connection->pending == 0))
+            connection->changed.wait(lock);
+        if (connection->outbox.empty())
+            break;
+        data.swap(connection->outbox);
+        unsigned int count = connection->queued;
+        connection->queued = 0;
+        lock.unlock();
+        bool sent = sendAll(connection->socket, data);
+        data.clear();
+        lock.lock();
+        connection->pending -= count;
+        if (!sent) {
+            // 对端已断开，唤醒读线程结束
+            connection->failed = true;
+            shutdown(connection->socket, SHUTDOWN_BOTH);
+            connection->changed.notify_all();
+            break;
+        }
+        connection->changed.notify_all();
+    }
+}
+
+void GenerationService::push(Request& request)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_queue.size() >= _queueCapacity)
+        _notFull.wait(lock);
+    _queue.push_back(Request());
+    std::swap(_queue.back(), request);
+    lock.unlock();
+    _notEmpty.notify_one();
+}
+
+void GenerationService::pop(std::vector<Request>& batch)
+{
+    batch.clear();
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_queue.empty())
+        _notEmpty.wait(lock);
+    unsigned int count = osg::minimum((unsigned int)_queue.size(), _maxBatch);
+    batch.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        std::swap(batch[i], _queue.front());
+        _queue.pop_front();
+    }
+    lock.unlock();
+    _notFull.notify_all();
+}
+
+void GenerationService::work()
+{
+    std::vector<Request> batch;
+    std::vector<unsigned int> order;
+    std::map<Connection*, std::pair<std::string, unsigned int> > responses;
+    Math::MultiLineString outline;
+    for (;;) {
+        pop(batch);
+
+        // 同一类型的请求连续计算
+        order.resize(batch.size());
+        for (unsigned int i = 0; i < batch.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&batch](unsigned int a, unsigned int b) {
+            return batch[a].type < batch[b].type;
+        });
+
+        responses.clear();
+        for (unsigned int k = 0; k < order.size(); k++) {
+            Request& request = batch[order[k]];
+            outline.clear();
+            bool closed = false;
+            if (request.status == STATUS_OK) {
+                const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(request.type);
+                unsigned int n = request.controlPoints.size();
+                if (!symbolType || !symbolType->outline)
+                    request.status = STATUS_UNKNOWN_TYPE;
+                else if (n < symbolType->minControlPoints || (symbolType->maxControlPoints && n > symbolType->maxControlPoints))
+                    request.status = STATUS_BAD_CONTROL_POINTS;
+                else {
+                    // 切分前只有一部分的外形是多边形，切分后要靠应答中的标志区分
+                    outline = Math::generateOutline(symbolType->outline, request.controlPoints, false, &_geodesic, _geodesicSegment);
+                    closed = outline.size() == 1;
+                    Math::splitAtAntimeridian(outline, closed);
+                }
+            }
+            std::pair<std::string, unsigned int>& response = responses[request.connection.get()];
+            format(request, outline, closed, response.first);
+            response.second++;
+        }
+
+        // 每个连接的应答合并后交给它的写线程，已断开的连接丢弃应答
+        for (std::map<Connection*, std::pair<std::string, unsigned int> >::iterator it = responses.begin(); it != responses.end(); ++it) {
+            Connection* connection = it->first;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                if (connection->failed)
+                    continue;
+                connection->outbox += it->second.first;
+                connection->queued += it->second.second;
+            }
+            connection->changed.notify_all();
+        }
+        batch.clear();
+    }
+}
+
+bool GenerationService::parse(const std::string& line, Request& request)
+{
+    const char* p = line.c_str();
+    while (*p == ' ' || *p == '\t')
+        p++;
+    const char* idEnd = p;
+    while (*idEnd && *idEnd != ' ' && *idEnd != '\t')
+        idEnd++;
+    request.id.assign(p, idEnd);
+    request.type = -1;
+    request.status = STATUS_OK;
+    if (request.id.empty())
+        return false;
+
+    char* end;
+    long type = strtol(idEnd, &end, 10);
+    if (end == idEnd)
+        return false;
+    p = end;
+    long n = strtol(p, &end, 10);
+    if (end == p || n < 0 || n > MAX_CONTROL_POINTS)
+        return false;
+    p = end;
+    request.type = (int)type;
+    request.controlPoints.resize(n);
+    for (long i = 0; i < n; i++) {
+        float x = strtof(p, &end);
+        if (end == p)
+            return false;
+        p = end;
+        float y = strtof(p, &end);
+        if (end == p)
+            return false;
+        p = end;
+        request.controlPoints[i].set(x, y);
+    }
+    return true;
+}
+
+void GenerationService::format(const Request& request, const Math::MultiLineString& outline, bool closed, std::string& out)
+{
+    char buffer[64];
+    out += request.id;
+    snprintf(buffer, sizeof(buffer), " %d %d %u", (int)request.status, closed ? 1 : 0, (unsigned int)outline.size());
+    out += buffer;
+    for (unsigned int l = 0; l < outline.size(); l++) {
+        const Math::LineString& line = outline[l];
+        snprintf(buffer, sizeof(buffer), " %u", (unsigned int)line.size());
+        out += buffer;
+        for (unsigned int i = 0; i < line.size(); i++) {
+            snprintf(buffer, sizeof(buffer), " %.9g %.9g", line[i].x(), line[i].y());
+            out += buffer;
+        }
+    }
+    out += '\n';
+}
+
+GenerationLoadTest::GenerationLoadTest(unsigned short port, unsigned int connections, unsigned int window, double seconds)
+    : _port(port)
+    , _connections(osg::maximum(connections, 1u))
+    , _window(osg::maximum(window, 1u))
+    , _seconds(seconds)
+{
+}
+
+bool GenerationLoadTest::run(std::ostream& log)
+{
+    initSockets();
+    std::vector<Result> results(_connections);
+    std::vector<std::thread> threads;
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    for (unsigned int i = 0; i < _connections; i++)
+        threads.push_back(std::thread(&GenerationLoadTest::runConnection, this, i, std::ref(results[i])));
+    for (unsigned int i = 0; i < threads.size(); i++)
+        threads[i].join();
+    double seconds = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+
+    std::vector<double> latencies;
+    unsigned int requests = 0, errors = 0, connected = 0;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        latencies.insert(latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+        requests += results[i].requests;
+        errors += results[i].errors;
+        connected += results[i].connected ? 1 : 0;
+    }
+    if (connected < _connections)
+        log << (_connections - connected) << " of " << _connections << " connections to 127.0.0.1:" << _port << " failed" << std::endl;
+    if (latencies.empty())
+        return false;
+
+    std::sort(latencies.begin(), latencies.end());
+    const double ps[3] = { 0.5, 0.99, 0.999 };
+    double values[3];
+    for (int k = 0; k < 3; k++)
+        values[k] = latencies[osg::minimum((size_t)(ps[k] * latencies.size()), latencies.size() - 1)];
+    log << std::fixed << std::setprecision(3)
+        << requests << " requests on " << connected << " connections (window " << _window << ") in " << seconds << " s: "
+        << requests / seconds << " requests/s" << std::endl
+        << "latency p50 " << values[0] << " ms, p99 " << values[1] << " ms, p99.9 " << values[2]
+        << " ms, max " << latencies.back() << " ms" << std::endl;
+    if (errors)
+        log << errors << " responses with errors" << std::endl;
+    return connected == _connections && errors == 0;
+}
+
+void GenerationLoadTest::runConnection(unsigned int index, Result& result)
+{
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET)
+        return;
+    sockaddr_in addr = loopbackAddress(_port);
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        closeSocket(s);
+        return;
+    }
+    setNoDelay(s);
+    result.connected = true;
+
+    // 只请求有外形函数的符号，控制点范围与KernelCheck相同
+    std::vector<const SymbolType*> types;
+    const std::vector<SymbolType>& allTypes = SymbolTypeRegistry::instance()->getTypes();
+    for (unsigned int i = 0; i < allTypes.size(); i++) {
+        if (allTypes[i].outline)
+            types.push_back(&allTypes[i]);
+    }
+    if (types.empty()) {
+        closeSocket(s);
+        return;
+    }
+
+    unsigned int state = index * 2654435761u + 1;
+    auto random = [&state](float min, float max) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return min + (max - min) * (float)(state & 0xffffff) / (float)0x1000000;
+    };
+
+    // 请求的发送时间，以id为下标
+    std::vector<osg::Timer_t> sent;
+    osg::Timer* timer = osg::Timer::instance();
+    const osg::Timer_t start = timer->tick();
+    std::string requests;
+    char buffer[64];
+    unsigned int outstanding = 0;
+    bool sending = true;
+    LineReader reader(s);
+    std::string line;
+    while (sending || outstanding > 0) {
+        // 补足窗口内的请求，一次发出
+        requests.clear();
+        while (sending && outstanding < _window) {
+            const SymbolType* type = types[(unsigned int)random(0.0f, (float)types.size()) % types.size()];
+            unsigned int minPoints = osg::maximum(type->minControlPoints, 1u);
+            unsigned int maxPoints = type->maxControlPoints ? type->maxControlPoints : minPoints + 6;
+            unsigned int count = osg::minimum(minPoints + (unsigned int)random(0.0f, (float)(maxPoints - minPoints + 1)), maxPoints);
+            snprintf(buffer, sizeof(buffer), "%u %d %u", (unsigned int)sent.size(), type->type, count);
+            requests += buffer;
+            osg::Vec2 center(random(-170.0f, 170.0f), random(-70.0f, 70.0f));
+            float extent = random(0.01f, 5.0f);
+            for (unsigned int k = 0; k < count; k++) {
+                snprintf(buffer, sizeof(buffer), " %.6f %.6f",
+                         center.x() + random(-extent, extent), center.y() + random(-extent, extent));
+                requests += buffer;
+            }
+            requests += '\n';
+            sent.push_back(timer->tick());
+            outstanding++;
+        }
+        if (!requests.empty() && !sendAll(s, requests))
+            break;
+
+        if (!reader.readLine(line))
+            break;
+        osg::Timer_t now = timer->tick();
+        unsigned int id = 0, status = 0;
+        if (sscanf(line.c_str(), "%u %u", &id, &status) != 2 || id >= sent.size()) {
+            result.errors++;
+        } else {
+            result.latencies.push_back(timer->delta_m(sent[id], now));
+            if (status != GenerationService::STATUS_OK)
+                result.errors++;
+        }
+        result.requests++;
+        outstanding--;
+        if (timer->delta_s(start, now) >= _seconds)
+            sending = false;
+    }
+    closeSocket(s);
+}
@@ -0,0 +1,125 @@
+#ifndef GENERATIONSERVICE_H
+#define GENERATIONSERVICE_H 1
+
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "PlottingMath.h"
+#include "PlottingGeodesic.h"
+
+/**
+ * 本机的符号外形生成服务
+ * 监听127.0.0.1上的TCP端口，其他进程按行发送请求，服务用注册表中的外形函数计算后按行返回：
+ *   请求  id type n x1 y1 ... xn yn
+ *   应答  id status closed numLines n x1 y1 ... （每条折线一组）
+ * status为0成功，1符号类型未注册或没有外形函数，2控制点数不符，3请求格式错误。
+ * 外形在日期变更线处切分，经度都在[-180, 180]内；closed为1时各折线是同一个多边形外环切分后的各部分，
+ * 为0时是独立的折线，不能再按折线数判断是否为多边形。
+ * 一个连接上可以连续发送多个请求而不必等待应答，应答不保证按请求顺序，以id对应。
+ *
+ * 每个连接一个读线程和一个写线程。读线程解析后放入有界队列；队列满，或本连接未发出的应答达到上限时，
+ * 读线程阻塞，不再读取套接字，由TCP的流量控制把压力传回客户端。工作线程每次取出队列中已有的全部请求
+ * （最多maxBatch个），按符号类型排序后成批计算，应答追加到各连接的发送队列后立即返回，
+ * 由连接的写线程发出，读取缓慢的客户端不会阻塞工作线程和其他连接。
+ * 连接数达到上限时暂停accept，新连接留在监听队列中。
+ */
+class GenerationService {
+public:
+    /**
+     * @param port 监听端口
+     * @param numWorkers 工作线程数，为0时取硬件线程数
+     * @param maxBatch 每批最多的请求数
+     * @param queueCapacity 队列容量
+     * @param maxConnections 同时服务的连接数
+     */
+    GenerationService(unsigned short port, unsigned int numWorkers = 0, unsigned int maxBatch = 64, unsigned int queueCapacity = 4096,
+        unsigned int maxConnections = 64);
+
+    // 大地线模式：外形的各边加密为WGS84上的大地线，相邻点不超过meters米；为0时关闭。在run之前调用
+    void setGeodesicSegment(double meters) { _geodesicSegment = meters; }
+
+    // 监听并处理请求，只在监听失败时返回false
+    bool run(std::ostream& log);
+
+    enum Status {
+        STATUS_OK,
+        STATUS_UNKNOWN_TYPE,
+        STATUS_BAD_CONTROL_POINTS,
+        STATUS_BAD_REQUEST,
+    };
+
+private:
+    struct Connection;
+    struct Request {
+        std::shared_ptr<Connection> connection;
+        std::string id;
+        int type;
+        std::vector<osg::Vec2> controlPoints;
+        Status status;
+    };
+
+    void serveConnection(std::shared_ptr<Connection> connection);
+    void sendResponses(std::shared_ptr<Connection> connection);
+    void work();
+
+    // 队列满时阻塞
+    void push(Request& request);
+    // 取出至多_maxBatch个请求，队列为空时阻塞
+    void pop(std::vector<Request>& batch);
+
+    static bool parse(const std::string& line, Request& request);
+    static void format(const Request& request, const Math::MultiLineString& outline, bool closed, std::string& out);
+
+    unsigned short _port;
+    unsigned int _numWorkers;
+    unsigned int _maxBatch;
+    unsigned int _queueCapacity;
+    unsigned int _maxConnections;
+    Math::Geodesic _geodesic;
+    double _geodesicSegment;
+
+    std::mutex _connectionMutex;
+    std::condition_variable _connectionClosed;
+    unsigned int _numConnections;
+
+    std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::deque<Request> _queue;
+};
+
+/**
+ * 生成服务的压力测试
+ * 打开多个连接，每个连接保持window个未完成的请求，请求的符号类型和控制点随机生成，
+ * 持续指定时间后报告吞吐量和应答延迟的p50、p99、p99.9。
+ */
+class GenerationLoadTest {
+public:
+    GenerationLoadTest(unsigned short port, unsigned int connections = 4, unsigned int window = 32, double seconds = 10.0);
+
+    // 有连接失败或应答出错时返回false
+    bool run(std::ostream& log);
+
+private:
+    struct Result {
+        Result() : requests(0), errors(0), connected(false) {}
+        std::vector<double> latencies; // 毫秒
+        unsigned int requests;
+        unsigned int errors;
+        bool connected;
+    };
+
+    void runConnection(unsigned int index, Result& result);
+
+    unsigned short _port;
+    unsigned int _connections;
+    unsigned int _window;
+    double _seconds;
+};
+
+#endif
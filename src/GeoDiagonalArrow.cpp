@@ -1,5 +1,6 @@
 
 #include "GeoDiagonalArrow.h"
+#include "DrawProfiler.h"
 #include "PlottingMath.h"
 
 using namespace osgEarth;
@@ -39,24 +40,15 @@ void GeoDiagonalArrow::beginDraw(const osg::Vec3d &lla)
         return;
     if (_controlPoints.size() == 2 && _controlPoints[0]==_controlPoints[1])
         return;
-     _drawParts.clear();
-     if (_controlPoints.size() == 2)
-         _drawParts = calculateTwoPoints(_controlPoints);
-     else
-         _drawParts = calculateMorePoints(_controlPoints);
-
      if (!_featureNode.valid()) {
-          Feature* feature = new Feature(new Polygon, getMapNode()->getMapSRS(), _polygonStyle);
-         _featureNode = new FeatureNode(getMapNode(), feature);
+          _featureNode = acquireFeatureNode(Geometry::TYPE_POLYGON, _polygonStyle);
           drawCommand(_featureNode);
      }
 
      Geometry* geom = _featureNode->getFeature()->getGeometry();
-     geom->clear();
-     for (auto& n : _drawParts) {
-         geom->push_back(osg::Vec3(n.x(), n.y(), 0));
-     }
-     _featureNode->init();
+     calculateGeometry(_controlPoints, _ratio, geom);
+     densifyGeodesic(geom, true);
+     buildNode(_featureNode);
 }
 
 void GeoDiagonalArrow::moveDraw(const osg::Vec3d &lla)
@@ -64,27 +56,20 @@ void GeoDiagonalArrow::moveDraw(const osg::Vec3d &lla)
     if (_controlPoints.empty())
         return;
     if (!_featureNode.valid()) {
-         Feature* feature = new Feature(new Polygon, getMapNode()->getMapSRS(), _polygonStyle);
-        _featureNode = new FeatureNode(getMapNode(), feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_POLYGON, _polygonStyle);
         drawCommand(_featureNode);
     }
 
     if (_featureNode.valid()) {
         std::vector<osg::Vec2> ctrlPts = _controlPoints;
-        std::vector<osg::Vec2> drawPts;
         ctrlPts.push_back(osg::Vec2(lla.x(), lla.y()));
 
-        if (ctrlPts.size() == 2)
-            drawPts = calculateTwoPoints(ctrlPts);
-        else
-            drawPts = calculateMorePoints(ctrlPts);
-
         Geometry* geom = _featureNode->getFeature()->getGeometry();
-        geom->clear();
-        for (auto& n : drawPts) {
-            geom->push_back(osg::Vec3(n.x(), n.y(), 0));
-        }
-        _featureNode->init();
+        calculateGeometry(ctrlPts, _ratio, geom);
+        densifyGeodesic(geom, true);
+        clipForDisplay(geom);
+        simplifyForDisplay(geom, true);
+        buildNode(_featureNode);
     }
 }
 
@@ -99,19 +84,35 @@ void GeoDiagonalArrow::resetDraw()
     _featureNode = NULL;
 }
 
-std::vector<osg::Vec2> GeoDiagonalArrow::calculateTwoPoints(const std::vector<osg::Vec2> &ctrlPts)
+void GeoDiagonalArrow::finishDraw()
 {
+    if (!_featureNode.valid())
+        return;
+    //节点上是最后一次移动的预览，由控制点重建完整精度的外形
+    Geometry* geom = _featureNode->getFeature()->getGeometry();
+    if (_controlPoints.size() > 2 || (_controlPoints.size() == 2 && _controlPoints[0] != _controlPoints[1])) {
+        calculateGeometry(_controlPoints, _ratio, geom);
+        densifyGeodesic(geom, true);
+    } else {
+        geom->clear();
+    }
+    buildNode(_featureNode);
+}
+
+std::vector<osg::Vec2> GeoDiagonalArrow::calculateTwoPoints(const std::vector<osg::Vec2> &ctrlPts, float ratio)
+{
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoDiagonalArrow::calculateTwoPoints");
     //取出首尾两个点
     osg::Vec2 pointS = ctrlPts[0];
     osg::Vec2 pointE = ctrlPts[1];
     //计算箭头总长度
     float l = sqrtf((pointE.y()-pointS.y())*(pointE.y()-pointS.y())+(pointE.x()-pointS.x())*(pointE.x()-pointS.x()));
     //计算直箭头的宽
-    float w = l/_ratio;
+    float w = l/ratio;
 
     //计算三角形的底边中心点坐标
-    float x_ = pointS.x() + (pointE.x() - pointS.x())*(_ratio-1)/_ratio;
-    float y_ = pointS.y() + (pointE.y() - pointS.y())*(_ratio-1)/_ratio;
+    float x_ = pointS.x() + (pointE.x() - pointS.x())*(ratio-1)/ratio;
+    float y_ = pointS.y() + (pointE.y() - pointS.y())*(ratio-1)/ratio;
     osg::Vec2 point_o(x_, y_);
 
     //计算
@@ -125,8 +126,8 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateTwoPoints(const std::vector<os
     //获取右边尾部点
     osg::Vec2 point_r(v_r_.x()+pointS.x(), v_r_.y()+pointS.y());
 
-    osg::Vec2 point_h_l(v_l_.x()/_ratio+x_, v_l_.y()/_ratio+y_);
-    osg::Vec2 point_h_r(v_r_.x()/_ratio+x_, v_r_.y()/_ratio+y_);
+    osg::Vec2 point_h_l(v_l_.x()/ratio+x_, v_l_.y()/ratio+y_);
+    osg::Vec2 point_h_r(v_r_.x()/ratio+x_, v_r_.y()/ratio+y_);
 
     //计算三角形左边点
     osg::Vec2 point_a_l((point_h_l.x()*2-point_h_r.x()), point_h_l.y()*2-point_h_r.y());
@@ -136,8 +137,9 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateTwoPoints(const std::vector<os
 
 }
 
-std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<osg::Vec2> &ctrlPts)
+std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<osg::Vec2> &ctrlPts, float ratio)
 {
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoDiagonalArrow::calculateMorePoints");
     //计算箭头总长度
     float l = 0;
     //计算直箭头的宽
@@ -148,7 +150,7 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<o
         osg::Vec2 pointE = ctrlPts[i+1];
         l += sqrtf((pointE.y()-pointS.y())*(pointE.y()-pointS.y())+(pointE.x()-pointS.x())*(pointE.x()-pointS.x()));
     }
-    w = l/_ratio;
+    w = l/ratio;
     float a = atanf(w/(2.0*l));
 
     //定义左右控制点集合
@@ -232,8 +234,8 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<o
         //获取三角形左右两个向量
         v_l_t = point_lr_t[0];
         v_r_t = point_lr_t[1];
-        point_h_l = osg::Vec2(v_l_t.x()/_ratio+pointU_E2.x(), v_l_t.y()/_ratio+pointU_E2.y());
-        point_h_r = osg::Vec2(v_r_t.x()/_ratio+pointU_E2.x(), v_r_t.y()/_ratio+pointU_E2.y());
+        point_h_l = osg::Vec2(v_l_t.x()/ratio+pointU_E2.x(), v_l_t.y()/ratio+pointU_E2.y());
+        point_h_r = osg::Vec2(v_r_t.x()/ratio+pointU_E2.x(), v_r_t.y()/ratio+pointU_E2.y());
         //计算三角形的左右两点
         point_triangle_l = osg::Vec2(point_h_l.x()*2-point_h_r.x(), point_h_l.y()*2-point_h_r.y());
         point_triangle_r = osg::Vec2(point_h_r.x()*2-point_h_l.x(), point_h_r.y()*2-point_h_l.y());
@@ -260,8 +262,8 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<o
         v_l_t = point_lr_t[0];
         v_r_t = point_lr_t[1];
 
-        point_h_l = osg::Vec2(v_l_t.x()/_ratio+point_c.x(), v_l_t.y()/_ratio+point_c.y());
-        point_h_r = osg::Vec2(v_r_t.x()/_ratio+point_c.x(), v_r_t.y()/_ratio+point_c.y());
+        point_h_l = osg::Vec2(v_l_t.x()/ratio+point_c.x(), v_l_t.y()/ratio+point_c.y());
+        point_h_r = osg::Vec2(v_r_t.x()/ratio+point_c.x(), v_r_t.y()/ratio+point_c.y());
 
         //计算三角形的左右两点
         point_triangle_l = osg::Vec2(point_h_l.x()*2-point_h_r.x(), point_h_l.y()*2-point_h_r.y());
@@ -300,3 +302,17 @@ std::vector<osg::Vec2> GeoDiagonalArrow::calculateMorePoints(const std::vector<o
     pointsR.push_back(point_t_r);
     return pointsR;
 }
+
+void GeoDiagonalArrow::calculateGeometry(const std::vector<osg::Vec2>& ctrlPts, float ratio, Geometry* geom)
+{
+    setGeometryPoints(geom, ctrlPts.size() == 2 ? calculateTwoPoints(ctrlPts, ratio) : calculateMorePoints(ctrlPts, ratio));
+}
+
+Math::MultiLineString GeoDiagonalArrow::calculateOutline(const std::vector<osg::Vec2>& ctrlPts)
+{
+    Math::MultiLineString outline;
+    if (ctrlPts.size() < 2)
+        return outline;
+    outline.push_back(ctrlPts.size() == 2 ? calculateTwoPoints(ctrlPts) : calculateMorePoints(ctrlPts));
+    return outline;
+}
@@ -17,19 +17,25 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void finishDraw();
 
     /**
      * @brief 只有两个控制点时
      * @param ctrlPts
      * @return
      */
-    std::vector<osg::Vec2> calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts);
+    static std::vector<osg::Vec2> calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts, float ratio = 6.0);
     /**
      * @brief 有三个或三个以上的控制点时
      * @param ctrlPts
      * @return
      */
-    std::vector<osg::Vec2> calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts);
+    static std::vector<osg::Vec2> calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts, float ratio = 6.0);
+
+    // 由控制点计算斜箭头外形，供注册表批量生成使用
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts);
+    // 由控制点计算斜箭头的绘制点，结果直接写入几何geom
+    static void calculateGeometry(const std::vector<osg::Vec2>& ctrlPts, float ratio, osgEarth::Symbology::Geometry* geom);
 
 
 private:
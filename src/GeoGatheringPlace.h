@@ -17,13 +17,19 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void finishDraw();
 
     /**
     * Method: calculateParts
     * 重写了父类的方法
     * 用于通过控制点计算聚集地符号的所有点
     */
-    std::vector<osg::Vec2> calculateParts(const std::vector<osg::Vec2>& controlPoints);
+    static std::vector<osg::Vec2> calculateParts(const std::vector<osg::Vec2>& controlPoints);
+
+    // 由控制点计算聚集地外形，供注册表批量生成使用
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts);
+    // 由控制点计算聚集地的绘制点，结果直接写入几何geom
+    static void calculateGeometry(const std::vector<osg::Vec2>& controlPoints, osgEarth::Symbology::Geometry* geom);
 
 private:
     osgEarth::Symbology::Style _polygonStyle;
@@ -15,8 +15,14 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void finishDraw();
 
-    std::vector<osg::Vec2> calculateParts(const std::vector<osg::Vec2>& ctrlPts);
+    static std::vector<osg::Vec2> calculateParts(const std::vector<osg::Vec2>& ctrlPts, float sides = 360);
+
+    // 由控制点计算弓形外形，供注册表批量生成使用
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts);
+    // 由控制点计算弓形的绘制点，结果直接写入几何geom
+    static void calculateGeometry(const std::vector<osg::Vec2>& ctrlPts, float sides, osgEarth::Symbology::Geometry* geom);
 
 private:
     osgEarth::Symbology::Style _polygonStyle;
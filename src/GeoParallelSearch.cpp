@@ -1,4 +1,5 @@
 #include "GeoParallelSearch.h"
+#include "DrawProfiler.h"
 
 using namespace osgEarth;
 using namespace osgEarth::Symbology;
@@ -34,36 +35,21 @@ void GeoParallelSearch::beginDraw(const osg::Vec3d &lla)
     if (_controlPoints.empty() || _controlPoints.size() < 2)
         return;
 
-    multiLine_.clear();
-
-    multiLine_ = calculateParts(_controlPoints);
+    calculateParts(_controlPoints, multiLine_);
+    densifyGeodesic(multiLine_);
 
     if (!_featureNode.valid()) {
-        Feature* feature = new Feature(new MultiGeometry, getMapNode()->getMapSRS(), _lineStyle);
-        _featureNode = new FeatureNode(getMapNode(), feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_MULTI, _lineStyle);
         //        _drawGroup->addChild(_featureNode);
         drawCommand(_featureNode);
     }
 
     MultiGeometry* multiGeom = dynamic_cast<MultiGeometry*>(_featureNode->getFeature()->getGeometry());
-    multiGeom->getComponents().clear();
+    //提交的外形总是重建：与最后一次预览相同时也要去掉预览的裁剪并挂接显示LOD
     if (multiGeom) {
-        for (unsigned int i =0; i < multiLine_.size(); i++) {
-            if (multiLine_[i].size() <= 2) {
-                Geometry* seg = new LineString(2);
-                seg->push_back(osg::Vec3(multiLine_[i][0].x(), multiLine_[i][0].y(), 0));
-                seg->push_back(osg::Vec3(multiLine_[i][1].x(), multiLine_[i][1].y(), 0));
-                multiGeom->add(seg);
-            } else {
-                Geometry* seg = new LineString(multiLine_[i].size());
-                for (unsigned int j = 0; j < multiLine_[i].size(); j++) {
-                    seg->push_back(osg::Vec3(multiLine_[i][j].x(), multiLine_[i][j].y(), 0));
-                }
-                multiGeom->add(seg);
-            }
-        }
+        updateMultiGeometry(multiGeom, multiLine_);
+        buildNode(_featureNode);
     }
-    _featureNode->init();
 }
 
 void GeoParallelSearch::moveDraw(const osg::Vec3d &lla)
@@ -71,34 +57,21 @@ void GeoParallelSearch::moveDraw(const osg::Vec3d &lla)
     if (_controlPoints.empty() || _controlPoints.size() < 1)
         return;
     if (!_featureNode.valid()) {
-        Feature* feature = new Feature(new MultiGeometry, getMapNode()->getMapSRS(), _lineStyle);
-        _featureNode = new FeatureNode(getMapNode(), feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_MULTI, _lineStyle);
         //        _drawGroup->addChild(_featureNode);
         drawCommand(_featureNode);
     }
-    std::vector<osg::Vec2> ctrlPts = _controlPoints;
-    ctrlPts.push_back(osg::Vec2(lla.x(), lla.y()));
-    Math::MultiLineString multiLine = calculateParts(ctrlPts);
+    _moveCtrlPts.assign(_controlPoints.begin(), _controlPoints.end());
+    _moveCtrlPts.push_back(osg::Vec2(lla.x(), lla.y()));
+    calculateParts(_moveCtrlPts, _moveParts);
+    Math::MultiLineString& multiLine = _moveParts;
+    densifyGeodesic(multiLine);
+    clipForDisplay(multiLine);
 
     MultiGeometry* multiGeom = dynamic_cast<MultiGeometry*>(_featureNode->getFeature()->getGeometry());
-    multiGeom->getComponents().clear();
-    if (multiGeom) {
-        for (unsigned int i =0; i < multiLine.size(); i++) {
-            if (multiLine[i].size() <= 2) {
-                Geometry* seg = new LineString(2);
-                seg->push_back(osg::Vec3(multiLine[i][0].x(), multiLine[i][0].y(), 0));
-                seg->push_back(osg::Vec3(multiLine[i][1].x(), multiLine[i][1].y(), 0));
-                multiGeom->add(seg);
-            } else {
-                Geometry* seg = new LineString(multiLine[i].size());
-                for (unsigned int j = 0; j < multiLine[i].size(); j++) {
-                    seg->push_back(osg::Vec3(multiLine[i][j].x(), multiLine[i][j].y(), 0));
-                }
-                multiGeom->add(seg);
-            }
-        }
+    if (multiGeom && updateMultiGeometry(multiGeom, multiLine)) {
+        buildNode(_featureNode);
     }
-    _featureNode->init();
 }
 
 void GeoParallelSearch::endDraw(const osg::Vec3d &lla)
@@ -112,10 +85,31 @@ void GeoParallelSearch::resetDraw()
     _featureNode = NULL;
 }
 
+void GeoParallelSearch::finishDraw()
+{
+    if (!_featureNode.valid())
+        return;
+    //节点上是最后一次移动的预览，由控制点重建完整精度的外形
+    calculateParts(_controlPoints, multiLine_);
+    densifyGeodesic(multiLine_);
+    MultiGeometry* multiGeom = dynamic_cast<MultiGeometry*>(_featureNode->getFeature()->getGeometry());
+    if (multiGeom) {
+        updateMultiGeometry(multiGeom, multiLine_);
+        buildNode(_featureNode);
+    }
+}
+
 
 Math::MultiLineString GeoParallelSearch::calculateParts(const std::vector<osg::Vec2> &controlPoints)
 {
     Math::MultiLineString multiLine;
+    calculateParts(controlPoints, multiLine);
+    return multiLine;
+}
+
+void GeoParallelSearch::calculateParts(const std::vector<osg::Vec2> &controlPoints, Math::MultiLineString &multiLine)
+{
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoParallelSearch::calculateParts");
     //两个控制点时，绘制直线
 //    if (controlPoints.size() > 1) {
 //        multiLine.push_back(controlPoints);
@@ -129,7 +123,10 @@ Math::MultiLineString GeoParallelSearch::calculateParts(const std::vector<osg::V
         osg::Vec2 vectorNormal = Math::calculateVector(vectorBase)[0];
         //从第三个点开始，当i为奇数，则第i-1、i个点的向量垂直于基准向量，当i为偶数，则第i-1、i个点的向量平行于垂直基准向量。
         bool isParalel = false;
-        std::vector<osg::Vec2> points;
+        //第0个分量为折线，之后每段两条箭头线
+        multiLine.resize(1 + 2 * (controlPoints.size() - 1));
+        Math::LineString& points = multiLine[0];
+        points.clear();
         points.push_back(firstP);
 
         for (int i = 1; i < controlPoints.size(); i++) {
@@ -142,18 +139,18 @@ Math::MultiLineString GeoParallelSearch::calculateParts(const std::vector<osg::V
                 osg::Vec2 point = Math::calculateIntersection(vectorNormal,vectorBase,pointI,previousP);
                 points.push_back(point);
                 Math::MultiLineString arrowLines = Math::calculateArrowLines(previousP,point,15);
-                multiLine.push_back(arrowLines[0]);
-                multiLine.push_back(arrowLines[1]);
+                multiLine[2 * i - 1] = arrowLines[0];
+                multiLine[2 * i] = arrowLines[1];
             } else { //垂直
                 osg::Vec2 previousP = points[i-1];
                 osg::Vec2 point = Math::calculateIntersection(vectorBase, vectorNormal, pointI, previousP);
                 points.push_back(point);
                 Math::MultiLineString arrowLines = Math::calculateArrowLines(previousP,point,15);
-                multiLine.push_back(arrowLines[0]);
-                multiLine.push_back(arrowLines[1]);
+                multiLine[2 * i - 1] = arrowLines[0];
+                multiLine[2 * i] = arrowLines[1];
             }
         }
-        multiLine.insert(multiLine.begin(), points);
+    } else {
+        multiLine.clear();
     }
-    return multiLine;
 }
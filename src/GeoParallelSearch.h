@@ -19,11 +19,19 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void finishDraw();
 
-    Math::MultiLineString calculateParts(const std::vector<osg::Vec2>& controlPoints);
+    // 由控制点计算外形，不依赖工具状态，也注册为批量生成的外形函数
+    static Math::MultiLineString calculateParts(const std::vector<osg::Vec2>& controlPoints);
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts) { return calculateParts(ctrlPts); }
+    // 同上，结果写入multiLine，已有的各分量原位覆盖，拖动时不重新分配
+    static void calculateParts(const std::vector<osg::Vec2>& controlPoints, Math::MultiLineString& multiLine);
 
 private:
     Math::MultiLineString multiLine_;
+    // 鼠标移动时的临时控制点，复用以避免每次移动重新分配
+    std::vector<osg::Vec2> _moveCtrlPts;
+    Math::MultiLineString _moveParts;
     osgEarth::Symbology::Style _lineStyle;
     osg::ref_ptr<osgEarth::Annotation::FeatureNode> _featureNode;
 };
@@ -0,0 +1,181 @@
+#include "GeoRangeRings.h"
+#include "FeaturePool.h"
+#include "DrawProfiler.h"
+
+using namespace osgEarth;
+using namespace osgEarth::Symbology;
+using namespace osgEarth::Features;
+using namespace osgEarth::Annotation;
+
+GeoRangeRings::GeoRangeRings(MapNode *mapNode, osg::Group *drawGroup)
+    : DrawTool(mapNode, drawGroup)
+    , _ringCount(DEFAULT_RING_COUNT)
+    , _sides(DEFAULT_SIDES)
+    , _sectorMode(false)
+{
+    // clamp to the terrain skin as it pages in
+    AltitudeSymbol* alt = _lineStyle.getOrCreate<AltitudeSymbol>();
+    alt->clamping() = alt->CLAMP_TO_TERRAIN;
+    alt->technique() = alt->TECHNIQUE_DRAPE;
+
+    // offset to mitigate Z fighting
+    RenderSymbol* render = _lineStyle.getOrCreate<RenderSymbol>();
+    render->lighting() = false;
+    render->depthOffset()->enabled() = true;
+    render->depthOffset()->automatic() = true;
+
+    // define a style for the line
+    LineSymbol* ls = _lineStyle.getOrCreate<LineSymbol>();
+    ls->stroke()->color() = Color::Yellow;
+    ls->stroke()->width() = 2.0f;
+    ls->stroke()->widthUnits() = Units::PIXELS;
+}
+
+void GeoRangeRings::beginDraw(const osg::Vec3d &lla)
+{
+    osg::Vec2 point(lla.x(), lla.y());
+    if (_controlPoints.empty()) {
+        _controlPoints.push_back(point);
+        return;
+    }
+
+    if (_controlPoints.size() == 1) {
+        //第二次点击确定半径和起始边
+        if (Math::calculateDistance(_controlPoints[0], point) <= 0)
+            return;
+        _controlPoints.push_back(point);
+        //整圆的终止边与起始边相同；扇形等待第三次点击
+        if (!_sectorMode)
+            _controlPoints.push_back(point);
+        else
+            return;
+    } else {
+        //扇形的终止边，或其余的圆心
+        _controlPoints.push_back(point);
+    }
+
+    if (!_featureNode.valid()) {
+        _featureNode = acquireFeatureNode(Geometry::TYPE_MULTI, _lineStyle);
+        drawCommand(_featureNode);
+    }
+    Math::MultiLineString rings;
+    {
+        DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoRangeRings::calculateRings");
+        rings = calculateRings(_controlPoints, _ringCount, _sides);
+    }
+    updateNode(_featureNode, rings);
+}
+
+void GeoRangeRings::moveDraw(const osg::Vec3d &lla)
+{
+    if (_controlPoints.empty())
+        return;
+
+    osg::Vec2 point(lla.x(), lla.y());
+    Math::MultiLineString rings;
+    {
+        DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoRangeRings::calculateRings");
+        if (_controlPoints.size() < 3) {
+            //半径或终止边未确定时，以鼠标处为下一个控制点预览
+            std::vector<osg::Vec2> ctrlPts(_controlPoints);
+            ctrlPts.push_back(point);
+            rings = calculateRings(ctrlPts, _ringCount, _sides);
+        } else {
+            //已确定的环不随鼠标重建，只预览鼠标处的圆心
+            std::vector<float> radii;
+            float startAngle, sweepAngle;
+            if (calculateSector(_controlPoints, _ringCount, radii, startAngle, sweepAngle))
+                rings = Math::calculateRangeRings(std::vector<osg::Vec2>(1, point), radii, startAngle, sweepAngle, _sides);
+        }
+    }
+
+    if (!_previewNode.valid()) {
+        _previewNode = acquireFeatureNode(Geometry::TYPE_MULTI, _lineStyle);
+        _tmpGroup->addChild(_previewNode);
+    }
+    updateNode(_previewNode, rings);
+}
+
+void GeoRangeRings::endDraw(const osg::Vec3d &lla)
+{
+
+}
+
+void GeoRangeRings::finishDraw()
+{
+    //扇形的终止边未确定时按整圆结束
+    if (_controlPoints.size() != 2)
+        return;
+    _controlPoints.push_back(_controlPoints[1]);
+    if (!_featureNode.valid()) {
+        _featureNode = acquireFeatureNode(Geometry::TYPE_MULTI, _lineStyle);
+        drawCommand(_featureNode);
+    }
+    updateNode(_featureNode, calculateRings(_controlPoints, _ringCount, _sides));
+}
+
+void GeoRangeRings::resetDraw()
+{
+    if (_previewNode.valid()) {
+        _tmpGroup->removeChild(_previewNode);
+        FeaturePool::instance()->release(_previewNode);
+        _previewNode = NULL;
+    }
+    _controlPoints.clear();
+    _featureNode = NULL;
+}
+
+bool GeoRangeRings::calculateSector(const std::vector<osg::Vec2>& ctrlPts, unsigned int ringCount, std::vector<float>& radii, float& startAngle, float& sweepAngle)
+{
+    radii.clear();
+    if (ctrlPts.size() < 2 || ringCount == 0)
+        return false;
+    const osg::Vec2& center = ctrlPts[0];
+    float maxRadius = Math::calculateDistance(center, ctrlPts[1]);
+    if (maxRadius <= 0)
+        return false;
+    for (unsigned int i = 1; i <= ringCount; i++) {
+        radii.push_back(maxRadius * i / ringCount);
+    }
+
+    startAngle = 0;
+    sweepAngle = 2*osg::PI;
+    if (ctrlPts.size() >= 3 && ctrlPts[2] != center) {
+        float start = Math::calculateAngle(ctrlPts[1], center);
+        float sweep = Math::calculateAngle(ctrlPts[2], center) - start;
+        if (sweep < 0)
+            sweep += 2*osg::PI;
+        //终止边与起始边同向时为整圆
+        if (sweep > 0) {
+            startAngle = start;
+            sweepAngle = sweep;
+        }
+    }
+    return true;
+}
+
+Math::MultiLineString GeoRangeRings::calculateRings(const std::vector<osg::Vec2>& ctrlPts, unsigned int ringCount, float sides)
+{
+    std::vector<float> radii;
+    float startAngle, sweepAngle;
+    if (!calculateSector(ctrlPts, ringCount, radii, startAngle, sweepAngle))
+        return Math::MultiLineString();
+    std::vector<osg::Vec2> centers(1, ctrlPts[0]);
+    if (ctrlPts.size() > 3)
+        centers.insert(centers.end(), ctrlPts.begin() + 3, ctrlPts.end());
+    return Math::calculateRangeRings(centers, radii, startAngle, sweepAngle, sides);
+}
+
+void GeoRangeRings::updateNode(FeatureNode* node, const Math::MultiLineString& rings)
+{
+    MultiGeometry* multiGeom = dynamic_cast<MultiGeometry*>(node->getFeature()->getGeometry());
+    if (multiGeom && updateMultiGeometry(multiGeom, rings)) {
+        buildNode(node);
+    }
+}
+
+Math::MultiLineString GeoRangeRings::calculateOutline(const std::vector<osg::Vec2>& ctrlPts)
+{
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoRangeRings::calculateOutline");
+    return calculateRings(ctrlPts, DEFAULT_RING_COUNT, DEFAULT_SIDES);
+}
@@ -0,0 +1,67 @@
+#ifndef GEORANGERINGS_H
+#define GEORANGERINGS_H 1
+
+#include "DrawTool.h"
+#include "PlottingMath.h"
+
+#include <osgEarthFeatures/Feature>
+#include <osgEarthSymbology/Style>
+#include <osgEarthAnnotation/FeatureNode>
+
+/**
+ * 距离环（扇形）
+ * 控制点：[0]圆心，[1]确定最大半径和扇形的起始边，[2]确定扇形的终止边（自起始边逆时针），
+ * 与起始边同向或与圆心重合时为整圆，[3]之后为共用同一组半径和张角的其余圆心。
+ * 绘制时第一次点击确定圆心，第二次点击确定最大半径；扇形模式下第三次点击确定终止边，
+ * 否则终止边取第二个点（整圆）；之后每次点击增加一个圆心。
+ * 同一次绘制的所有环合并在一个要素节点中批量绘制，不为单个环创建编辑器。
+ */
+class GeoRangeRings : public DrawTool {
+public:
+    GeoRangeRings(osgEarth::MapNode* mapNode, osg::Group* drawGroup);
+
+    virtual DrawType getType() { return DRAW_RANGERINGS; }
+
+    virtual void beginDraw(const osg::Vec3d& lla);
+    virtual void moveDraw(const osg::Vec3d& lla);
+    virtual void endDraw(const osg::Vec3d& lla);
+    virtual void resetDraw();
+    virtual void finishDraw();
+
+    // 批量生成（calculateOutline）的环数和圆弧精度
+    static const unsigned int DEFAULT_RING_COUNT = 5;
+    static const unsigned int DEFAULT_SIDES = 90;
+
+    // 环的个数，半径在最大半径内等分
+    void setRingCount(unsigned int count) { _ringCount = count; }
+    unsigned int getRingCount() const { return _ringCount; }
+
+    // 圆弧的精度，含义同Math::calculateRangeRings的sides
+    void setSides(float sides) { _sides = sides; }
+    float getSides() const { return _sides; }
+
+    // 扇形模式：第三次点击确定扇形的终止边，否则绘制整圆
+    void setSectorMode(bool sector) { _sectorMode = sector; }
+    bool getSectorMode() const { return _sectorMode; }
+
+    // 由控制点计算距离环，只有两个点时为整圆
+    static Math::MultiLineString calculateRings(const std::vector<osg::Vec2>& ctrlPts, unsigned int ringCount, float sides);
+
+    // 批量生成的外形，环数和精度取默认值
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts);
+
+private:
+    // 由前三个控制点计算各环的半径、起始角和张角
+    static bool calculateSector(const std::vector<osg::Vec2>& ctrlPts, unsigned int ringCount, std::vector<float>& radii, float& startAngle, float& sweepAngle);
+    void updateNode(osgEarth::Annotation::FeatureNode* node, const Math::MultiLineString& rings);
+
+private:
+    unsigned int _ringCount;
+    float _sides;
+    bool _sectorMode;
+    osgEarth::Symbology::Style _lineStyle;
+    osg::ref_ptr<osgEarth::Annotation::FeatureNode> _featureNode;
+    osg::ref_ptr<osgEarth::Annotation::FeatureNode> _previewNode;
+};
+
+#endif
@@ -1,7 +1,8 @@
 
 #include "GeoStraightArrow.h"
+#include "DrawProfiler.h"
 #include <algorithm>
-#include "PlottingMath.h"
+#include "PlottingKernels.h"
 
 using namespace osgEarth;
 using namespace osgEarth::Symbology;
@@ -41,30 +42,21 @@ void GeoStraightArrow::beginDraw(const osg::Vec3d &lla)
     if (_controlPoints.size() == 2 && _controlPoints[0]==_controlPoints[1])
         return;
 
-    _drawParts.clear();
-    if (_controlPoints.size() == 2)
-        _drawParts = calculateTwoPoints(_controlPoints);
-    else
-        _drawParts = calculateMorePoints(_controlPoints);
-
 //    if (_polygonEdit.valid()) {
 //        _polygonEdit->removeChildren(0, _polygonEdit->getNumChildren());
 //        _polygonEdit = NULL;
 //    }
 
     if (!_featureNode.valid()) {
-         Feature* feature = new Feature(new Polygon, getMapNode()->getMapSRS(), _polygonStyle);
-        _featureNode = new FeatureNode(getMapNode(), feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_POLYGON, _polygonStyle);
 //        _drawGroup->addChild(_featureNode);
         drawCommand(_featureNode);
     }
 
     Geometry* geom = _featureNode->getFeature()->getGeometry();
-    geom->clear();
-    for (auto& n : _drawParts) {
-        geom->push_back(osg::Vec3(n.x(), n.y(), 0));
-    }
-    _featureNode->init();
+    calculateGeometry(_controlPoints, _ratio, geom);
+    densifyGeodesic(geom, true);
+    buildNode(_featureNode);
 
 //    if (!_polygonEdit.valid()) {
 //        _polygonEdit = new FeatureEditor(_featureNode);
@@ -77,27 +69,20 @@ void GeoStraightArrow::moveDraw(const osg::Vec3d &lla)
     if (_controlPoints.empty())
         return;
     if (!_featureNode.valid()) {
-         Feature* feature = new Feature(new Polygon, getMapNode()->getMapSRS(), _polygonStyle);
-        _featureNode = new FeatureNode(getMapNode(), feature);
+        _featureNode = acquireFeatureNode(Geometry::TYPE_POLYGON, _polygonStyle);
         drawCommand(_featureNode);
     }
 
     if (_featureNode.valid()) {
         std::vector<osg::Vec2> ctrlPts = _controlPoints;
-        std::vector<osg::Vec2> drawPts;
         ctrlPts.push_back(osg::Vec2(lla.x(), lla.y()));
 
-        if (ctrlPts.size() == 2)
-            drawPts = calculateTwoPoints(ctrlPts);
-        else
-            drawPts = calculateMorePoints(ctrlPts);
-
         Geometry* geom = _featureNode->getFeature()->getGeometry();
-        geom->clear();
-        for (auto& n : drawPts) {
-            geom->push_back(osg::Vec3(n.x(), n.y(), 0));
-        }
-        _featureNode->init();
+        calculateGeometry(ctrlPts, _ratio, geom);
+        densifyGeodesic(geom, true);
+        clipForDisplay(geom);
+        simplifyForDisplay(geom, true);
+        buildNode(_featureNode);
     }
 }
 
@@ -112,43 +97,34 @@ void GeoStraightArrow::resetDraw()
     _featureNode = NULL;
 }
 
-std::vector<osg::Vec2> GeoStraightArrow::calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts)
+void GeoStraightArrow::finishDraw()
+{
+    if (!_featureNode.valid())
+        return;
+    //节点上是最后一次移动的预览，由控制点重建完整精度的外形
+    Geometry* geom = _featureNode->getFeature()->getGeometry();
+    if (_controlPoints.size() > 2 || (_controlPoints.size() == 2 && _controlPoints[0] != _controlPoints[1])) {
+        calculateGeometry(_controlPoints, _ratio, geom);
+        densifyGeodesic(geom, true);
+    } else {
+        geom->clear();
+    }
+    buildNode(_featureNode);
+}
+
+std::vector<osg::Vec2> GeoStraightArrow::calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts, float ratio)
 {
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoStraightArrow::calculateTwoPoints");
     //取出第一和第二两个点
-    osg::Vec2 pointS =  ctrlPts[0];
-    osg::Vec2 pointE = ctrlPts[1];
-    //计算箭头总长度，即两个控制点的距离
-    float l = sqrtf((pointE.y()-pointS.y())*(pointE.y()-pointS.y())+(pointE.x()-pointS.x())*(pointE.x()-pointS.x()));
-    float w = l / _ratio;
-    //计算三角形的底边中心点坐标
-    float x_ = pointS.x() + (pointE.x() - pointS.x())*(_ratio-1)/_ratio;
-    float y_ = pointS.y() + (pointE.y() - pointS.y())*(_ratio-1)/_ratio;
-    //计算与基本向量夹角90度的，长度为w/2的向量数组
-    osg::Vec2 v_l, v_r;
-    std::vector<osg::Vec2> v_lr = Math::calculateVector(osg::Vec2(pointE.x()-pointS.x(),pointE.y()-pointS.y()), osg::PI_2, w/2);
-    v_l = v_lr[0];
-    v_r = v_lr[1];
-
-    //左1点
-    osg::Vec2 point1(pointS.x()+v_l.x(),pointS.y()+v_l.y());
-    //左2点
-    osg::Vec2 point2(x_+point1.x()-pointS.x(),y_+point1.y()-pointS.y());
-    // 左3点
-    osg::Vec2 point3(2*point2.x()-x_, 2*point2.y()-y_);
-    // 顶点
-    osg::Vec2 point4(pointE.x(), pointE.y());
-    // 右3点
-    osg::Vec2 point7(pointS.x()+v_r.x(),pointS.y()+v_r.y());
-    // 右2点
-    osg::Vec2 point6(x_+point7.x()-pointS.x(), y_+point7.y()-pointS.y());
-    // 右1点
-    osg::Vec2 point5(2*point6.x()-x_, 2*point6.y()-y_);
-
-    return std::vector<osg::Vec2>{point1, point2, point3, point4, point5, point6, point7};
+    std::array<osg::Vec2, 2> pts = {{ctrlPts[0], ctrlPts[1]}};
+    Math::FixedLineString<Math::StraightArrowKernel::CAPACITY> points;
+    Math::StraightArrowKernel::calculate(pts, ratio, points);
+    return std::vector<osg::Vec2>(points.begin(), points.end());
 }
 
-std::vector<osg::Vec2> GeoStraightArrow::calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts)
+std::vector<osg::Vec2> GeoStraightArrow::calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts, float ratio)
 {
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoStraightArrow::calculateMorePoints");
     //计算箭头总长度和直箭头的宽
     float l = 0, w = 0;
     for (unsigned int i = 0; i < ctrlPts.size()-1; i++) {
@@ -157,7 +133,7 @@ std::vector<osg::Vec2> GeoStraightArrow::calculateMorePoints(const std::vector<o
         osg::Vec2 pointE = ctrlPts[i+1];
         l += sqrtf((pointE.y()-pointS.y())*(pointE.y()-pointS.y())+(pointE.x()-pointS.x())*(pointE.x()-pointS.x()));
     }
-    w = l/_ratio;
+    w = l/ratio;
     float a = atanf(w/(2.0*l));
     //定义左右控制点集合
     std::vector<osg::Vec2> points_C_l;
@@ -316,6 +292,29 @@ std::vector<osg::Vec2> GeoStraightArrow::calculateMorePoints(const std::vector<o
     return pointsR;
 }
 
+void GeoStraightArrow::calculateGeometry(const std::vector<osg::Vec2>& ctrlPts, float ratio, Geometry* geom)
+{
+    if (ctrlPts.size() != 2) {
+        setGeometryPoints(geom, calculateMorePoints(ctrlPts, ratio));
+        return;
+    }
+    DRAW_PROFILE_STAGE(STAGE_COMPUTE, "GeoStraightArrow::calculateGeometry");
+    std::array<osg::Vec2, 2> pts = {{ctrlPts[0], ctrlPts[1]}};
+    geom->clear();
+    geom->reserve(Math::StraightArrowKernel::CAPACITY);
+    GeometryPoints points(geom);
+    Math::StraightArrowKernel::calculate(pts, ratio, points);
+}
+
+Math::MultiLineString GeoStraightArrow::calculateOutline(const std::vector<osg::Vec2>& ctrlPts)
+{
+    Math::MultiLineString outline;
+    if (ctrlPts.size() < 2)
+        return outline;
+    outline.push_back(ctrlPts.size() == 2 ? calculateTwoPoints(ctrlPts) : calculateMorePoints(ctrlPts));
+    return outline;
+}
+
 void GeoStraightArrow::calculateParts()
 {
 
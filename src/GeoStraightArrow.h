@@ -16,13 +16,19 @@ public:
     virtual void moveDraw(const osg::Vec3d& lla);
     virtual void endDraw(const osg::Vec3d& lla);
     virtual void resetDraw();
+    virtual void finishDraw();
+
+    // 由控制点计算直箭头外形，供注册表批量生成使用
+    static Math::MultiLineString calculateOutline(const std::vector<osg::Vec2>& ctrlPts);
+    // 由控制点计算直箭头的绘制点，结果直接写入几何geom
+    static void calculateGeometry(const std::vector<osg::Vec2>& ctrlPts, float ratio, osgEarth::Symbology::Geometry* geom);
 
 private:
     /**
      * 计算两个控制点时直箭头的所有绘制点
      * 两个控制点的直箭头绘制点只需要7个就可以构成
      */
-    std::vector<osg::Vec2> calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts);
+    static std::vector<osg::Vec2> calculateTwoPoints(const std::vector<osg::Vec2>& ctrlPts, float ratio = 6.0);
     /**
      * 计算三个或三个以上的控制点时的所有绘制点
      * 由于中间的控制点之间会进行差值，产生曲线效果，所以所需绘制点会很多
@@ -30,7 +36,7 @@ private:
      * 每一条线段向左右两边扩充两条平行线，这样就形成了一个折线形式的箭头，
      * 然后在拐角进行曲线化处理（二次贝塞尔曲线差值），就形成了效果比较好的箭头
      */
-    std::vector<osg::Vec2> calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts);
+    static std::vector<osg::Vec2> calculateMorePoints(const std::vector<osg::Vec2>& ctrlPts, float ratio = 6.0);
 
     /**
      * 重写了父类的方法
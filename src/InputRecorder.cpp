@@ -0,0 +1,121 @@
+#include "InputRecorder.h"
+#include <osg/Timer>
+#include <osg/ValueObject>
+#include <iomanip>
+#include <sstream>
+
+InputRecorder::InputRecorder(const std::string& fileName, LocationProvider* locationProvider)
+    : _file(fileName.c_str())
+    , _locationProvider(locationProvider)
+{
+    if (_file.is_open())
+        _file << "# time eventType x y button key modKeyMask hasLocation lon lat alt" << std::endl;
+}
+
+bool InputRecorder::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+    if (!_file.is_open())
+        return false;
+
+    switch (ea.getEventType()) {
+    case osgGA::GUIEventAdapter::PUSH:
+    case osgGA::GUIEventAdapter::RELEASE:
+    case osgGA::GUIEventAdapter::DOUBLECLICK:
+    case osgGA::GUIEventAdapter::MOVE:
+    case osgGA::GUIEventAdapter::DRAG:
+    case osgGA::GUIEventAdapter::KEYDOWN:
+    case osgGA::GUIEventAdapter::KEYUP:
+        break;
+    default:
+        return false;
+    }
+
+    RecordedEvent event;
+    event.time = ea.getTime();
+    event.eventType = ea.getEventType();
+    event.x = ea.getX();
+    event.y = ea.getY();
+    event.button = ea.getButton();
+    event.key = ea.getKey();
+    event.modKeyMask = ea.getModKeyMask();
+    event.hasLocation = false;
+    if (event.eventType != osgGA::GUIEventAdapter::KEYDOWN && event.eventType != osgGA::GUIEventAdapter::KEYUP) {
+        osgViewer::View* view = static_cast<osgViewer::View*>(aa.asView());
+        event.hasLocation = _locationProvider.valid() && _locationProvider->getLocationAt(view, ea.getX(), ea.getY(), event.lla);
+    }
+    write(_file, event);
+    return false;
+}
+
+bool InputRecorder::read(std::istream& in, RecordedEvent& event)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream ss(line);
+        int hasLocation = 0;
+        ss >> event.time >> event.eventType >> event.x >> event.y
+           >> event.button >> event.key >> event.modKeyMask >> hasLocation;
+        if (ss.fail())
+            continue;
+        event.hasLocation = hasLocation != 0;
+        if (event.hasLocation)
+            ss >> event.lla.x() >> event.lla.y() >> event.lla.z();
+        return true;
+    }
+    return false;
+}
+
+void InputRecorder::write(std::ostream& out, const RecordedEvent& event)
+{
+    out << std::setprecision(17) << event.time << " " << event.eventType << " "
+        << event.x << " " << event.y << " "
+        << event.button << " " << event.key << " " << event.modKeyMask << " "
+        << (event.hasLocation ? 1 : 0);
+    if (event.hasLocation)
+        out << " " << event.lla.x() << " " << event.lla.y() << " " << event.lla.z();
+    out << "\n";
+}
+
+InputPlayer::InputPlayer(const std::string& fileName)
+{
+    std::ifstream in(fileName.c_str());
+    RecordedEvent event;
+    while (InputRecorder::read(in, event))
+        _events.push_back(event);
+}
+
+double InputPlayer::replay(osgViewer::Viewer& viewer)
+{
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    for (unsigned int i = 0; i < _events.size(); i++) {
+        const RecordedEvent& event = _events[i];
+        osg::ref_ptr<osgGA::GUIEventAdapter> ea = new osgGA::GUIEventAdapter;
+        ea->setTime(event.time);
+        ea->setEventType((osgGA::GUIEventAdapter::EventType)event.eventType);
+        ea->setX(event.x);
+        ea->setY(event.y);
+        ea->setButton(event.button);
+        ea->setKey(event.key);
+        ea->setModKeyMask(event.modKeyMask);
+        if (event.hasLocation)
+            ea->setUserValue("lla", event.lla);
+
+        // 快捷键会切换工具，增删事件处理器，这里使用副本
+        osgViewer::View::EventHandlers handlers = viewer.getEventHandlers();
+        for (auto it = handlers.begin(); it != handlers.end(); it++) {
+            osgGA::GUIEventHandler* handler = dynamic_cast<osgGA::GUIEventHandler*>(it->get());
+            if (handler)
+                handler->handle(*ea, viewer);
+        }
+    }
+    return osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+}
+
+double InputPlayer::getRecordedDuration() const
+{
+    if (_events.empty())
+        return 0.0;
+    return _events.back().time - _events.front().time;
+}
@@ -0,0 +1,77 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H 1
+
+#include <osgGA/GUIEventHandler>
+#include <osgViewer/Viewer>
+#include <fstream>
+#include <vector>
+#include "LocationProvider.h"
+
+/**
+ * 录制的一个输入事件
+ * 鼠标事件同时保存录制时拾取到的经纬度，回放时不依赖地形和渲染环境
+ */
+struct RecordedEvent {
+    double time;
+    int eventType;
+    float x;
+    float y;
+    int button;
+    int key;
+    int modKeyMask;
+    bool hasLocation;
+    osg::Vec3d lla;
+};
+
+/**
+ * 输入事件录制
+ * 需要在Shortcuts和绘制工具之前加入viewer，把工具处理的事件逐行写入文本文件
+ */
+class InputRecorder : public osgGA::GUIEventHandler {
+public:
+    /**
+     * @param fileName 录制文件
+     * @param locationProvider 记录鼠标事件位置所用的拾取方式，应与绘制工具一致
+     */
+    InputRecorder(const std::string& fileName, LocationProvider* locationProvider);
+
+    virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
+
+    bool valid() const { return _file.is_open(); }
+
+    // 事件文件的读写，每行一个事件
+    static bool read(std::istream& in, RecordedEvent& event);
+    static void write(std::ostream& out, const RecordedEvent& event);
+
+private:
+    std::ofstream _file;
+    osg::ref_ptr<LocationProvider> _locationProvider;
+};
+
+/**
+ * 输入事件回放
+ * 不启动渲染循环，按录制顺序把事件依次交给viewer上的事件处理器，
+ * 带有录制位置的鼠标事件由DrawTool直接使用该位置，不再做场景求交。
+ */
+class InputPlayer {
+public:
+    explicit InputPlayer(const std::string& fileName);
+
+    bool valid() const { return !_events.empty(); }
+
+    /**
+     * 回放全部事件
+     * @param viewer 事件处理器所在的viewer，不需要realize
+     * @return 回放耗时，单位毫秒
+     */
+    double replay(osgViewer::Viewer& viewer);
+
+    unsigned int getNumEvents() const { return _events.size(); }
+    // 录制时长，单位秒
+    double getRecordedDuration() const;
+
+private:
+    std::vector<RecordedEvent> _events;
+};
+
+#endif
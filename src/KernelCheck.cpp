@@ -0,0 +1,288 @@
+#include "KernelCheck.h"
+#include "SymbolTypeRegistry.h"
+#include <osg/Timer>
+#include <float.h>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdlib.h>
+
+namespace {
+// 计时重复的遍数，取最短的一遍
+const unsigned int TIMING_PASSES = 5;
+// 不限控制点数的符号最多生成的控制点数
+const unsigned int EXTRA_CONTROL_POINTS = 6;
+// 容差之外再允许的float舍入，以坐标的ulp计；经度175度附近1ulp约1.5e-5度，固定的容差无法区分舍入和真正的偏差
+const double TOLERANCE_ULPS = 2.0;
+
+// p处允许的偏差
+inline double allowedDeviation(const osg::Vec2& p, double tolerance)
+{
+    return tolerance + TOLERANCE_ULPS * FLT_EPSILON * osg::maximum(fabs(p.x()), fabs(p.y()));
+}
+
+// 退化输入可能产生NaN，按文本读写坐标，nan、inf也能原样读回
+void writePoint(std::ostream& out, const osg::Vec2& p)
+{
+    out << " " << p.x() << " " << p.y();
+}
+
+bool readPoint(std::istream& in, osg::Vec2& p)
+{
+    std::string x, y;
+    in >> x >> y;
+    if (in.fail())
+        return false;
+    p.set(strtof(x.c_str(), NULL), strtof(y.c_str(), NULL));
+    return true;
+}
+}
+
+KernelCheck::KernelCheck(unsigned int samplesPerType, unsigned int seed)
+    : _samplesPerType(samplesPerType)
+    , _state(seed ? seed : 1)
+{
+}
+
+float KernelCheck::random(float min, float max)
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return min + (max - min) * (float)(_state & 0xffffff) / (float)0x1000000;
+}
+
+void KernelCheck::generate(std::vector<TypeSamples>& corpus)
+{
+    const std::vector<SymbolType>& types = SymbolTypeRegistry::instance()->getTypes();
+    for (unsigned int t = 0; t < types.size(); t++) {
+        const SymbolType& symbolType = types[t];
+        if (!symbolType.outline)
+            continue;
+
+        TypeSamples typeSamples;
+        typeSamples.type = symbolType.type;
+        typeSamples.name = symbolType.name;
+        typeSamples.ms = 0.0;
+        unsigned int minPoints = osg::maximum(symbolType.minControlPoints, 1u);
+        unsigned int maxPoints = symbolType.maxControlPoints ? symbolType.maxControlPoints : minPoints + EXTRA_CONTROL_POINTS;
+        for (unsigned int i = 0; i < _samplesPerType; i++) {
+            //符号大小从街区到省级，避开两极和日期变更线
+            Sample sample;
+            unsigned int count = minPoints + (unsigned int)random(0.0f, (float)(maxPoints - minPoints + 1));
+            count = osg::minimum(count, maxPoints);
+            osg::Vec2 center(random(-170.0f, 170.0f), random(-70.0f, 70.0f));
+            float extent = random(0.01f, 5.0f);
+            for (unsigned int k = 0; k < count; k++)
+                sample.controlPoints.push_back(center + osg::Vec2(random(-extent, extent), random(-extent, extent)));
+            typeSamples.samples.push_back(sample);
+        }
+        corpus.push_back(typeSamples);
+    }
+}
+
+double KernelCheck::compute(TypeSamples& typeSamples)
+{
+    const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(typeSamples.type);
+    if (!symbolType || !symbolType->outline)
+        return -1.0;
+
+    double best = 0.0;
+    for (unsigned int pass = 0; pass < TIMING_PASSES; pass++) {
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        for (unsigned int i = 0; i < typeSamples.samples.size(); i++) {
+            Sample& sample = typeSamples.samples[i];
+            sample.outline = symbolType->outline(sample.controlPoints);
+        }
+        double ms = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+        if (pass == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+bool KernelCheck::record(const std::string& fileName, std::ostream& log)
+{
+    std::vector<TypeSamples> corpus;
+    generate(corpus);
+    for (unsigned int t = 0; t < corpus.size(); t++) {
+        corpus[t].ms = compute(corpus[t]);
+        log << std::left << std::setw(16) << corpus[t].name << corpus[t].samples.size() << " samples, "
+            << corpus[t].ms << " ms" << std::endl;
+    }
+    if (!write(fileName, corpus)) {
+        log << "Failed to write " << fileName << std::endl;
+        return false;
+    }
+    log << "Recorded " << corpus.size() << " symbol types to " << fileName << std::endl;
+    return true;
+}
+
+bool KernelCheck::check(const std::string& fileName, double tolerance, std::ostream& log)
+{
+    std::vector<TypeSamples> reference;
+    if (!read(fileName, reference)) {
+        log << "Failed to read " << fileName << std::endl;
+        return false;
+    }
+
+    bool passed = true;
+    log << std::left << std::setw(16) << "symbol" << std::right
+        << std::setw(9) << "samples" << std::setw(14) << "max dev" << std::setw(11) << "mismatch"
+        << std::setw(11) << "ref ms" << std::setw(11) << "new ms" << std::setw(9) << "speedup" << std::endl;
+    for (unsigned int t = 0; t < reference.size(); t++) {
+        const TypeSamples& ref = reference[t];
+        TypeSamples current = ref;
+        double ms = compute(current);
+        if (ms < 0.0) {
+            log << std::left << std::setw(16) << ref.name << "  not registered" << std::endl;
+            passed = false;
+            continue;
+        }
+
+        double maxDeviation = 0.0, maxRatio = 0.0;
+        unsigned int mismatched = 0;
+        for (unsigned int i = 0; i < ref.samples.size(); i++) {
+            const Math::MultiLineString& a = ref.samples[i].outline;
+            const Math::MultiLineString& b = current.samples[i].outline;
+            if (a.size() != b.size()) {
+                mismatched++;
+                continue;
+            }
+            for (unsigned int l = 0; l < a.size(); l++) {
+                if (a[l].size() != b[l].size())
+                    mismatched++;
+                double ratio;
+                maxDeviation = osg::maximum(maxDeviation, deviation(a[l], b[l], tolerance, ratio));
+                maxRatio = osg::maximum(maxRatio, ratio);
+            }
+        }
+
+        bool ok = mismatched == 0 && maxRatio <= 1.0;
+        passed = passed && ok;
+        log << std::left << std::setw(16) << ref.name << std::right
+            << std::setw(9) << ref.samples.size() << std::setw(14) << maxDeviation << std::setw(11) << mismatched
+            << std::setw(11) << ref.ms << std::setw(11) << ms
+            << std::setw(9) << (ms > 0.0 ? ref.ms / ms : 0.0) << (ok ? "" : "  FAILED") << std::endl;
+    }
+    log << (passed ? "All symbol outlines match the reference" : "Symbol outlines differ from the reference")
+        << " (tolerance " << tolerance << " + " << TOLERANCE_ULPS << " ulp)" << std::endl;
+    return passed;
+}
+
+double KernelCheck::deviation(const Math::LineString& a, const Math::LineString& b, double tolerance, double& ratio)
+{
+    double result = 0.0;
+    ratio = 0.0;
+    if (a.size() == b.size()) {
+        for (unsigned int i = 0; i < a.size(); i++) {
+            //两边在同一位置都是NaN视为一致，只有一边是NaN视为无穷大的偏差
+            if (a[i].isNaN() || b[i].isNaN()) {
+                if (a[i].isNaN() != b[i].isNaN()) {
+                    ratio = std::numeric_limits<double>::infinity();
+                    return ratio;
+                }
+                continue;
+            }
+            double d = (a[i] - b[i]).length();
+            result = osg::maximum(result, d);
+            ratio = osg::maximum(ratio, d / allowedDeviation(a[i], tolerance));
+        }
+        return result;
+    }
+    if (a.empty() || b.empty())
+        return 0.0;
+
+    const Math::LineString* from[2] = { &a, &b };
+    const Math::LineString* to[2] = { &b, &a };
+    for (int d = 0; d < 2; d++) {
+        for (unsigned int i = 0; i < from[d]->size(); i++) {
+            double nearest = std::numeric_limits<double>::max();
+            for (unsigned int j = 0; j < to[d]->size(); j++)
+                nearest = osg::minimum(nearest, (double)((*from[d])[i] - (*to[d])[j]).length2());
+            result = osg::maximum(result, sqrt(nearest));
+            ratio = osg::maximum(ratio, sqrt(nearest) / allowedDeviation((*from[d])[i], tolerance));
+        }
+    }
+    return result;
+}
+
+bool KernelCheck::write(const std::string& fileName, const std::vector<TypeSamples>& corpus)
+{
+    std::ofstream out(fileName.c_str());
+    if (!out.is_open())
+        return false;
+
+    // 每种符号一行类型信息，每个样本一行控制点，随后每条折线一行
+    out << "# type id name samples ms" << std::endl
+        << "# sample numControlPoints x y ... numLines" << std::endl
+        << "# numPoints x y ..." << std::endl;
+    out << std::setprecision(9);
+    for (unsigned int t = 0; t < corpus.size(); t++) {
+        const TypeSamples& typeSamples = corpus[t];
+        out << "type " << typeSamples.type << " " << typeSamples.name << " "
+            << typeSamples.samples.size() << " " << typeSamples.ms << "\n";
+        for (unsigned int i = 0; i < typeSamples.samples.size(); i++) {
+            const Sample& sample = typeSamples.samples[i];
+            out << "sample " << sample.controlPoints.size();
+            for (unsigned int k = 0; k < sample.controlPoints.size(); k++)
+                writePoint(out, sample.controlPoints[k]);
+            out << " " << sample.outline.size() << "\n";
+            for (unsigned int l = 0; l < sample.outline.size(); l++) {
+                const Math::LineString& line = sample.outline[l];
+                out << line.size();
+                for (unsigned int k = 0; k < line.size(); k++)
+                    writePoint(out, line[k]);
+                out << "\n";
+            }
+        }
+    }
+    return out.good();
+}
+
+bool KernelCheck::read(const std::string& fileName, std::vector<TypeSamples>& corpus)
+{
+    std::ifstream in(fileName.c_str());
+    if (!in.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream header(line);
+        std::string keyword;
+        unsigned int numSamples = 0;
+        TypeSamples typeSamples;
+        header >> keyword >> typeSamples.type >> typeSamples.name >> numSamples >> typeSamples.ms;
+        if (header.fail() || keyword != "type")
+            return false;
+
+        for (unsigned int i = 0; i < numSamples; i++) {
+            Sample sample;
+            unsigned int numPoints = 0, numLines = 0;
+            in >> keyword >> numPoints;
+            if (in.fail() || keyword != "sample")
+                return false;
+            sample.controlPoints.resize(numPoints);
+            for (unsigned int k = 0; k < numPoints; k++)
+                readPoint(in, sample.controlPoints[k]);
+            in >> numLines;
+            sample.outline.resize(numLines);
+            for (unsigned int l = 0; l < numLines; l++) {
+                in >> numPoints;
+                sample.outline[l].resize(numPoints);
+                for (unsigned int k = 0; k < numPoints; k++)
+                    readPoint(in, sample.outline[l][k]);
+            }
+            if (in.fail())
+                return false;
+            typeSamples.samples.push_back(sample);
+        }
+        // 跳过最后一行折线的换行
+        std::getline(in, line);
+        corpus.push_back(typeSamples);
+    }
+    return !corpus.empty();
+}
@@ -0,0 +1,67 @@
+#ifndef KERNELCHECK_H
+#define KERNELCHECK_H 1
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "PlottingMath.h"
+
+/**
+ * 符号外形生成的基准对比
+ * 按固定种子为注册表中每种有外形函数的符号生成随机控制点集，把控制点、外形和耗时记录为基准文件；
+ * 修改PlottingMath或工具的calculate函数后，用同一批控制点重新计算并与基准逐点对比，
+ * 报告每种符号的最大偏差、形状（折线数或点数）不一致的样本数以及相对基准的加速比（基准耗时/当前耗时）。
+ * 基准是文本文件，坐标按float的有效位数写出，读回后与记录时完全一致。
+ */
+class KernelCheck {
+public:
+    /**
+     * @param samplesPerType 每种符号的样本数
+     * @param seed 随机种子，相同的种子在各平台生成相同的控制点
+     */
+    KernelCheck(unsigned int samplesPerType = 200, unsigned int seed = 1);
+
+    // 生成控制点集，计算当前外形并写入基准文件
+    bool record(const std::string& fileName, std::ostream& log);
+
+    /**
+     * 读取基准文件，用其中的控制点重新计算外形并对比
+     * @param tolerance 允许的最大偏差，单位与控制点相同（度）；另外允许坐标本身2个ulp的float舍入
+     * @return 全部符号都在容差内且形状一致时返回true
+     */
+    bool check(const std::string& fileName, double tolerance, std::ostream& log);
+
+private:
+    struct Sample {
+        std::vector<osg::Vec2> controlPoints;
+        Math::MultiLineString outline;
+    };
+    struct TypeSamples {
+        int type;
+        std::string name;
+        double ms; // 计算全部样本一遍的耗时
+        std::vector<Sample> samples;
+    };
+
+    void generate(std::vector<TypeSamples>& corpus);
+    // 计算全部样本的外形，重复多遍取最短耗时
+    static double compute(TypeSamples& samples);
+
+    static bool read(const std::string& fileName, std::vector<TypeSamples>& corpus);
+    static bool write(const std::string& fileName, const std::vector<TypeSamples>& corpus);
+
+    /**
+     * 两条折线的偏差：点数相同时逐点比较，否则取两组顶点间的双向最近距离
+     * @param ratio 返回各点偏差与该点允许偏差之比的最大值，不超过1时在容差内
+     */
+    static double deviation(const Math::LineString& a, const Math::LineString& b, double tolerance, double& ratio);
+
+    // xorshift32，与平台的rand()无关
+    float random(float min, float max);
+
+    unsigned int _samplesPerType;
+    unsigned int _state;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "LocationProvider.h"
+#include <osgEarth/GeoCommon>
+#include <osgUtil/LineSegmentIntersector>
+
+SceneLocationProvider::SceneLocationProvider(osgEarth::MapNode* mapNode, osg::Node::NodeMask intersectionMask)
+    : _mapNode(mapNode)
+    , _intersectionMask(intersectionMask)
+{
+}
+
+bool SceneLocationProvider::getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla)
+{
+    osg::ref_ptr<osgEarth::MapNode> mapNode;
+    if (!view || !_mapNode.lock(mapNode))
+        return false;
+
+    osgUtil::LineSegmentIntersector::Intersections results;
+    if (view->computeIntersections(x, y, results, _intersectionMask)) {
+        osg::Vec3d point = results.begin()->getWorldIntersectPoint();
+
+        double lat_rad, lon_rad;
+        mapNode->getMap()->getProfile()->getSRS()->getEllipsoid()->convertXYZToLatLongHeight(
+            point.x(), point.y(), point.z(), lat_rad, lon_rad, lla.z());
+
+        lla.x() = osg::RadiansToDegrees(lon_rad);
+        lla.y() = osg::RadiansToDegrees(lat_rad);
+        return true;
+    }
+    return false;
+}
+
+HeightFieldLocationProvider::HeightFieldLocationProvider(osgEarth::MapNode* mapNode, unsigned int lod)
+    : _mapNode(mapNode)
+    , _lod(lod)
+{
+}
+
+bool HeightFieldLocationProvider::getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla)
+{
+    osg::ref_ptr<osgEarth::MapNode> mapNode;
+    if (!view || !_mapNode.lock(mapNode))
+        return false;
+
+    const osg::Camera* camera = view->getCamera();
+    osg::Matrixd vpw = camera->getViewMatrix() * camera->getProjectionMatrix();
+    if (camera->getViewport())
+        vpw.postMult(camera->getViewport()->computeWindowMatrix());
+    osg::Matrixd inverse;
+    if (!inverse.invert(vpw))
+        return false;
+    osg::Vec3d start = osg::Vec3d(x, y, 0.0) * inverse;
+    osg::Vec3d dir = osg::Vec3d(x, y, 1.0) * inverse - start;
+
+    const osgEarth::SpatialReference* srs = mapNode->getMap()->getSRS();
+    const osg::EllipsoidModel* ellipsoid = srs->getEllipsoid();
+    if (!_envelope.valid())
+        _envelope = mapNode->getMap()->getElevationPool()->createEnvelope(srs->getGeographicSRS(), _lod);
+
+    // 先与椭球求交，再把椭球抬高到交点处的地形高度重新求交
+    double height = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double a = ellipsoid->getRadiusEquator() + height;
+        double b = ellipsoid->getRadiusPolar() + height;
+        // 缩放为单位球后求解|o + t*d| = 1
+        osg::Vec3d o(start.x() / a, start.y() / a, start.z() / b);
+        osg::Vec3d d(dir.x() / a, dir.y() / a, dir.z() / b);
+        double qa = d * d;
+        double qb = 2.0 * (o * d);
+        double qc = o * o - 1.0;
+        double disc = qb * qb - 4.0 * qa * qc;
+        if (qa <= 0.0 || disc < 0.0)
+            return false;
+        double t = (-qb - sqrt(disc)) / (2.0 * qa);
+        if (t < 0.0)
+            t = (-qb + sqrt(disc)) / (2.0 * qa);
+        if (t < 0.0)
+            return false;
+
+        osg::Vec3d point = start + dir * t;
+        double lat_rad, lon_rad, alt;
+        ellipsoid->convertXYZToLatLongHeight(point.x(), point.y(), point.z(), lat_rad, lon_rad, alt);
+        lla.x() = osg::RadiansToDegrees(lon_rad);
+        lla.y() = osg::RadiansToDegrees(lat_rad);
+
+        float elevation = _envelope->getElevation(lla.x(), lla.y());
+        lla.z() = elevation == NO_DATA_VALUE ? 0.0 : elevation;
+        if (osg::equivalent(lla.z(), height, 0.5))
+            break;
+        height = lla.z();
+    }
+    return true;
+}
+
+AnalyticLocationProvider::AnalyticLocationProvider(double west, double south, double east, double north,
+    double width, double height)
+    : _west(west), _south(south), _east(east), _north(north)
+    , _width(width), _height(height)
+{
+}
+
+bool AnalyticLocationProvider::getLocationAt(osgViewer::View* /*view*/, double x, double y, osg::Vec3d& lla)
+{
+    if (_width <= 0 || _height <= 0)
+        return false;
+
+    // 窗口坐标原点在左下角
+    lla.x() = _west + (_east - _west) * x / _width;
+    lla.y() = _south + (_north - _south) * y / _height;
+    if (lla.y() < -90.0 || lla.y() > 90.0)
+        return false;
+    lla.z() = getHeight(lla.x(), lla.y());
+    return true;
+}
+
+double AnalyticLocationProvider::getHeight(double lon, double lat)
+{
+    // 两组不同波长的正弦起伏，高程范围[0, 2000]米
+    return 1000.0
+        + 600.0 * sin(osg::DegreesToRadians(lon) * 8.0) * cos(osg::DegreesToRadians(lat) * 8.0)
+        + 400.0 * sin(osg::DegreesToRadians(lon + lat) * 30.0);
+}
@@ -0,0 +1,78 @@
+#ifndef LOCATIONPROVIDER_H
+#define LOCATIONPROVIDER_H 1
+
+#include <osgViewer/View>
+#include <osgEarth/MapNode>
+#include <osgEarth/ElevationPool>
+
+/**
+ * 屏幕坐标拾取地理坐标的接口
+ * 绘制工具通过它把窗口坐标转换为经度、纬度和高程，便于在没有渲染环境时替换为其他实现
+ */
+class LocationProvider : public osg::Referenced {
+public:
+    /**
+     * 获取窗口坐标处的地理坐标
+     * @param view 事件所在的视图，实现可以不使用
+     * @param x 窗口坐标x
+     * @param y 窗口坐标y
+     * @param lla 经度、纬度（度）和高程（米）
+     * @return 拾取失败时返回false
+     */
+    virtual bool getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla) = 0;
+};
+
+/**
+ * 与场景求交拾取，结果与屏幕上看到的地形一致
+ */
+class SceneLocationProvider : public LocationProvider {
+public:
+    SceneLocationProvider(osgEarth::MapNode* mapNode, osg::Node::NodeMask intersectionMask = 0x1);
+
+    virtual bool getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla);
+
+private:
+    osg::observer_ptr<osgEarth::MapNode> _mapNode;
+    osg::Node::NodeMask _intersectionMask;
+};
+
+/**
+ * 与椭球求交后从高程池的缓存瓦片中取高程，不遍历场景
+ * 视线与地形的交点通过几次迭代逼近，地形起伏剧烈时与场景求交的结果略有差别
+ */
+class HeightFieldLocationProvider : public LocationProvider {
+public:
+    HeightFieldLocationProvider(osgEarth::MapNode* mapNode, unsigned int lod = 12);
+
+    virtual bool getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla);
+
+private:
+    osg::observer_ptr<osgEarth::MapNode> _mapNode;
+    unsigned int _lod;
+    osg::ref_ptr<osgEarth::ElevationEnvelope> _envelope;
+};
+
+/**
+ * 解析地形，不需要视图和地图数据
+ * 窗口坐标线性映射到给定经纬度范围，高程由固定的解析函数给出，结果完全确定，用于测试和基准
+ */
+class AnalyticLocationProvider : public LocationProvider {
+public:
+    /**
+     * @param west,south,east,north 窗口对应的经纬度范围（度）
+     * @param width,height 窗口大小（像素）
+     */
+    AnalyticLocationProvider(double west, double south, double east, double north,
+        double width, double height);
+
+    virtual bool getLocationAt(osgViewer::View* view, double x, double y, osg::Vec3d& lla);
+
+    // 解析地形在经纬度处的高程（米）
+    static double getHeight(double lon, double lat);
+
+private:
+    double _west, _south, _east, _north;
+    double _width, _height;
+};
+
+#endif
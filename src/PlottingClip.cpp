@@ -0,0 +1,194 @@
+#include "PlottingClip.h"
+
+namespace {
+
+enum Boundary { LEFT, RIGHT, BOTTOM, TOP };
+
+inline bool inside(const osg::Vec2& p, Boundary boundary, float value)
+{
+    switch (boundary) {
+    case LEFT: return p.x() >= value;
+    case RIGHT: return p.x() <= value;
+    case BOTTOM: return p.y() >= value;
+    default: return p.y() <= value;
+    }
+}
+
+// p、q分别在边界两侧，求与边界的交点
+inline osg::Vec2 intersect(const osg::Vec2& p, const osg::Vec2& q, Boundary boundary, float value)
+{
+    if (boundary == LEFT || boundary == RIGHT) {
+        float t = (value - p.x()) / (q.x() - p.x());
+        return osg::Vec2(value, p.y() + (q.y() - p.y()) * t);
+    }
+    float t = (value - p.y()) / (q.y() - p.y());
+    return osg::Vec2(p.x() + (q.x() - p.x()) * t, value);
+}
+
+// Sutherland-Hodgman的一趟：用一条轴对齐的边界裁剪
+void clipAgainst(const Math::LineString& in, Math::LineString& out, Boundary boundary, float value)
+{
+    out.clear();
+    if (in.empty())
+        return;
+    osg::Vec2 prev = in.back();
+    bool prevInside = inside(prev, boundary, value);
+    for (unsigned int i = 0; i < in.size(); i++) {
+        const osg::Vec2& cur = in[i];
+        bool curInside = inside(cur, boundary, value);
+        if (curInside != prevInside)
+            out.push_back(intersect(prev, cur, boundary, value));
+        if (curInside)
+            out.push_back(cur);
+        prev = cur;
+        prevInside = curInside;
+    }
+}
+
+inline float cross(const osg::Vec2& a, const osg::Vec2& b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+}
+
+Math::Extent Math::calculateExtent(const LineString& points)
+{
+    Extent extent;
+    if (points.empty())
+        return extent;
+    extent = Extent(points[0].x(), points[0].y(), points[0].x(), points[0].y());
+    for (unsigned int i = 1; i < points.size(); i++) {
+        extent.xMin = osg::minimum(extent.xMin, points[i].x());
+        extent.xMax = osg::maximum(extent.xMax, points[i].x());
+        extent.yMin = osg::minimum(extent.yMin, points[i].y());
+        extent.yMax = osg::maximum(extent.yMax, points[i].y());
+    }
+    return extent;
+}
+
+void Math::clipPolygon(const LineString& ring, const Extent& extent, LineString& result)
+{
+    result.clear();
+    Extent bound = calculateExtent(ring);
+    if (!bound.valid() || !extent.intersects(bound))
+        return;
+    if (extent.contains(bound)) {
+        result = ring;
+        return;
+    }
+
+    //只对被越过的边界做一趟
+    LineString buffer;
+    result = ring;
+    if (bound.xMin < extent.xMin) {
+        clipAgainst(result, buffer, LEFT, extent.xMin);
+        result.swap(buffer);
+    }
+    if (bound.xMax > extent.xMax) {
+        clipAgainst(result, buffer, RIGHT, extent.xMax);
+        result.swap(buffer);
+    }
+    if (bound.yMin < extent.yMin) {
+        clipAgainst(result, buffer, BOTTOM, extent.yMin);
+        result.swap(buffer);
+    }
+    if (bound.yMax > extent.yMax) {
+        clipAgainst(result, buffer, TOP, extent.yMax);
+        result.swap(buffer);
+    }
+    if (result.size() < 3)
+        result.clear();
+}
+
+void Math::clipPolygon(const LineString& ring, const LineString& region, LineString& result)
+{
+    result.clear();
+    if (ring.size() < 3 || region.size() < 3)
+        return;
+
+    //区域的环绕方向，逆时针时内侧在边的左边
+    float area = 0.0f;
+    for (unsigned int i = 0, j = region.size() - 1; i < region.size(); j = i++)
+        area += cross(region[j], region[i]);
+    const float side = area >= 0.0f ? 1.0f : -1.0f;
+
+    LineString buffer;
+    result = ring;
+    for (unsigned int i = 0, j = region.size() - 1; i < region.size() && !result.empty(); j = i++) {
+        const osg::Vec2& a = region[j];
+        const osg::Vec2 edge = region[i] - a;
+        buffer.clear();
+        osg::Vec2 prev = result.back();
+        float prevSide = side * cross(edge, prev - a);
+        for (unsigned int k = 0; k < result.size(); k++) {
+            const osg::Vec2& cur = result[k];
+            float curSide = side * cross(edge, cur - a);
+            if ((curSide >= 0.0f) != (prevSide >= 0.0f))
+                buffer.push_back(prev + (cur - prev) * (prevSide / (prevSide - curSide)));
+            if (curSide >= 0.0f)
+                buffer.push_back(cur);
+            prev = cur;
+            prevSide = curSide;
+        }
+        result.swap(buffer);
+    }
+    if (result.size() < 3)
+        result.clear();
+}
+
+void Math::clipLineString(const LineString& line, const Extent& extent, MultiLineString& result)
+{
+    if (line.size() < 2)
+        return;
+    Extent bound = calculateExtent(line);
+    if (!extent.intersects(bound))
+        return;
+    if (extent.contains(bound)) {
+        result.push_back(line);
+        return;
+    }
+
+    //Liang-Barsky，上一段的终点在范围内时本段接在当前折线后面
+    bool open = false;
+    for (unsigned int i = 1; i < line.size(); i++) {
+        const osg::Vec2& p0 = line[i-1];
+        const osg::Vec2& p1 = line[i];
+        const float dx = p1.x() - p0.x(), dy = p1.y() - p0.y();
+        const float p[4] = { -dx, dx, -dy, dy };
+        const float q[4] = { p0.x() - extent.xMin, extent.xMax - p0.x(), p0.y() - extent.yMin, extent.yMax - p0.y() };
+        float t0 = 0.0f, t1 = 1.0f;
+        bool visible = true;
+        for (int k = 0; k < 4 && visible; k++) {
+            if (p[k] == 0.0f) {
+                visible = q[k] >= 0.0f;
+            } else {
+                float t = q[k] / p[k];
+                if (p[k] < 0.0f)
+                    t0 = osg::maximum(t0, t);
+                else
+                    t1 = osg::minimum(t1, t);
+                visible = t0 <= t1;
+            }
+        }
+        if (!visible) {
+            open = false;
+            continue;
+        }
+
+        if (!open || t0 > 0.0f) {
+            result.push_back(LineString());
+            result.back().push_back(t0 > 0.0f ? p0 + osg::Vec2(dx, dy) * t0 : p0);
+        }
+        result.back().push_back(t1 < 1.0f ? p0 + osg::Vec2(dx, dy) * t1 : p1);
+        open = t1 >= 1.0f;
+    }
+}
+
+Math::MultiLineString Math::clipMultiLineString(const MultiLineString& multiLine, const Extent& extent)
+{
+    MultiLineString result;
+    for (unsigned int i = 0; i < multiLine.size(); i++)
+        clipLineString(multiLine[i], extent, result);
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef PLOTTINGCLIP_H
+#define PLOTTINGCLIP_H
+
+#include "PlottingMath.h"
+
+/**
+ * 符号外形的裁剪
+ * 多边形用Sutherland-Hodgman逐边裁剪，裁剪区域必须是凸的（矩形范围、视图足迹四边形）；
+ * 折线用Liang-Barsky逐段裁剪，跨出范围后再进入时断成多条。
+ * 先比较外形的包围盒：完全在范围内时原样保留，完全在范围外时直接清空，只有跨越边界的外形才逐边计算。
+ */
+namespace Math {
+
+// 轴对齐的经纬度范围
+struct Extent {
+    Extent() : xMin(1.0f), yMin(1.0f), xMax(-1.0f), yMax(-1.0f) {}
+    Extent(float x0, float y0, float x1, float y1) : xMin(x0), yMin(y0), xMax(x1), yMax(y1) {}
+
+    bool valid() const { return xMin <= xMax && yMin <= yMax; }
+    bool contains(const Extent& other) const
+    {
+        return other.xMin >= xMin && other.xMax <= xMax && other.yMin >= yMin && other.yMax <= yMax;
+    }
+    bool intersects(const Extent& other) const
+    {
+        return other.xMin <= xMax && other.xMax >= xMin && other.yMin <= yMax && other.yMax >= yMin;
+    }
+    // 向四周各扩展宽高的ratio倍
+    Extent expanded(float ratio) const
+    {
+        float dx = (xMax - xMin) * ratio, dy = (yMax - yMin) * ratio;
+        return Extent(xMin - dx, yMin - dy, xMax + dx, yMax + dy);
+    }
+
+    float xMin, yMin, xMax, yMax;
+};
+
+// 点集的包围范围，点集为空时返回无效范围
+Extent calculateExtent(const LineString& points);
+
+/**
+ * 用凸多边形区域裁剪多边形
+ * @param ring 多边形外环，首尾点不必重复
+ * @param region 凸的裁剪区域，顺时针、逆时针均可
+ * @param result 裁剪后的外环，完全在区域外时为空
+ * 凹多边形被裁成多块时，各块之间以沿区域边界的退化边相连
+ */
+void clipPolygon(const LineString& ring, const LineString& region, LineString& result);
+// 用矩形范围裁剪多边形
+void clipPolygon(const LineString& ring, const Extent& extent, LineString& result);
+
+/**
+ * 用矩形范围裁剪折线
+ * @param result 追加落在范围内的各段折线
+ */
+void clipLineString(const LineString& line, const Extent& extent, MultiLineString& result);
+MultiLineString clipMultiLineString(const MultiLineString& multiLine, const Extent& extent);
+
+}
+
+#endif
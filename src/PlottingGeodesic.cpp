@@ -0,0 +1,487 @@
+#include "PlottingGeodesic.h"
+#include "PlottingWrap.h"
+#include <osg/Timer>
+#include <string.h>
+#include <iomanip>
+#include <ostream>
+
+#define LC "[Geodesic] "
+
+namespace {
+
+const double DEG = osg::PI / 180.0;
+// 快速解的固定迭代次数
+const int FAST_INVERSE_ITERATIONS = 2;
+const int FAST_DIRECT_ITERATIONS = 2;
+// 快速反解在近对径点附近不收敛，更长的边由精确解加密
+const double FAST_INVERSE_RANGE = 1.5e7;
+// 精确解的收敛条件
+const int MAX_ITERATIONS = 200;
+const double CONVERGENCE = 1.0e-12;
+
+// 弧度归到[-π, π)
+inline double wrapRadians(double x)
+{
+    return x - 2.0 * osg::PI * floor((x + osg::PI) / (2.0 * osg::PI));
+}
+
+// 归化纬度的正弦和余弦，在极点也不需要tan
+inline void reducedLatitude(double lat, double f, double& sinU, double& cosU)
+{
+    double s = (1.0 - f) * sin(lat), c = cos(lat);
+    double r = sqrt(s * s + c * c);
+    sinU = s / r;
+    cosU = c / r;
+}
+
+// 反解中与辅助球面上经差lambda相关的量
+struct InverseTerms {
+    double sinLambda, cosLambda;
+    double sinSigma, cosSigma, sigma;
+    double sinAlpha, cos2Alpha; // 大地线在赤道处的方位角
+    double cos2SigmaM;
+};
+
+inline void evaluateInverse(double lambda, double sinU1, double cosU1, double sinU2, double cosU2, InverseTerms& t)
+{
+    t.sinLambda = sin(lambda);
+    t.cosLambda = cos(lambda);
+    double x = cosU2 * t.sinLambda, y = cosU1 * sinU2 - sinU1 * cosU2 * t.cosLambda;
+    t.sinSigma = sqrt(x * x + y * y);
+    t.cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * t.cosLambda;
+    t.sigma = atan2(t.sinSigma, t.cosSigma);
+    // 重合点和沿赤道的大地线上分母为0，对应的项乘以0，取极小值避免除零而不需要分支
+    t.sinAlpha = cosU1 * cosU2 * t.sinLambda / osg::maximum(t.sinSigma, 1.0e-300);
+    t.cos2Alpha = 1.0 - t.sinAlpha * t.sinAlpha;
+    t.cos2SigmaM = t.cosSigma - 2.0 * sinU1 * sinU2 / osg::maximum(t.cos2Alpha, 1.0e-300);
+}
+
+// 辅助球面与椭球面的经差之差
+inline double longitudeCorrection(double f, double sigma, double sinSigma, double cosSigma, double sinAlpha, double cos2Alpha, double cos2SigmaM)
+{
+    double C = f / 16.0 * cos2Alpha * (4.0 + f * (4.0 - 3.0 * cos2Alpha));
+    return (1.0 - C) * f * sinAlpha * (sigma + C * sinSigma * (cos2SigmaM + C * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+}
+
+inline void seriesAB(double u2, double& A, double& B)
+{
+    A = 1.0 + u2 / 16384.0 * (4096.0 + u2 * (-768.0 + u2 * (320.0 - 175.0 * u2)));
+    B = u2 / 1024.0 * (256.0 + u2 * (-128.0 + u2 * (74.0 - 47.0 * u2)));
+}
+
+inline double deltaSigma(double B, double sinSigma, double cosSigma, double cos2SigmaM)
+{
+    return B * sinSigma * (cos2SigmaM + B / 4.0 * (cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)
+        - B / 6.0 * cos2SigmaM * (-3.0 + 4.0 * sinSigma * sinSigma) * (-3.0 + 4.0 * cos2SigmaM * cos2SigmaM)));
+}
+
+// 经差lambda收敛后的距离
+inline double inverseDistance(const InverseTerms& t, double b, double ep2)
+{
+    double A, B;
+    seriesAB(t.cos2Alpha * ep2, A, B);
+    return b * A * (t.sigma - deltaSigma(B, t.sinSigma, t.cosSigma, t.cos2SigmaM));
+}
+
+// 起点和方位角确定的大地线，正解和加密共用
+struct LineTerms {
+    double sinU1, cosU1;
+    double sinAzimuth, cosAzimuth;
+    double sigma1; // 起点到赤道交点的角距离
+    double sinAlpha, cos2Alpha;
+    double A, B, bA;
+};
+
+inline void setupLine(double f, double b, double ep2, double lat1, double azimuth1, LineTerms& l)
+{
+    reducedLatitude(lat1, f, l.sinU1, l.cosU1);
+    l.sinAzimuth = sin(azimuth1);
+    l.cosAzimuth = cos(azimuth1);
+    l.sigma1 = atan2(l.sinU1, l.cosU1 * l.cosAzimuth);
+    l.sinAlpha = l.cosU1 * l.sinAzimuth;
+    l.cos2Alpha = 1.0 - l.sinAlpha * l.sinAlpha;
+    seriesAB(l.cos2Alpha * ep2, l.A, l.B);
+    l.bA = b * l.A;
+}
+
+// 由角距离sigma求经差和纬度（弧度）
+inline void linePosition(const LineTerms& l, double f, double sigma, double& dlon, double& lat)
+{
+    double sinSigma = sin(sigma), cosSigma = cos(sigma);
+    double cos2SigmaM = cos(2.0 * l.sigma1 + sigma);
+    double x = l.sinU1 * sinSigma - l.cosU1 * cosSigma * l.cosAzimuth;
+    lat = atan2(l.sinU1 * cosSigma + l.cosU1 * sinSigma * l.cosAzimuth, (1.0 - f) * sqrt(l.sinAlpha * l.sinAlpha + x * x));
+    double lambda = atan2(sinSigma * l.sinAzimuth, l.cosU1 * cosSigma - l.sinU1 * sinSigma * l.cosAzimuth);
+    dlon = lambda - longitudeCorrection(f, sigma, sinSigma, cosSigma, l.sinAlpha, l.cos2Alpha, cos2SigmaM);
+}
+
+// 距离对应的角距离，迭代到收敛或iterations次
+inline double lineSigma(const LineTerms& l, double distance, int iterations)
+{
+    const double sigma0 = distance / l.bA;
+    double sigma = sigma0;
+    for (int k = 0; k < iterations; k++) {
+        double next = sigma0 + deltaSigma(l.B, sin(sigma), cos(sigma), cos(2.0 * l.sigma1 + sigma));
+        bool converged = fabs(next - sigma) < CONVERGENCE;
+        sigma = next;
+        if (converged)
+            break;
+    }
+    return sigma;
+}
+
+// 角距离对应的距离，不需要迭代
+inline double lineDistance(const LineTerms& l, double sigma)
+{
+    return l.bA * (sigma - deltaSigma(l.B, sin(sigma), cos(sigma), cos(2.0 * l.sigma1 + sigma)));
+}
+
+// 固定次数迭代的正解
+inline void fastLinePosition(const LineTerms& l, double f, double distance, double& dlon, double& lat)
+{
+    double sigma0 = distance / l.bA, sigma = sigma0;
+    for (int k = 0; k < FAST_DIRECT_ITERATIONS; k++)
+        sigma = sigma0 + deltaSigma(l.B, sin(sigma), cos(sigma), cos(2.0 * l.sigma1 + sigma));
+    linePosition(l, f, sigma, dlon, lat);
+}
+
+/**
+ * 在(0, sigma12)内按角距离等分取count-1个点追加到points，经度相对lon0（度）
+ * 按角距离而不是距离等分，不需要迭代；sigma和2*sigma1+sigma的正余弦用旋转递推，每点只剩两次atan2
+ */
+void appendLine(const LineTerms& l, double f, double sigma12, unsigned int count, float lon0, Math::LineString& points)
+{
+    const double step = sigma12 / count;
+    const double cs = cos(step), sn = sin(step);
+    double sinSigma = 0.0, cosSigma = 1.0;
+    double sin2SigmaM = sin(2.0 * l.sigma1), cos2SigmaM = cos(2.0 * l.sigma1);
+    for (unsigned int k = 1; k < count; k++) {
+        double t = cosSigma * cs - sinSigma * sn;
+        sinSigma = sinSigma * cs + cosSigma * sn;
+        cosSigma = t;
+        t = cos2SigmaM * cs - sin2SigmaM * sn;
+        sin2SigmaM = sin2SigmaM * cs + cos2SigmaM * sn;
+        cos2SigmaM = t;
+
+        double x = l.sinU1 * sinSigma - l.cosU1 * cosSigma * l.cosAzimuth;
+        double lat = atan2(l.sinU1 * cosSigma + l.cosU1 * sinSigma * l.cosAzimuth, (1.0 - f) * sqrt(l.sinAlpha * l.sinAlpha + x * x));
+        double lambda = atan2(sinSigma * l.sinAzimuth, l.cosU1 * cosSigma - l.sinU1 * sinSigma * l.cosAzimuth);
+        double dlon = lambda - longitudeCorrection(f, step * k, sinSigma, cosSigma, l.sinAlpha, l.cos2Alpha, cos2SigmaM);
+        points.push_back(osg::Vec2(lon0 + dlon / DEG, lat / DEG));
+    }
+}
+
+float nextRandom(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+// 两个经纬度（度）在椭球面上的直线距离，用于比较位置误差
+double chordDistance(double a, double f, double lon1, double lat1, double lon2, double lat2)
+{
+    const double e2 = f * (2.0 - f);
+    double p[2][3];
+    const double lon[2] = { lon1 * DEG, lon2 * DEG }, lat[2] = { lat1 * DEG, lat2 * DEG };
+    for (int i = 0; i < 2; i++) {
+        double n = a / sqrt(1.0 - e2 * sin(lat[i]) * sin(lat[i]));
+        p[i][0] = n * cos(lat[i]) * cos(lon[i]);
+        p[i][1] = n * cos(lat[i]) * sin(lon[i]);
+        p[i][2] = n * (1.0 - e2) * sin(lat[i]);
+    }
+    return sqrt((p[0][0] - p[1][0]) * (p[0][0] - p[1][0]) + (p[0][1] - p[1][1]) * (p[0][1] - p[1][1]) + (p[0][2] - p[1][2]) * (p[0][2] - p[1][2]));
+}
+
+// 球面大圆的距离和起点方位角，作为对照
+void sphericalInverse(double radius, double lon1, double lat1, double lon2, double lat2, double& distance, double& azimuth1)
+{
+    double phi1 = lat1 * DEG, phi2 = lat2 * DEG, dl = (lon2 - lon1) * DEG;
+    double s = sin((phi2 - phi1) / 2.0), t = sin(dl / 2.0);
+    double h = s * s + cos(phi1) * cos(phi2) * t * t;
+    distance = 2.0 * radius * asin(sqrt(osg::minimum(h, 1.0)));
+    azimuth1 = atan2(sin(dl) * cos(phi2), cos(phi1) * sin(phi2) - sin(phi1) * cos(phi2) * cos(dl)) / DEG;
+}
+
+double angleError(double a, double b)
+{
+    return fabs(wrapRadians((a - b) * DEG)) / DEG;
+}
+}
+
+namespace Math {
+
+Geodesic::Geodesic(double a, double f)
+    : _a(a)
+    , _f(f)
+    , _b(a * (1.0 - f))
+{
+    _ep2 = (_a * _a - _b * _b) / (_b * _b);
+}
+
+bool Geodesic::inverse(double lon1, double lat1, double lon2, double lat2, double& distance, double& azimuth1, double& azimuth2) const
+{
+    double sinU1, cosU1, sinU2, cosU2;
+    reducedLatitude(lat1 * DEG, _f, sinU1, cosU1);
+    reducedLatitude(lat2 * DEG, _f, sinU2, cosU2);
+    const double L = wrapRadians((lon2 - lon1) * DEG);
+
+    InverseTerms t;
+    double lambda = L;
+    int k = 0;
+    for (; k < MAX_ITERATIONS; k++) {
+        evaluateInverse(lambda, sinU1, cosU1, sinU2, cosU2, t);
+        if (t.sinSigma == 0.0) {
+            distance = azimuth1 = azimuth2 = 0.0;
+            return true;
+        }
+        double next = L + longitudeCorrection(_f, t.sigma, t.sinSigma, t.cosSigma, t.sinAlpha, t.cos2Alpha, t.cos2SigmaM);
+        bool converged = fabs(next - lambda) < CONVERGENCE;
+        lambda = next;
+        if (converged)
+            break;
+    }
+    if (k == MAX_ITERATIONS)
+        return false;
+
+    evaluateInverse(lambda, sinU1, cosU1, sinU2, cosU2, t);
+    distance = inverseDistance(t, _b, _ep2);
+    azimuth1 = atan2(cosU2 * t.sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * t.cosLambda) / DEG;
+    azimuth2 = atan2(cosU1 * t.sinLambda, -sinU1 * cosU2 + cosU1 * sinU2 * t.cosLambda) / DEG;
+    return true;
+}
+
+bool Geodesic::direct(double lon1, double lat1, double azimuth1, double distance, double& lon2, double& lat2) const
+{
+    LineTerms l;
+    setupLine(_f, _b, _ep2, lat1 * DEG, azimuth1 * DEG, l);
+    double dlon, lat;
+    linePosition(l, _f, lineSigma(l, distance, MAX_ITERATIONS), dlon, lat);
+    lon2 = wrapRadians(lon1 * DEG + dlon) / DEG;
+    lat2 = lat / DEG;
+    return true;
+}
+
+void Geodesic::fastInverse(double lon1, double lat1, double lon2, double lat2, double& distance, double& azimuth1) const
+{
+    double sinU1, cosU1, sinU2, cosU2;
+    reducedLatitude(lat1 * DEG, _f, sinU1, cosU1);
+    reducedLatitude(lat2 * DEG, _f, sinU2, cosU2);
+    const double L = wrapRadians((lon2 - lon1) * DEG);
+
+    InverseTerms t;
+    double lambda = L;
+    for (int k = 0; k < FAST_INVERSE_ITERATIONS; k++) {
+        evaluateInverse(lambda, sinU1, cosU1, sinU2, cosU2, t);
+        lambda = L + longitudeCorrection(_f, t.sigma, t.sinSigma, t.cosSigma, t.sinAlpha, t.cos2Alpha, t.cos2SigmaM);
+    }
+    evaluateInverse(lambda, sinU1, cosU1, sinU2, cosU2, t);
+    distance = inverseDistance(t, _b, _ep2);
+    azimuth1 = atan2(cosU2 * t.sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * t.cosLambda) / DEG;
+}
+
+void Geodesic::fastInverse(const double* lon1, const double* lat1, const double* lon2, const double* lat2, unsigned int n,
+    double* distance, double* azimuth1) const
+{
+    for (unsigned int i = 0; i < n; i++)
+        fastInverse(lon1[i], lat1[i], lon2[i], lat2[i], distance[i], azimuth1[i]);
+}
+
+void Geodesic::fastDirect(double lon1, double lat1, double azimuth1, double distance, double& lon2, double& lat2) const
+{
+    LineTerms l;
+    setupLine(_f, _b, _ep2, lat1 * DEG, azimuth1 * DEG, l);
+    double dlon, lat;
+    fastLinePosition(l, _f, distance, dlon, lat);
+    lon2 = wrapRadians(lon1 * DEG + dlon) / DEG;
+    lat2 = lat / DEG;
+}
+
+void Geodesic::fastDirect(const double* lon1, const double* lat1, const double* azimuth1, const double* distance, unsigned int n,
+    double* lon2, double* lat2) const
+{
+    for (unsigned int i = 0; i < n; i++)
+        fastDirect(lon1[i], lat1[i], azimuth1[i], distance[i], lon2[i], lat2[i]);
+}
+
+void Geodesic::densify(const LineString& line, bool closed, double maxSegment, LineString& result) const
+{
+    const unsigned int n = line.size();
+    if (n < 2 || maxSegment <= 0.0) {
+        result = line;
+        return;
+    }
+
+    // 边长的上界：先沿纬圈再沿子午线，两段的曲率半径都不超过a/(1-f)
+    const double metersPerDegree = _a / (1.0 - _f) * DEG;
+    // 按角距离等分时各段的长度相差不超过1/(1-f)倍，点数按最长的一段取
+    const unsigned int edges = closed ? n : n - 1;
+    result.clear();
+    result.reserve(n);
+    LineTerms l;
+    for (unsigned int i = 0; i < edges; i++) {
+        // 每个顶点相对上一个输出点展开，跨越日期变更线时经度保持连续
+        osg::Vec2 p = line[i];
+        if (!result.empty())
+            p.x() = unwrapLongitude(p.x(), result.back().x());
+        const osg::Vec2& q = line[(i + 1) % n];
+        result.push_back(p);
+        double dlon = fabs(wrapRadians((q.x() - p.x()) * DEG)) / DEG;
+        if ((dlon + fabs(q.y() - p.y())) * metersPerDegree <= maxSegment)
+            continue;
+
+        double distance, azimuth, azimuth2;
+        fastInverse(p.x(), p.y(), q.x(), q.y(), distance, azimuth);
+        // 近对径点没有唯一的大地线，精确解也不收敛时保留原来的边
+        if (distance > FAST_INVERSE_RANGE && !inverse(p.x(), p.y(), q.x(), q.y(), distance, azimuth, azimuth2))
+            continue;
+        const unsigned int count = (unsigned int)ceil(distance / (maxSegment * (1.0 - _f)));
+        if (count < 2)
+            continue;
+        setupLine(_f, _b, _ep2, p.y() * DEG, azimuth * DEG, l);
+        // 经差在±180度内，相对起点展开
+        appendLine(l, _f, lineSigma(l, distance, MAX_ITERATIONS), count, p.x(), result);
+    }
+    if (!closed)
+        result.push_back(osg::Vec2(unwrapLongitude(line.back().x(), result.back().x()), line.back().y()));
+}
+
+void Geodesic::densify(MultiLineString& outline, double maxSegment) const
+{
+    const bool closed = outline.size() == 1;
+    LineString result;
+    for (unsigned int i = 0; i < outline.size(); i++) {
+        densify(outline[i], closed, maxSegment, result);
+        outline[i].swap(result);
+    }
+}
+
+bool Geodesic::bench(std::ostream& log, unsigned int samples)
+{
+    if (samples == 0)
+        return false;
+
+    const Geodesic geodesic;
+    const double radius = (2.0 * geodesic._a + geodesic._b) / 3.0;
+
+    // 起点在球面上均匀分布，方位角均匀，距离在1公里到20000公里之间对数均匀；终点由精确正解求得
+    std::vector<double> lon1(samples), lat1(samples), azimuth(samples), distance(samples), lon2(samples), lat2(samples);
+    unsigned int state = 11;
+    for (unsigned int i = 0; i < samples; i++) {
+        lon1[i] = nextRandom(state) * 360.0 - 180.0;
+        lat1[i] = asin(nextRandom(state) * 2.0 - 1.0) / DEG;
+        azimuth[i] = nextRandom(state) * 360.0 - 180.0;
+        distance[i] = 1000.0 * pow(20000.0, (double)nextRandom(state));
+        geodesic.direct(lon1[i], lat1[i], azimuth[i], distance[i], lon2[i], lat2[i]);
+    }
+
+    // 各算法的耗时
+    osg::Timer* timer = osg::Timer::instance();
+    std::vector<double> s(samples), a(samples), lon(samples), lat(samples);
+    unsigned int failures = 0;
+    osg::Timer_t t0 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++) {
+        double azimuth2;
+        if (!geodesic.inverse(lon1[i], lat1[i], lon2[i], lat2[i], s[i], a[i], azimuth2))
+            failures++;
+    }
+    osg::Timer_t t1 = timer->tick();
+    geodesic.fastInverse(&lon1[0], &lat1[0], &lon2[0], &lat2[0], samples, &s[0], &a[0]);
+    osg::Timer_t t2 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++)
+        sphericalInverse(radius, lon1[i], lat1[i], lon2[i], lat2[i], s[i], a[i]);
+    osg::Timer_t t3 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++)
+        geodesic.direct(lon1[i], lat1[i], azimuth[i], distance[i], lon[i], lat[i]);
+    osg::Timer_t t4 = timer->tick();
+    geodesic.fastDirect(&lon1[0], &lat1[0], &azimuth[0], &distance[0], samples, &lon[0], &lat[0]);
+    osg::Timer_t t5 = timer->tick();
+
+    // 加密：每条大地线按10公里一段，与逐点精确正解的耗时比较
+    const double segment = 1.0e4;
+    LineString line(2), result;
+    unsigned int points = 0, exactPoints = 0;
+    osg::Timer_t t6 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++) {
+        line[0].set(lon1[i], lat1[i]);
+        line[1].set(lon2[i], lat2[i]);
+        geodesic.densify(line, false, segment, result);
+        points += result.size();
+    }
+    osg::Timer_t t7 = timer->tick();
+    for (unsigned int i = 0; i < samples && exactPoints < points / 10; i++) {
+        const unsigned int count = (unsigned int)ceil(distance[i] / segment);
+        for (unsigned int k = 1; k < count; k++)
+            geodesic.direct(lon1[i], lat1[i], azimuth[i], distance[i] * k / count, lon[0], lat[0]);
+        exactPoints += count + 1;
+    }
+    osg::Timer_t t8 = timer->tick();
+
+    const double nsPerSample = 1.0e6 / samples;
+    log << LC << samples << " random geodesics of 1 to 20000 km, " << failures << " exact inverse failures (nearly antipodal)" << std::endl;
+    log << LC << std::fixed << std::setprecision(1)
+        << "inverse: exact " << timer->delta_m(t0, t1) * nsPerSample << " ns, fast " << timer->delta_m(t1, t2) * nsPerSample
+        << " ns, spherical " << timer->delta_m(t2, t3) * nsPerSample << " ns" << std::endl;
+    log << LC << "direct: exact " << timer->delta_m(t3, t4) * nsPerSample << " ns, fast " << timer->delta_m(t4, t5) * nsPerSample
+        << " ns" << std::endl;
+    log << LC << "densify to " << segment / 1000.0 << " km: " << points << " points, fast " << timer->delta_m(t6, t7) * 1.0e6 / points
+        << " ns per point, exact direct " << timer->delta_m(t7, t8) * 1.0e6 / osg::maximum(exactPoints, 1u) << " ns per point" << std::endl;
+
+    // 各距离段的最大误差
+    const double limits[] = { 1.0e5, 1.0e6, 5.0e6, 1.0e7, FAST_INVERSE_RANGE, 2.0e7 };
+    const unsigned int groups = sizeof(limits) / sizeof(limits[0]);
+    struct Errors {
+        unsigned int count;
+        double fastDistance, fastAzimuth, fastDirect, line, sphereDistance, sphereAzimuth;
+    };
+    std::vector<Errors> errors(groups);
+    memset(&errors[0], 0, sizeof(Errors) * groups);
+    LineTerms l;
+    for (unsigned int i = 0; i < samples; i++) {
+        unsigned int g = 0;
+        while (g + 1 < groups && distance[i] > limits[g])
+            g++;
+        Errors& e = errors[g];
+        e.count++;
+
+        double fs, fa;
+        geodesic.fastInverse(lon1[i], lat1[i], lon2[i], lat2[i], fs, fa);
+        e.fastDistance = osg::maximum(e.fastDistance, fabs(fs - distance[i]));
+        e.fastAzimuth = osg::maximum(e.fastAzimuth, angleError(fa, azimuth[i]));
+
+        double flon, flat;
+        geodesic.fastDirect(lon1[i], lat1[i], azimuth[i], distance[i], flon, flat);
+        e.fastDirect = osg::maximum(e.fastDirect, chordDistance(geodesic._a, geodesic._f, flon, flat, lon2[i], lat2[i]));
+
+        // 加密点：与densify相同，在快速反解（过长时为精确反解）得到的大地线上按角距离取点，
+        // 与同一距离处的精确正解比较
+        double azimuth2;
+        if (fs > FAST_INVERSE_RANGE && !geodesic.inverse(lon1[i], lat1[i], lon2[i], lat2[i], fs, fa, azimuth2))
+            continue;
+        setupLine(geodesic._f, geodesic._b, geodesic._ep2, lat1[i] * DEG, fa * DEG, l);
+        const double sigma12 = lineSigma(l, fs, MAX_ITERATIONS);
+        for (unsigned int k = 1; k < 8; k++) {
+            double dl, pl, elon, elat;
+            linePosition(l, geodesic._f, sigma12 * k / 8.0, dl, pl);
+            geodesic.direct(lon1[i], lat1[i], azimuth[i], lineDistance(l, sigma12 * k / 8.0), elon, elat);
+            e.line = osg::maximum(e.line, chordDistance(geodesic._a, geodesic._f, lon1[i] + dl / DEG, pl / DEG, elon, elat));
+        }
+
+        double ss, sa;
+        sphericalInverse(radius, lon1[i], lat1[i], lon2[i], lat2[i], ss, sa);
+        e.sphereDistance = osg::maximum(e.sphereDistance, fabs(ss - distance[i]));
+        e.sphereAzimuth = osg::maximum(e.sphereAzimuth, angleError(sa, azimuth[i]));
+    }
+
+    log << LC << "max errors (distance m, azimuth arc seconds, position m):" << std::endl;
+    for (unsigned int g = 0; g < groups; g++) {
+        const Errors& e = errors[g];
+        log << LC << "  <= " << std::setw(5) << std::setprecision(0) << limits[g] / 1000.0 << " km " << std::setw(6) << e.count
+            << std::setprecision(4) << "  fast inverse " << std::setw(10) << e.fastDistance << " m " << std::setw(9) << e.fastAzimuth * 3600.0 << "\""
+            << "  fast direct " << std::setw(9) << e.fastDirect << " m"
+            << "  line " << std::setw(9) << e.line << " m"
+            << std::setprecision(1) << "  sphere " << std::setw(9) << e.sphereDistance << " m " << std::setw(7) << e.sphereAzimuth * 3600.0 << "\"" << std::endl;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef PLOTTINGGEODESIC_H
+#define PLOTTINGGEODESIC_H
+
+#include <iosfwd>
+
+#include "PlottingMath.h"
+
+/**
+ * 椭球面上的大地线
+ * 生成函数把经纬度当作平面坐标，战区尺度的箭头和航线在经纬度中画成直线，与大地线相差可达数十公里。
+ * 大地线模式下把外形的各边加密为大地线，加密点由快速近似解计算。
+ *
+ * 精确解为Vincenty公式迭代到收敛，作为基准，近对径点不收敛时返回false。
+ * 快速解使用同样的级数，但只迭代固定的两次，没有依赖数据的收敛判断。WGS84上随机点对的最大误差（--geodesic-bench）：
+ *   反解：10000公里内距离0.4米、方位角0.01角秒，15000公里内1米；更远时接近对径点，收敛变慢，误差迅速增大；
+ *   正解：位置2厘米；
+ *   加密点：10000公里内0.2米，每点约为逐点精确正解耗时的1/6。
+ * 外形的坐标是float，经度180度附近本身只有约1米的精度，上述误差都在其下。
+ * 经纬度、方位角的单位为度，方位角从北顺时针，距离单位为米。
+ */
+namespace Math {
+
+class Geodesic {
+public:
+    // 默认为WGS84
+    Geodesic(double a = 6378137.0, double f = 1.0 / 298.257223563);
+
+    double getEquatorRadius() const { return _a; }
+    double getFlattening() const { return _f; }
+
+    // 精确反解，不收敛时返回false
+    bool inverse(double lon1, double lat1, double lon2, double lat2, double& distance, double& azimuth1, double& azimuth2) const;
+    // 精确正解，lon2与lon1相差不超过180度
+    bool direct(double lon1, double lat1, double azimuth1, double distance, double& lon2, double& lat2) const;
+
+    // 快速反解
+    void fastInverse(double lon1, double lat1, double lon2, double lat2, double& distance, double& azimuth1) const;
+    // 批量快速反解，各数组长度为n，逐个调用单点接口
+    void fastInverse(const double* lon1, const double* lat1, const double* lon2, const double* lat2, unsigned int n,
+        double* distance, double* azimuth1) const;
+    // 快速正解
+    void fastDirect(double lon1, double lat1, double azimuth1, double distance, double& lon2, double& lat2) const;
+    // 批量快速正解，逐个调用单点接口
+    void fastDirect(const double* lon1, const double* lat1, const double* azimuth1, const double* distance, unsigned int n,
+        double* lon2, double* lat2) const;
+
+    /**
+     * 把折线的各边加密为大地线，相邻点的距离不超过maxSegment
+     * 输入点原样保留；按经纬度估计的长度上界不超过maxSegment的边不求解，贝塞尔采样等短边没有开销。
+     * 超过15000公里的边改用精确反解，近对径点的边保持不变。
+     * 输出的每个点（包括输入点）的经度都相对前一个输出点展开，跨越日期变更线时保持连续，可能超出±180。
+     * @param closed 是否为闭合环，闭合边同样加密，首尾点不必重复
+     */
+    void densify(const LineString& line, bool closed, double maxSegment, LineString& result) const;
+    // 原位加密外形的各部分，只有一部分的外形按闭合环处理，与generateOutline的约定一致
+    void densify(MultiLineString& outline, double maxSegment) const;
+
+    /**
+     * 精度和速度测量：随机点对与精确解比较，报告各距离段的最大误差和每次求解的耗时，
+     * 同时列出球面大圆公式的误差作为对照
+     */
+    static bool bench(std::ostream& log, unsigned int samples = 100000);
+
+private:
+    double _a, _f, _b;
+    double _ep2; // 第二偏心率的平方
+};
+
+}
+
+#endif
@@ -0,0 +1,367 @@
+#ifndef PLOTTINGKERNELS_H
+#define PLOTTINGKERNELS_H
+
+#include "PlottingMath.h"
+#include <array>
+
+/**
+ * 固定控制点数符号的生成核
+ * 控制点以std::array传入，结果写入栈上的定长缓冲FixedLineString（容量为各核的CAPACITY）时
+ * 整个计算不分配内存；输出类型是模板参数，也可以直接写入LineString或SoA的PointBuffer。
+ * 贝塞尔采样数等循环次数都是模板参数，编译器可以展开和向量化，适合批量生成；
+ * 交互绘制的工具在控制点数匹配时也调用这些核，两条路径的结果一致。
+ *
+ * 与原来的向量实现相比：贝塞尔参数t按下标计算而不是逐步累加，
+ * 累加误差导致的、与终点几乎重合的最后一个采样点不再出现；
+ * Cardinal控制点按位置写入，不再过滤恰好为(0,0)的点。
+ */
+namespace Math {
+
+/**
+ * 定长折线，容量在编译期确定，点数不超过Capacity
+ */
+template<unsigned int Capacity>
+class FixedLineString {
+public:
+    enum { CAPACITY = Capacity };
+
+    FixedLineString() : _size(0) {}
+
+    void push_back(const osg::Vec2& point) { _points[_size++] = point; }
+    void clear() { _size = 0; }
+    // 与std::vector接口一致，容量固定，无需预留
+    void reserve(unsigned int) {}
+
+    unsigned int size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const osg::Vec2& operator[](unsigned int i) const { return _points[i]; }
+    const osg::Vec2& back() const { return _points[_size - 1]; }
+    const osg::Vec2* begin() const { return _points; }
+    const osg::Vec2* end() const { return _points + _size; }
+
+private:
+    osg::Vec2 _points[Capacity];
+    unsigned int _size;
+};
+
+// 二次贝塞尔曲线的一段：起点和Part个采样点（t从0开始）
+template<unsigned int Part, class Points>
+inline void appendBezier2(Points& points, const osg::Vec2& pointS, const osg::Vec2& pointC, const osg::Vec2& pointE)
+{
+    points.push_back(pointS);
+    for (unsigned int k = 0; k < Part; k++) {
+        float t = (float)k / Part;
+        points.push_back(osg::Vec2((1-t)*(1-t)*pointS.x()+2*t*(1-t)*pointC.x()+t*t*pointE.x(),
+                                   (1-t)*(1-t)*pointS.y()+2*t*(1-t)*pointC.y()+t*t*pointE.y()));
+    }
+}
+
+// 三次贝塞尔曲线的一段：起点和Part个采样点（t从0开始）
+template<unsigned int Part, class Points>
+inline void appendBezier3(Points& points, const osg::Vec2& pointS, const osg::Vec2& pointC1, const osg::Vec2& pointC2, const osg::Vec2& pointE)
+{
+    points.push_back(pointS);
+    for (unsigned int k = 0; k < Part; k++) {
+        float t = (float)k / Part;
+        points.push_back(osg::Vec2((1-t)*(1-t)*(1-t)*pointS.x()+3*t*(1-t)*(1-t)*pointC1.x()+3*t*t*(1-t)*pointC2.x()+t*t*t*pointE.x(),
+                                   (1-t)*(1-t)*(1-t)*pointS.y()+3*t*(1-t)*(1-t)*pointC1.y()+3*t*t*(1-t)*pointC2.y()+t*t*t*pointE.y()));
+    }
+}
+
+// 终点与最后一个点不同时补上终点，同createBezier2/createBezier3
+template<class Points>
+inline void appendEndPoint(Points& points, const osg::Vec2& pointE)
+{
+    if (points.empty() || points.back() != pointE)
+        points.push_back(pointE);
+}
+
+/**
+ * N个点的闭合Cardinal曲线控制点，同createCloseCardinal
+ * 输出3N+1个点：每个输入点及其左右控制点，首尾为第一个点
+ */
+template<unsigned int N>
+inline void createCloseCardinal(const std::array<osg::Vec2, N>& points, std::array<osg::Vec2, 3*N+1>& cardinalPoints, float tension = 0.4)
+{
+    for (unsigned int j = 0; j < N; j++) {
+        osg::Vec2 p1l, p1r;
+        calculateCardinalControlPoints(points[(j+N-1) % N], points[j], points[(j+1) % N], p1l, p1r, tension);
+        if (j == 0) {
+            cardinalPoints[0] = points[0];
+            cardinalPoints[1] = p1r;
+            cardinalPoints[3*N-1] = p1l;
+            cardinalPoints[3*N] = points[0];
+        } else {
+            cardinalPoints[3*j-1] = p1l;
+            cardinalPoints[3*j] = points[j];
+            cardinalPoints[3*j+1] = p1r;
+        }
+    }
+}
+
+/**
+ * 两个控制点的直箭头，7个点
+ */
+struct StraightArrowKernel {
+    enum { CAPACITY = 7 };
+
+    template<class Points>
+    static void calculate(const std::array<osg::Vec2, 2>& ctrlPts, float ratio, Points& points)
+    {
+        const osg::Vec2& pointS = ctrlPts[0];
+        const osg::Vec2& pointE = ctrlPts[1];
+        //箭头总长度和宽度
+        float l = sqrtf((pointE.y()-pointS.y())*(pointE.y()-pointS.y())+(pointE.x()-pointS.x())*(pointE.x()-pointS.x()));
+        float w = l / ratio;
+        //三角形的底边中心点
+        float x_ = pointS.x() + (pointE.x() - pointS.x())*(ratio-1)/ratio;
+        float y_ = pointS.y() + (pointE.y() - pointS.y())*(ratio-1)/ratio;
+        osg::Vec2 v_l, v_r;
+        calculateVector(osg::Vec2(pointE.x()-pointS.x(),pointE.y()-pointS.y()), osg::PI_2, w/2, v_l, v_r);
+
+        osg::Vec2 point1(pointS.x()+v_l.x(),pointS.y()+v_l.y());
+        osg::Vec2 point2(x_+point1.x()-pointS.x(),y_+point1.y()-pointS.y());
+        osg::Vec2 point7(pointS.x()+v_r.x(),pointS.y()+v_r.y());
+        osg::Vec2 point6(x_+point7.x()-pointS.x(), y_+point7.y()-pointS.y());
+
+        points.clear();
+        points.push_back(point1);
+        points.push_back(point2);
+        points.push_back(osg::Vec2(2*point2.x()-x_, 2*point2.y()-y_));
+        points.push_back(pointE);
+        points.push_back(osg::Vec2(2*point6.x()-x_, 2*point6.y()-y_));
+        points.push_back(point6);
+        points.push_back(point7);
+    }
+};
+
+/**
+ * 两个控制点的聚集地
+ * 6个插值点的闭合Cardinal曲线，按Part采样为6段三次贝塞尔曲线
+ */
+template<unsigned int Part = 100>
+struct GatheringPlaceKernel {
+    enum { CAPACITY = 6*(Part+1)+1 };
+
+    template<class Points>
+    static void calculate(const std::array<osg::Vec2, 2>& ctrlPts, Points& points)
+    {
+        const osg::Vec2& originP = ctrlPts[0];
+        const osg::Vec2& lastP = ctrlPts[1];
+        osg::Vec2 vectorOL(lastP.x()-originP.x(), lastP.y()-originP.y());
+        float dOL = sqrtf(vectorOL.x() * vectorOL.x()+vectorOL.y() * vectorOL.y());
+
+        osg::Vec2 v_l, v_r;
+        std::array<osg::Vec2, 6> interPoints;
+        interPoints[0] = originP;
+        //第一个插值控制点，与向量originP_lastP夹角30°，模为√3/12*dOL
+        calculateVector(vectorOL, osg::PI/3.0, sqrtf(3.0)/12.0*dOL, v_l, v_r);
+        interPoints[1] = osg::Vec2(v_l.x()+originP.x(), v_l.y()+originP.y());
+        //第二个插值控制点为两控制点的中点
+        interPoints[2] = osg::Vec2((originP.x()+lastP.x())/2.0, (originP.y()+lastP.y())/2.0);
+        //第三个插值控制点，以lastP为起点，与向量originP_lastP夹角150°
+        calculateVector(vectorOL, osg::PI*2.0/3.0, sqrtf(3.0)/12.0*dOL, v_l, v_r);
+        interPoints[3] = osg::Vec2(v_l.x()+lastP.x(), v_l.y()+lastP.y());
+        interPoints[4] = lastP;
+        //第四个插值控制点，以中点为起点，与向量originP_lastP垂直，模为1/2*dOL
+        calculateVector(vectorOL, osg::PI_2, 1.0/2.0*dOL, v_l, v_r);
+        interPoints[5] = osg::Vec2(v_r.x()+interPoints[2].x(), v_r.y()+interPoints[2].y());
+
+        std::array<osg::Vec2, 19> cardinalPoints;
+        createCloseCardinal<6>(interPoints, cardinalPoints);
+
+        points.clear();
+        for (unsigned int i = 0; i + 3 < cardinalPoints.size(); i += 3)
+            appendBezier3<Part>(points, cardinalPoints[i], cardinalPoints[i+1], cardinalPoints[i+2], cardinalPoints[i+3]);
+        appendEndPoint(points, cardinalPoints[18]);
+    }
+};
+
+/**
+ * 四个控制点的双箭头
+ * 左右外弧为二次贝塞尔曲线，中间内弧为两段三次贝塞尔曲线
+ */
+struct DoubleArrowKernel {
+    enum { CAPACITY = 22 + 3 + 43 + 3 + 22 };
+
+    template<class Points>
+    static void calculate(const std::array<osg::Vec2, 4>& ctrlPts, Points& points)
+    {
+        const osg::Vec2& pointU_1 = ctrlPts[0];
+        const osg::Vec2& pointU_2 = ctrlPts[1];
+        const osg::Vec2& pointU_3 = ctrlPts[2];
+        const osg::Vec2& pointU_4 = ctrlPts[3];
+
+        //中间用户点
+        osg::Vec2 pointU_C(((pointU_1.x()+pointU_2.x())*5+(pointU_3.x()+pointU_4.x()))/12,((pointU_1.y()+pointU_2.y())*5+(pointU_3.y()+pointU_4.y()))/12);
+        //左、右外弧和内弧的控制点
+        osg::Vec2 pointC_l_out, pointC_r_out, pointC_l_inner, pointC_r_inner, unused;
+        calculateIntersectionFromTwoCorner(pointU_1, pointU_4, osg::PI/8, osg::PI/6, pointC_l_out, unused);
+        calculateIntersectionFromTwoCorner(pointU_2, pointU_3, osg::PI/8, osg::PI/6, unused, pointC_r_out);
+        calculateIntersectionFromTwoCorner(pointU_C, pointU_4, osg::PI/8, osg::PI/16, pointC_l_inner, unused);
+        calculateIntersectionFromTwoCorner(pointU_C, pointU_3, osg::PI/8, osg::PI/16, unused, pointC_r_inner);
+
+        //箭头头部的大小比例
+        const float ab = 0.25;
+        osg::Vec2 pointC_l_out_2, pointC_l_inner_2, pointC_r_out_2, pointC_r_inner_2;
+        calculateHead(pointU_4, pointC_l_out, pointC_l_inner, ab, pointC_l_out_2, pointC_l_inner_2);
+        calculateHead(pointU_3, pointC_r_out, pointC_r_inner, ab, pointC_r_out_2, pointC_r_inner_2);
+
+        //中间点左右的控制点，按两侧到中间点的距离分配
+        osg::Vec2 v_U_4_3(pointU_3.x()-pointU_4.x(), pointU_3.y()-pointU_4.y());
+        float d_U_4_C = calculateDistance(pointU_C, pointU_4);
+        float d_U_3_C = calculateDistance(pointU_C, pointU_3);
+        float percent = 0.4;
+        osg::Vec2 v_U_4_3_(v_U_4_3.x()*percent, v_U_4_3.y()*percent);
+        osg::Vec2 v_U_4_3_l(v_U_4_3_.x()*d_U_4_C/(d_U_4_C+d_U_3_C), v_U_4_3_.y()*d_U_4_C/(d_U_4_C+d_U_3_C));
+        osg::Vec2 v_U_4_3_r(v_U_4_3_.x()*d_U_3_C/(d_U_4_C+d_U_3_C),v_U_4_3_.y()*d_U_3_C/(d_U_4_C+d_U_3_C));
+        osg::Vec2 pointC_c_l(pointU_C.x()-v_U_4_3_l.x(), pointU_C.y()-v_U_4_3_l.y());
+        osg::Vec2 pointC_c_r(pointU_C.x()+v_U_4_3_r.x(), pointU_C.y()+v_U_4_3_r.y());
+
+        points.clear();
+        //左边外弧
+        appendBezier2<20>(points, pointU_1, pointC_l_out, pointC_l_out_2);
+        appendEndPoint(points, pointC_l_out_2);
+        //左箭头
+        points.push_back(osg::Vec2(pointC_l_out_2.x()*1.5-pointC_l_inner_2.x()*0.5, pointC_l_out_2.y()*1.5-pointC_l_inner_2.y()*0.5));
+        points.push_back(pointU_4);
+        points.push_back(osg::Vec2(pointC_l_inner_2.x()*1.5-pointC_l_out_2.x()*0.5, pointC_l_inner_2.y()*1.5-pointC_l_out_2.y()*0.5));
+        //中间内弧
+        appendBezier3<20>(points, pointC_l_inner_2, pointC_l_inner, pointC_c_l, pointU_C);
+        appendBezier3<20>(points, pointU_C, pointC_c_r, pointC_r_inner, pointC_r_inner_2);
+        appendEndPoint(points, pointC_r_inner_2);
+        //右箭头
+        points.push_back(osg::Vec2(pointC_r_inner_2.x()*1.5-pointC_r_out_2.x()*0.5,pointC_r_inner_2.y()*1.5-pointC_r_out_2.y()*0.5));
+        points.push_back(pointU_3);
+        points.push_back(osg::Vec2(pointC_r_out_2.x()*1.5-pointC_r_inner_2.x()*0.5,pointC_r_out_2.y()*1.5-pointC_r_inner_2.y()*0.5));
+        //右边外弧
+        appendBezier2<20>(points, pointC_r_out_2, pointC_r_out, pointU_2);
+        appendEndPoint(points, pointU_2);
+    }
+
+private:
+    // 箭头头部在外弧、内弧方向上的两个点，取两者中较短的ab倍
+    static void calculateHead(const osg::Vec2& pointU, const osg::Vec2& pointC_out, const osg::Vec2& pointC_inner, float ab,
+                              osg::Vec2& pointC_out_2, osg::Vec2& pointC_inner_2)
+    {
+        osg::Vec2 v_out(pointC_out.x()-pointU.x(), pointC_out.y()-pointU.y());
+        float d_out = sqrtf(v_out.x()*v_out.x()+v_out.y()*v_out.y());
+        osg::Vec2 v_inner(pointC_inner.x()-pointU.x(), pointC_inner.y()-pointU.y());
+        float d_inner = sqrtf(v_inner.x()*v_inner.x()+v_inner.y()*v_inner.y());
+        float d_a = d_out < d_inner ? d_out*ab : d_inner*ab;
+        pointC_out_2 = osg::Vec2(v_out.x()/d_out*d_a+pointU.x(), v_out.y()/d_out*d_a+pointU.y());
+        pointC_inner_2 = osg::Vec2(v_inner.x()/d_inner*d_a+pointU.x(), v_inner.y()/d_inner*d_a+pointU.y());
+    }
+};
+
+/**
+ * 三个控制点的弓形
+ * A、B为圆弧端点，C为圆弧上一点；圆弧点密度不超过MaxSides（每1°取MaxSides/180个点）
+ */
+template<unsigned int MaxSides = 360>
+struct LuneKernel {
+    enum { CAPACITY = 4*MaxSides + 2 };
+
+    template<class Points>
+    static void calculate(const std::array<osg::Vec2, 3>& ctrlPts, float sides, Points& points)
+    {
+        const osg::Vec2& pointA = ctrlPts[0];
+        const osg::Vec2& pointB = ctrlPts[1];
+        const osg::Vec2& pointC = ctrlPts[2];
+        points.clear();
+
+        osg::Vec2 vectorAB(pointB.x() - pointA.x(), pointB.y() - pointA.y());
+        osg::Vec2 vectorBC(pointC.x() - pointB.x(), pointC.y() - pointB.y());
+        //三点共线时返回直线
+        if (fabs(vectorAB.x()*vectorBC.y()-vectorBC.x()*vectorAB.y()) < 0.00001) {
+            points.push_back(pointA);
+            points.push_back(pointC);
+            points.push_back(pointB);
+            return;
+        }
+        //AB、BC中垂线的交点为圆心
+        osg::Vec2 unused, vector_center_midPointAB, vector_center_midPointBC;
+        calculateVector(vectorAB, osg::PI_2, 1.0, unused, vector_center_midPointAB);
+        calculateVector(vectorBC, osg::PI_2, 1.0, unused, vector_center_midPointBC);
+        osg::Vec2 centerPoint = calculateIntersection(vector_center_midPointAB, vector_center_midPointBC,
+                                                      calculateMidpoint(pointA, pointB), calculateMidpoint(pointB, pointC));
+        float radius = calculateDistance(centerPoint, pointA);
+        float angleA = calculateAngle(pointA, centerPoint);
+        float angleB = calculateAngle(pointB, centerPoint);
+        float angleC = calculateAngle(pointC, centerPoint);
+
+        //角度小的端点为起点，C不在两端点之间时顺时针绘制
+        float direction = 1;
+        float startAngle = angleA < angleB ? angleA : angleB;
+        float endAngle = angleA < angleB ? angleB : angleA;
+        const osg::Vec2& startP = angleA > angleB ? pointB : pointA;
+        const osg::Vec2& endP = angleA > angleB ? pointA : pointB;
+        float length = endAngle-startAngle;
+        if ((angleC<angleB &&angleC <angleA)||(angleC>angleB &&angleC >angleA)) {
+            direction = -1;
+            length = startAngle+(2*osg::PI-endAngle);
+        }
+
+        if (sides > MaxSides)
+            sides = MaxSides;
+        float step = osg::PI/sides/2.0;
+        float stepDir = step*direction;
+        points.push_back(startP);
+        if (length > step)
+            appendArc(points, centerPoint, radius, startAngle+stepDir, stepDir, (unsigned int)ceilf((length-step)/step));
+        points.push_back(endP);
+    }
+};
+
+/**
+ * 两个控制点的扇形搜寻区
+ * 8个点的外形折线和14条两点的箭头线
+ */
+struct SectorSearchKernel {
+    enum { NUM_ARROWS = 14 };
+
+    static void calculate(const std::array<osg::Vec2, 2>& ctrlPts, FixedLineString<8>& outline, FixedLineString<2> (&arrows)[NUM_ARROWS])
+    {
+        //第一个点为中心点，第二个点确定半径和起始方向
+        const osg::Vec2& centerPoint = ctrlPts[0];
+        const osg::Vec2& point_FB = ctrlPts[1];
+        float offsetX = 2.0*centerPoint.x();
+        float offsetY = 2.0*centerPoint.y();
+        float radius = calculateDistance(centerPoint, point_FB);
+        osg::Vec2 vector_FR, vector_SL;
+        calculateVector(centerPoint - point_FB, 4*osg::PI/3, radius, vector_FR, vector_SL);
+        osg::Vec2 point_FC(vector_FR.x()+centerPoint.x(), vector_FR.y()+centerPoint.y());
+        osg::Vec2 point_SB(-point_FC.x()+offsetX, -point_FC.y()+offsetY);
+        osg::Vec2 point_SC(vector_SL.x()+centerPoint.x(), vector_SL.y()+centerPoint.y());
+        osg::Vec2 point_TB(-point_SC.x()+offsetX, -point_SC.y()+offsetY);
+        osg::Vec2 point_TC(-point_FB.x()+offsetX, -point_FB.y()+offsetY);
+
+        outline.clear();
+        outline.push_back(centerPoint);
+        outline.push_back(point_FB);
+        outline.push_back(point_FC);
+        outline.push_back(point_SB);
+        outline.push_back(point_SC);
+        outline.push_back(point_TB);
+        outline.push_back(point_TC);
+        outline.push_back(centerPoint);
+
+        //各边终点处的箭头，同calculateArrowLines
+        for (unsigned int i = 0; i + 1 < outline.size(); i++) {
+            const osg::Vec2& startP = outline[i];
+            const osg::Vec2& endP = outline[i+1];
+            osg::Vec2 v_l, v_r;
+            calculateVector(startP - endP, osg::PI/6, calculateDistance(startP, endP)/10, v_l, v_r);
+            arrows[2*i].clear();
+            arrows[2*i].push_back(endP);
+            arrows[2*i].push_back(endP + v_l);
+            arrows[2*i+1].clear();
+            arrows[2*i+1].push_back(endP);
+            arrows[2*i+1].push_back(endP + v_r);
+        }
+    }
+};
+
+}
+
+#endif
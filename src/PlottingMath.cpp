@@ -1,15 +1,39 @@
 #include "PlottingMath.h"
+#include <osg/Timer>
+#include <float.h>
+#include <iomanip>
+#include <ostream>
+
+#define LC "[Math] "
+
+namespace {
+
+// appendArc递推的累积误差上限，相对半径
+const double ARC_RECURRENCE_TOLERANCE = 1.0e-12;
+// checkArc中每条弧的最多点数
+const unsigned int ARC_CHECK_MAX_POINTS = 1440;
+
+float nextRandom(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+}
 
 std::vector<osg::Vec2> Math::calculateVector(osg::Vec2 v, float a, float d)
+{
+    osg::Vec2 v_l, v_r;
+    calculateVector(v, a, d, v_l, v_r);
+    return std::vector<osg::Vec2>{v_l, v_r};
+}
+
+void Math::calculateVector(const osg::Vec2& v, float a, float d, osg::Vec2& v_l, osg::Vec2& v_r)
 {
     //定义目标向量的头部x坐标
     float x_1, x_2;
     //定义目标向量的头部y坐标
     float y_1, y_2;
-    //定义目标向量，一左一右
-    osg::Vec2 v_l;
-    osg::Vec2 v_r;
-
     //计算基准向量v的模
     float d_v = sqrtf(v.x()*v.x() + v.y()* v.y());
     //基准向量的斜率为0时，y值不能作为除数，所以需要特别处理
@@ -53,7 +77,6 @@ std::vector<osg::Vec2> Math::calculateVector(osg::Vec2 v, float a, float d)
             v_r.set(x_1, y_1);
         }
     }
-    return std::vector<osg::Vec2>{v_l, v_r};
 }
 
 osg::Vec2 Math::calculateIntersection(osg::Vec2 v_1, osg::Vec2 v_2, osg::Vec2 point1, osg::Vec2 point2)
@@ -93,27 +116,29 @@ osg::Vec2 Math::calculateAngularBisector(osg::Vec2 v1, osg::Vec2 v2)
 }
 
 std::vector<osg::Vec2> Math::calculateIntersectionFromTwoCorner(osg::Vec2 pointS, osg::Vec2 pointE, float a_S, float a_E)
+{
+    osg::Vec2 pointI_l, pointI_r;
+    calculateIntersectionFromTwoCorner(pointS, pointE, a_S, a_E, pointI_l, pointI_r);
+    return std::vector<osg::Vec2>{pointI_l, pointI_r};
+}
+
+void Math::calculateIntersectionFromTwoCorner(const osg::Vec2& pointS, const osg::Vec2& pointE, float a_S, float a_E, osg::Vec2& pointI_l, osg::Vec2& pointI_r)
 {
     //起始点、结束点、交点加起来三个点，形成一个三角形
     //斜边（起始点到结束点）的向量为
     osg::Vec2 v_SE(pointE.x()-pointS.x(),pointE.y()-pointS.y());
     //计算起始点、交点的单位向量
     osg::Vec2 v_SI_l, v_SI_r;
-    std::vector<osg::Vec2> v_SI_lr = calculateVector(v_SE, a_S, 1);
-    v_SI_l = v_SI_lr[0];
-    v_SI_r = v_SI_lr[1];
+    calculateVector(v_SE, a_S, 1, v_SI_l, v_SI_r);
 
     //计算结束点、交点的单位向量
     osg::Vec2 v_EI_l, v_EI_r;
-     std::vector<osg::Vec2> v_EI_lr = calculateVector(v_SE, osg::PI-a_S, 1);
-     v_EI_l = v_EI_lr[0];
-     v_EI_r = v_EI_lr[1];
+    calculateVector(v_SE, osg::PI-a_S, 1, v_EI_l, v_EI_r);
 
     //求左边的交点
-    osg::Vec2 pointI_l = calculateIntersection(v_SI_l, v_EI_l, pointS, pointE);
+    pointI_l = calculateIntersection(v_SI_l, v_EI_l, pointS, pointE);
     // 计算右边的交点
-    osg::Vec2 pointI_r = calculateIntersection(v_SI_r,v_EI_r,pointS,pointE);
-    return std::vector<osg::Vec2>{pointI_l, pointI_r};
+    pointI_r = calculateIntersection(v_SI_r,v_EI_r,pointS,pointE);
 }
 
 void Math::inciseBezier(const std::vector<osg::Vec2> &pSrcPt, int j, std::vector<osg::Vec2> &pDstPt) {
@@ -155,55 +180,90 @@ float Math::getBezierGap(std::vector<osg::Vec2> &pSrcPt, int j) {
     return gap;
 }
 
+namespace {
+// 精度模式下单段曲线的最大细分层数，每段最多输出3*2^12个点
+const unsigned int MAX_BEZIER_DEPTH = 12;
+
+// 同getBezierGap，控制多边形相邻点在x、y方向上的最大差值
+float bezierGap(const osg::Vec2* p)
+{
+    float gap = 0;
+    for (int i = 1; i < 4; i++) {
+        gap = osg::maximum(gap, fabsf(p[i].x() - p[i-1].x()));
+        gap = osg::maximum(gap, fabsf(p[i].y() - p[i-1].y()));
+    }
+    return gap;
+}
+
+// 去掉与上一个点相同的点后追加
+void appendDistinct(std::vector<osg::Vec2>& points, const osg::Vec2& p)
+{
+    if (points.empty() || points.back() != p)
+        points.push_back(p);
+}
+
+/**
+ * 一段三次贝塞尔曲线的自适应细分（de Casteljau）
+ * 用显式栈代替递归，先处理左半段，控制多边形满足精度的段按顺序直接输出，
+ * 每个点只写一次，总耗时与输出点数成正比
+ */
+void subdivideBezier(const osg::Vec2* segment, float precision, std::vector<osg::Vec2>& out)
+{
+    struct Segment {
+        osg::Vec2 p[4];
+        unsigned int depth;
+    };
+    // 深度优先，栈中最多同时存在每层一个右半段
+    Segment stack[MAX_BEZIER_DEPTH + 2];
+    unsigned int top = 0;
+    for (int i = 0; i < 4; i++)
+        stack[0].p[i] = segment[i];
+    stack[0].depth = 0;
+    top = 1;
+
+    while (top > 0) {
+        Segment s = stack[--top];
+        if (s.depth >= MAX_BEZIER_DEPTH || bezierGap(s.p) <= precision) {
+            appendDistinct(out, s.p[1]);
+            appendDistinct(out, s.p[2]);
+            appendDistinct(out, s.p[3]);
+            continue;
+        }
+        //将四个控制点拆分成左右两段，同inciseBezier
+        osg::Vec2 p01 = (s.p[0] + s.p[1]) * 0.5f;
+        osg::Vec2 p12 = (s.p[1] + s.p[2]) * 0.5f;
+        osg::Vec2 p23 = (s.p[2] + s.p[3]) * 0.5f;
+        osg::Vec2 p012 = (p01 + p12) * 0.5f;
+        osg::Vec2 p123 = (p12 + p23) * 0.5f;
+        osg::Vec2 mid = (p012 + p123) * 0.5f;
+
+        Segment& right = stack[top++];
+        right.p[0] = mid; right.p[1] = p123; right.p[2] = p23; right.p[3] = s.p[3];
+        right.depth = s.depth + 1;
+        Segment& left = stack[top++];
+        left.p[0] = s.p[0]; left.p[1] = p01; left.p[2] = p012; left.p[3] = mid;
+        left.depth = s.depth + 1;
+    }
+}
+}
+
 std::vector<osg::Vec2> Math::createBezier(const std::vector<osg::Vec2>& points, float precision, int part)
 {
     if (part)
         return createBezier3(points, part);
 
+    //贝塞尔分解是按4个点为一组进行的，每组的控制多边形细分到相邻点坐标差不超过precision
     std::vector<osg::Vec2> bezierPts;
-    for (int m = 0; m < points.size(); m++) {
-        bezierPts.push_back(points[m]);
-    }
-    //获取输入点的数量
-    int i, k, j;
-    bool bExit;
-    int count = bezierPts.size();
-    std::vector<osg::Vec2> ptBuffer;
-    bool ok = true;
-    while (ok) {
-        bExit = true;
-        //贝塞尔分解是按4个点为一组进行的，所以小于4个点就再不进行分解
-        for (int i = 0; i < count-3; i += 3) {
-            //对输入点数组进行分解
-            //判断bezierPts[i]到bezierPts[i+4]是否达到精度
-            if (getBezierGap(bezierPts, i) > precision) {
-                bExit= false;
-                //对未达到精度的bezierPts[i]到bezierPts[i+4]进行计算，得到新的ptBuffer点数组
-                inciseBezier(bezierPts, i, ptBuffer);
-                //去除已使用过的2个控制点
-                bezierPts.erase(bezierPts.begin()+i+1, bezierPts.begin()+i+1+2);
-                //将本次计算得到的5个新的点插入到bezierPts[i]位置之后，得到新的bezierPts点数组
-                for (k = 0; k < 5; k++) {
-                    bezierPts.insert(bezierPts.begin()+i+1+k, ptBuffer[k+1]);
-                }
-                //bezierPts[i]到bezierPts[i+4]没有达到精度，所以不能跳过，i需回归初始
-                i -= 3;
-                count = bezierPts.size();
-            }
-            if (bExit)
-                break;
-        }
-        //对分解得出的新bezierPts点数组进行优化，除去相同的点
-        while (j < count-1) {
-            if (bezierPts[j] == bezierPts[j+1]){
-                bezierPts.erase(bezierPts.begin()+j+1, bezierPts.begin()+j+1+1);
-                count--;
-            }
-            j++;
-        }
-        ok = false;
-    }
-    //将分解完成的新的bezierPts点数组转化为GeoLine对象并返回
+    if (points.empty())
+        return bezierPts;
+    bezierPts.reserve(points.size());
+    bezierPts.push_back(points[0]);
+    unsigned int i = 0;
+    for (; i + 3 < points.size(); i += 3)
+        subdivideBezier(&points[i], precision, bezierPts);
+    //不足一组的剩余点原样保留
+    for (i++; i < points.size(); i++)
+        appendDistinct(bezierPts, points[i]);
     return bezierPts;
 }
 
@@ -303,105 +363,86 @@ std::vector<osg::Vec2> Math::createBezier2(std::vector<osg::Vec2> &points, int p
     return bezierPts;
 }
 
-std::vector<osg::Vec2> Math::createCloseCardinal(std::vector<osg::Vec2> &points)
+void Math::calculateCardinalControlPoints(const osg::Vec2& p0, const osg::Vec2& p1, const osg::Vec2& p2, osg::Vec2& p1l, osg::Vec2& p1r, float tension)
 {
-    if (points.empty() || points.size() < 3) {
-        return points;
-    }
-    //获取起点，作为终点，以闭合曲线。
-    osg::Vec2 lastP = points[0];
-    points.push_back(lastP);
-
-    //定义传入的点数组，将在点数组中央（每两个点）插入两个控制点
-    std::vector<osg::Vec2> cPoints = points;
-    //包含输入点和控制点的数组
-    std::vector<osg::Vec2> cardinalPoints;
-    cardinalPoints.resize(256);
-
-    //至少三个点以上
-    //这些都是相关资料测出的经验数值
-    //定义张力系数，取值在0<t<0.5
-    float t = 0.4;
-    //为端点张力系数因子，取值在0<b<1
-    float b = 0.5;
+    //张力系数，取值在0<t<0.5，默认0.4是相关资料测出的经验数值
+    float t = tension;
     //误差控制，是一个大于等于0的数，用于三点非常趋近与一条直线时，减少计算量
     float e = 0.005;
 
-    //传入的点数量，至少有三个，n至少为2
-    int n = cPoints.size()-1;
-    //从开始遍历到倒数第二个，其中倒数第二个用于计算起点（终点）的插值控制点
-    osg::Vec2 p0, p1, p2;
-    for (int k = 0; k <= n-1; k++) {
-        //计算起点（终点）的左右控制点
-
-        if (k == n - 1) {
-            //三个基础输入点
-            p0 = cPoints[n - 1];
-            p1 = cPoints[0];
-            p2 = cPoints[1];
-        } else {
-            p0 = cPoints[k];
-            p1 = cPoints[k+1];
-            p2 = cPoints[k+2];
-        }
+    //通过p0、p1、p2计算p1点的做控制点p1l和又控制点p1r
+    //计算向量p0_p1和p1_p2
+    osg::Vec2 p0_p1(p1.x() - p0.x(), p1.y() - p0.y());
+    osg::Vec2 p1_p2(p2.x() - p1.x(), p2.y() - p1.y());
+    //并计算模
+    float d01 = sqrtf(p0_p1.x() * p0_p1.x() + p0_p1.y() * p0_p1.y());
+    float d12 = sqrtf(p1_p2.x() * p1_p2.x() + p1_p2.y() * p1_p2.y());
+    //与相邻点重合时无法确定切线方向，控制点取p1本身
+    if (d01 == 0 || d12 == 0) {
+        p1l = p1;
+        p1r = p1;
+        return;
+    }
+    //向量单位化
+    osg::Vec2 p0_p1_1(p0_p1.x() / d01, p0_p1.y() / d01);
+    osg::Vec2 p1_p2_1(p1_p2.x() / d12, p1_p2.y() / d12);
+    //计算向量p0_p1和p1_p2的夹角平分线向量
+    osg::Vec2 p0_p1_p2(p0_p1_1.x() + p1_p2_1.x(), p0_p1_1.y() + p1_p2_1.y());
+    //计算向量 p0_p1_p2 的模
+    float d012 = sqrtf(p0_p1_p2.x() * p0_p1_p2.x() + p0_p1_p2.y() * p0_p1_p2.y());
+    //判断p0、p1、p2是否共线，这里判定向量p0_p1和p1_p2的夹角的余弦和1的差值小于e就认为三点共线
+    //完全折返时平分线为零向量，同样按共线处理
+    float cosE_p0p1p2 = p0_p1_1.x() * p1_p2_1.x() + p0_p1_1.y() * p1_p2_1.y();
+    if (fabs(1.0 - cosE_p0p1p2) < e || d012 == 0) {
+        //计算p1l的坐标
+        p1l.x() = p1.x() - p1_p2_1.x() * d01 * t;
+        p1l.y() = p1.y() - p1_p2_1.y() * d01 * t;
+        //计算p1r的坐标
+        p1r.x() = p1.x() + p0_p1_1.x() * d12 * t;
+        p1r.y() = p1.y() + p0_p1_1.y() * d12 * t;
+    } else { //非共线
+        //单位化向量p0_p1_p2
+        osg::Vec2 p0_p1_p2_1 (p0_p1_p2.x() / d012, p0_p1_p2.y() / d012);
+        //计算p1l的坐标
+        p1l.x() = p1.x() - p0_p1_p2_1.x() * d01 * t;
+        p1l.y() = p1.y() - p0_p1_p2_1.y() * d01 * t;
+        //计算p1r的坐标
+        p1r.x() = p1.x() + p0_p1_p2_1.x() * d12 * t;
+        p1r.y() = p1.y() + p0_p1_p2_1.y() * d12 * t;
+    }
+}
+
+std::vector<osg::Vec2> Math::createCloseCardinal(const std::vector<osg::Vec2>& points, float tension)
+{
+    const unsigned int n = points.size();
+    if (n < 3) {
+        return points;
+    }
+
+    //输出的点数是确定的：每个输入点及其左右控制点，最后回到起点以闭合曲线
+    std::vector<osg::Vec2> cardinalPoints(3 * n + 1);
+    for (unsigned int j = 0; j < n; j++) {
+        //前后相邻的点，首尾相接
+        const osg::Vec2& p0 = points[j == 0 ? n - 1 : j - 1];
+        const osg::Vec2& p1 = points[j];
+        const osg::Vec2& p2 = points[j + 1 == n ? 0 : j + 1];
 
         //定义p1的左控制点和右控制点
         osg::Vec2 p1l, p1r;
-        //通过p0、p1、p2计算p1点的做控制点p1l和又控制点p1r
-        //计算向量p0_p1和p1_p2
-        osg::Vec2 p0_p1(p1.x() - p0.x(), p1.y() - p0.y());
-        osg::Vec2 p1_p2(p2.x() - p1.x(), p2.y() - p1.y());
-        //并计算模
-        float d01 = sqrtf(p0_p1.x() * p0_p1.x() + p0_p1.y() * p0_p1.y());
-        float d12 = sqrtf(p1_p2.x() * p1_p2.x() + p1_p2.y() * p1_p2.y());
-        //向量单位化
-        osg::Vec2 p0_p1_1(p0_p1.x() / d01, p0_p1.y() / d01);
-        osg::Vec2 p1_p2_1(p1_p2.x() / d12, p1_p2.y() / d12);
-        //计算向量p0_p1和p1_p2的夹角平分线向量
-        osg::Vec2 p0_p1_p2(p0_p1_1.x() + p1_p2_1.x(), p0_p1_1.y() + p1_p2_1.y());
-        //计算向量 p0_p1_p2 的模
-        float d012 = sqrtf(p0_p1_p2.x() * p0_p1_p2.x() + p0_p1_p2.y() * p0_p1_p2.y());
-        //单位化向量p0_p1_p2
-        osg::Vec2 p0_p1_p2_1 (p0_p1_p2.x() / d012, p0_p1_p2.y() / d012);
-        //判断p0、p1、p2是否共线，这里判定向量p0_p1和p1_p2的夹角的余弦和1的差值小于e就认为三点共线
-        float cosE_p0p1p2 = (p0_p1_1.x() * p1_p2_1.x() + p0_p1_1.y() * p1_p2_1.y()) / 1.0;
-        if (fabs(1.0 - cosE_p0p1p2) < e) {
-            //计算p1l的坐标
-            p1l.x() = p1.x() - p1_p2_1.x() * d01 * t;
-            p1l.y() = p1.y() - p1_p2_1.y() * d01 * t;
-            //计算p1r的坐标
-            p1r.x() = p1.x() + p0_p1_1.x() * d12 * t;
-            p1r.y() = p1.y() + p0_p1_1.y() * d12 * t;
-        } else { //非共线
-            //计算p1l的坐标
-            p1l.x() = p1.x() - p0_p1_p2_1.x() * d01 * t;
-            p1l.y() = p1.y() - p0_p1_p2_1.y() * d01 * t;
-            //计算p1r的坐标
-            p1r.x() = p1.x() + p0_p1_p2_1.x() * d12 * t;
-            p1r.y() = p1.y() + p0_p1_p2_1.y() * d12 * t;
-        }
+        calculateCardinalControlPoints(p0, p1, p2, p1l, p1r, tension);
 
-        //记录起点（终点）的左右插值控制点及倒数第二个控制点
-        if (k == n - 1) {
+        if (j == 0) {
+            //起点（终点）的右控制点在最前，左控制点在最后
             cardinalPoints[0] = p1;
             cardinalPoints[1] = p1r;
-            cardinalPoints[(n - 2) * 3 + 2 + 3] = p1l;
-            cardinalPoints[(n - 2) * 3 + 2 + 4] = cPoints[n];
+            cardinalPoints[3 * n - 1] = p1l;
+            cardinalPoints[3 * n] = p1;
         } else {
-            //记录下这三个控制点
-            cardinalPoints[k * 3 + 2 + 0] = p1l;
-            cardinalPoints[k * 3 + 2 + 1] = p1;
-            cardinalPoints[k * 3 + 2 + 2] = p1r;
+            cardinalPoints[3 * j - 1] = p1l;
+            cardinalPoints[3 * j] = p1;
+            cardinalPoints[3 * j + 1] = p1r;
         }
     }
-    //过滤掉空值的点
-    for (auto& it = cardinalPoints.begin(); it != cardinalPoints.end();) {
-        if (*it == osg::Vec2())
-            it = cardinalPoints.erase(it);
-        else
-            ++it;
-    }
-
     return cardinalPoints;
 }
 
@@ -422,16 +463,9 @@ std::vector<osg::Vec2> Math::calculateArc(const osg::Vec2& center, float radius,
 //    if(!sides)
 //        sides=360;
     float step = osg::PI/sides/2.0;
-    float stepDir = step*direction;
     float length = fabs(endAngle-startAngle);
     std::vector<osg::Vec2> points;
-    for (float radians = startAngle, i = 0.0; i < length; i+=step) {
-        osg::Vec2 circlePoint(cosf(radians) * radius + center.x(), sinf(radians) * radius + center.y());
-        points.push_back(circlePoint);
-        radians += stepDir;
-        radians = radians < 0 ? (radians+2*osg::PI) : radians;
-        radians = radians > 2*osg::PI ? (radians-2*osg::PI) : radians;
-    }
+    appendArc(points, center, radius, startAngle, step*direction, (unsigned int)ceilf(length/step));
     return points;
 }
 
@@ -454,3 +488,133 @@ Math::MultiLineString Math::calculateArrowLines(const osg::Vec2 &startP, const o
     arrowLines.push_back(LineString{endP, arrowLineP_r});
     return arrowLines;
 }
+
+Math::MultiLineString Math::calculateRangeRings(const std::vector<osg::Vec2>& centers, const std::vector<float>& radii, float startAngle, float sweepAngle, float sides)
+{
+    MultiLineString rings;
+    if (centers.empty() || radii.empty() || sweepAngle <= 0)
+        return rings;
+
+    float step = osg::PI/sides/2.0;
+    bool fullCircle = sweepAngle >= 2*osg::PI;
+    if (fullCircle)
+        sweepAngle = 2*osg::PI;
+
+    //单位圆弧，所有的环共用
+    LineString unitArc;
+    appendArc(unitArc, osg::Vec2(), 1.0, startAngle, step, (unsigned int)ceilf(sweepAngle/step));
+    if (fullCircle) {
+        unitArc.push_back(unitArc.front());
+    } else {
+        unitArc.push_back(osg::Vec2(cosf(startAngle+sweepAngle), sinf(startAngle+sweepAngle)));
+    }
+
+    float maxRadius = 0;
+    for (unsigned int j = 0; j < radii.size(); j++) {
+        maxRadius = osg::maximum(maxRadius, radii[j]);
+    }
+
+    rings.reserve(centers.size() * (radii.size() + (fullCircle ? 0 : 2)));
+    for (unsigned int i = 0; i < centers.size(); i++) {
+        const osg::Vec2& center = centers[i];
+        for (unsigned int j = 0; j < radii.size(); j++) {
+            rings.push_back(LineString(unitArc.size()));
+            LineString& ring = rings.back();
+            float radius = radii[j];
+            for (unsigned int k = 0; k < unitArc.size(); k++) {
+                ring[k].set(unitArc[k].x()*radius + center.x(), unitArc[k].y()*radius + center.y());
+            }
+        }
+        //扇形的两条边线
+        if (!fullCircle) {
+            rings.push_back(LineString{center, unitArc.front()*maxRadius + center});
+            rings.push_back(LineString{center, unitArc.back()*maxRadius + center});
+        }
+    }
+    return rings;
+}
+
+bool Math::checkArc(std::ostream& log, unsigned int samples)
+{
+    if (samples == 0)
+        return false;
+
+    // 圆心在经纬度范围内均匀，半径在0.001到100度之间对数均匀，扫过的角度不超过整圆，方向随机
+    struct Arc {
+        osg::Vec2 center;
+        float radius;
+        float startAngle;
+        float stepAngle;
+        unsigned int count;
+    };
+    std::vector<Arc> arcs(samples);
+    unsigned int state = 13;
+    unsigned int points = 0;
+    for (unsigned int i = 0; i < samples; i++) {
+        Arc& arc = arcs[i];
+        arc.center.set(nextRandom(state) * 360.0f - 180.0f, nextRandom(state) * 180.0f - 90.0f);
+        arc.radius = 1.0e-3f * powf(1.0e5f, nextRandom(state));
+        arc.startAngle = nextRandom(state) * 2 * osg::PI;
+        arc.count = 2 + (unsigned int)(nextRandom(state) * (ARC_CHECK_MAX_POINTS - 1));
+        arc.stepAngle = (nextRandom(state) < 0.5f ? -1.0f : 1.0f) * 2 * osg::PI / (arc.count - 1) * (0.25f + 0.75f * nextRandom(state));
+        points += arc.count;
+    }
+
+    // 耗时：递推与逐点cosf/sinf
+    osg::Timer* timer = osg::Timer::instance();
+    LineString line;
+    line.reserve(ARC_CHECK_MAX_POINTS);
+    float sum = 0;
+    osg::Timer_t t0 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++) {
+        const Arc& arc = arcs[i];
+        line.clear();
+        appendArc(line, arc.center, arc.radius, arc.startAngle, arc.stepAngle, arc.count);
+        sum += line.back().x();
+    }
+    osg::Timer_t t1 = timer->tick();
+    for (unsigned int i = 0; i < samples; i++) {
+        const Arc& arc = arcs[i];
+        line.clear();
+        for (unsigned int k = 0; k < arc.count; k++) {
+            float angle = arc.startAngle + k * arc.stepAngle;
+            line.push_back(osg::Vec2(cosf(angle) * arc.radius + arc.center.x(), sinf(angle) * arc.radius + arc.center.y()));
+        }
+        sum += line.back().x();
+    }
+    osg::Timer_t t2 = timer->tick();
+
+    // 误差：与按角度直接计算的双精度结果比较，以允许偏差的倍数计
+    double maxRatio = 0.0, maxError = 0.0;
+    unsigned int worst = 0;
+    for (unsigned int i = 0; i < samples; i++) {
+        const Arc& arc = arcs[i];
+        line.clear();
+        appendArc(line, arc.center, arc.radius, arc.startAngle, arc.stepAngle, arc.count);
+        for (unsigned int k = 0; k < arc.count; k++) {
+            double angle = (double)arc.startAngle + k * (double)arc.stepAngle;
+            osg::Vec2 exact(cos(angle) * arc.radius + arc.center.x(), sin(angle) * arc.radius + arc.center.y());
+            double deviation = (line[k] - exact).length();
+            double allowed = 2.0 * FLT_EPSILON * osg::maximum(fabs(exact.x()), fabs(exact.y()))
+                + ARC_RECURRENCE_TOLERANCE * arc.radius;
+            maxError = osg::maximum(maxError, deviation / arc.radius);
+            if (deviation / allowed > maxRatio) {
+                maxRatio = deviation / allowed;
+                worst = i;
+            }
+        }
+    }
+
+    const double nsPerPoint = 1.0e6 / points;
+    log << LC << samples << " random arcs, " << points << " points (checksum " << sum << ")" << std::endl;
+    log << LC << std::fixed << std::setprecision(1) << "recurrence " << timer->delta_m(t0, t1) * nsPerPoint
+        << " ns per point, cosf/sinf " << timer->delta_m(t1, t2) * nsPerPoint << " ns per point" << std::endl;
+    log << LC << std::scientific << std::setprecision(2) << "max error " << maxError << " of the radius, "
+        << std::fixed << maxRatio << " of the allowed deviation (arc " << worst << ", " << arcs[worst].count << " points)" << std::endl;
+    if (maxRatio > 1.0) {
+        log << LC << "FAILED: deviation exceeds 2 float ulps + " << ARC_RECURRENCE_TOLERANCE << " * radius" << std::endl;
+        return false;
+    }
+    log << LC << "OK" << std::endl;
+    return true;
+}
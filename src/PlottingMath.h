@@ -7,6 +7,7 @@
 #include <osg/Vec3>
 #include <vector>
 #include <list>
+#include <iosfwd>
 
 namespace Math {
 /**
@@ -17,6 +18,8 @@ namespace Math {
  * @return 返回目标向量数组（就两个向量，一左一右）
  */
 std::vector<osg::Vec2> calculateVector(osg::Vec2 v, float a = osg::PI_2, float d = 1.0);
+// 同上，结果写入left和right，不分配内存
+void calculateVector(const osg::Vec2& v, float a, float d, osg::Vec2& left, osg::Vec2& right);
 /**
  * 计算两条直线的交点
  * 通过向量的思想进行计算，需要提供两个向量以及两条直线上各自一个点
@@ -45,6 +48,8 @@ osg::Vec2 calculateAngularBisector(osg::Vec2 v1, osg::Vec2 v2);
 * @return 返回顶点（理论上存在两个值）
 */
 std::vector<osg::Vec2> calculateIntersectionFromTwoCorner(osg::Vec2 pointS, osg::Vec2 pointE, float a_S, float a_E);
+// 同上，结果写入left和right，不分配内存
+void calculateIntersectionFromTwoCorner(const osg::Vec2& pointS, const osg::Vec2& pointE, float a_S, float a_E, osg::Vec2& left, osg::Vec2& right);
 /**
  * @brief inciseBezier
  * @param pSrcPt
@@ -61,10 +66,10 @@ void inciseBezier(const std::vector<osg::Vec2>& pSrcPt, int j, std::vector<osg::
 float getBezierGap(std::vector<osg::Vec2>& pSrcPt, int j);
 /**
  * @brief createBezier
- * @param points
- * @param precision
- * @param part
- * @return
+ * @param points 控制点，每4个点（首尾相接）为一段三次贝塞尔曲线
+ * @param precision part为0时使用：每段曲线的控制多边形细分到相邻点坐标差不超过precision
+ * @param part 每段曲线的采样数，不为0时同createBezier3
+ * @return 曲线上的点，精度模式下相邻的重复点已去除
  */
 std::vector<osg::Vec2> createBezier(const std::vector<osg::Vec2>& points, float precision = 0, int part = 20);
 /**
@@ -88,9 +93,11 @@ std::vector<osg::Vec2> createBezier3(const std::vector<osg::Vec2>& points, int p
  * 利用输入的点数组计算出相应的Cardinal控制点，再使用贝塞尔曲线3创建经过所有Cardinal控制点的圆滑闭合曲线。
  *
  * Parameters:
- * points -{Array(<SuperMap.Geometry.Point>)} 传入的待计算的初始点串。
+ * points -{Array(<SuperMap.Geometry.Point>)} 传入的待计算的初始点串，不会被修改，点数不限。
+ * tension - {Number} 张力系数，取值在0到0.5之间，越大曲线越饱满，默认为0.4。
  * Returns:
- * {Array(<SuperMap.Geometry.Point>)} 计算出相应的Cardinal控制点。
+ * {Array(<SuperMap.Geometry.Point>)} 计算出相应的Cardinal控制点，n个输入点输出3n+1个点，
+ * 依次为每个输入点及其左右控制点，首尾都是第一个点。少于3个点时原样返回。
  *
  * (code)
  * var points = [];
@@ -103,7 +110,18 @@ std::vector<osg::Vec2> createBezier3(const std::vector<osg::Vec2>& points, int p
  * (end)
  */
 
-std::vector<osg::Vec2> createCloseCardinal(std::vector<osg::Vec2>& points);
+std::vector<osg::Vec2> createCloseCardinal(const std::vector<osg::Vec2>& points, float tension = 0.4);
+/**
+ * 计算Cardinal曲线上p1点的左右插值控制点
+ * @param p0 前一个点
+ * @param p1 当前点
+ * @param p2 后一个点
+ * @param p1l 左控制点
+ * @param p1r 右控制点
+ * @param tension 张力系数，同createCloseCardinal
+ * p1与相邻点重合时控制点取p1本身
+ */
+void calculateCardinalControlPoints(const osg::Vec2& p0, const osg::Vec2& p1, const osg::Vec2& p2, osg::Vec2& p1l, osg::Vec2& p1r, float tension = 0.4);
 
 /**
 * Method: calculateMidpoint
@@ -150,6 +168,52 @@ float calculateDistance(const osg::Vec2& pointA, const osg::Vec2& pointB);
 
 std::vector<osg::Vec2> calculateArc(const osg::Vec2& center, float radius, float startAngle, float endAngle, float direction, float sides=360);
 
+/**
+* Method: appendArc
+* 从起点角开始按固定步长在圆弧上取count个点，追加到points末尾。
+* 使用旋转矩阵递推代替逐点计算cos/sin，每条弧只需计算两次三角函数。
+* 递推在双精度下进行，每步的舍入误差约为2ε（ε≈2.2e-16），
+* 1440个点的累积误差小于1e-12*radius，远低于输出float的精度。
+* points可以是std::vector，也可以是定长的FixedLineString。
+*
+* Parameters:
+* points - {Array(<SuperMap.Geometry.Point>)} 输出的点数组
+* center - {<SuperMap.Geometry.Point>} 圆心
+* radius - {Number}半径
+* startAngle - {Number}第一个点的角度
+* stepAngle - {Number}相邻两点的角度差，负值为顺时针
+* count - {Number}点数
+*/
+template<class Points>
+void appendArc(Points& points, const osg::Vec2& center, float radius, float startAngle, float stepAngle, unsigned int count)
+{
+    //每一步的旋转量
+    double cs = cos((double)stepAngle);
+    double sn = sin((double)stepAngle);
+    //当前点的单位向量
+    double c = cos((double)startAngle);
+    double s = sin((double)startAngle);
+    points.reserve(points.size() + count);
+    for (unsigned int k = 0; k < count; k++) {
+        points.push_back(osg::Vec2(c * radius + center.x(), s * radius + center.y()));
+        double t = c * cs - s * sn;
+        s = s * cs + c * sn;
+        c = t;
+    }
+}
+
+/**
+* Method: checkArc
+* appendArc的误差检查：随机的圆心、半径、起点角、步长和点数（最多1440个点，即距离环默认精度的整圆），
+* 逐点与按角度直接计算的双精度cos/sin比较。允许的偏差为输出float的2个ulp加上1e-12*radius，
+* 任何一点超出时返回false；同时报告逐点cosf/sinf的耗时作为对照。
+*
+* Parameters:
+* log - 输出
+* samples - {Number}圆弧条数
+*/
+bool checkArc(std::ostream& log, unsigned int samples = 10000);
+
 /**
 * Method: calculateAngle
 * 计算圆上一点所在半径的直线与X轴的夹角，结果以弧度形式表示，范围是+π到 +2π。
@@ -175,6 +239,23 @@ typedef std::vector<LineString> MultiLineString;
 
 MultiLineString calculateArrowLines(const osg::Vec2& startP, const osg::Vec2& endP, float ratio = 10, float angle = osg::PI/6);
 
+/**
+* Method: calculateRangeRings
+* 批量计算一个或多个圆心的同心距离环（或扇形）。
+* 单位圆弧只计算一次，所有圆心、所有半径的环都由它缩放平移得到。
+*
+* Parameters:
+* centers - {Array(<SuperMap.Geometry.Point>)} 圆心数组
+* radii - {Array(Number)} 各环的半径，所有圆心共用
+* startAngle - {Number}起点角
+* sweepAngle - {Number}扫过的角度，不小于2π时为整圆；小于2π时为扇形，并在两侧各加一条最大半径的边线
+* sides - {Number}圆弧所在圆的点数，含义同calculateArc
+*
+* Returns:
+* {Array(<SuperMap.Geometry.LineString>)} 每个圆心依次输出各环，扇形时随后输出两条边线
+*/
+MultiLineString calculateRangeRings(const std::vector<osg::Vec2>& centers, const std::vector<float>& radii, float startAngle, float sweepAngle, float sides = 360);
+
 } // namespace Math
 
 
@@ -0,0 +1,165 @@
+#include "PlottingSimplify.h"
+#include <math.h>
+
+namespace {
+
+/**
+ * 线段(first, last)之间离直线first-last最远的点
+ * 比较的是叉积的平方，等于距离平方乘以线段长度平方，循环中没有除法和分支
+ * @param maxCross2 最远点的叉积平方
+ * @return 最远点下标，没有中间点时返回first
+ */
+unsigned int farthestPoint(const float* __restrict x, const float* __restrict y,
+                           unsigned int first, unsigned int last, float& maxCross2)
+{
+    const float ax = x[first], ay = y[first];
+    const float dx = x[last] - ax, dy = y[last] - ay;
+    const bool degenerate = dx == 0.0f && dy == 0.0f;
+
+    //第一趟：最大值归约
+    float maxValue = 0.0f;
+    if (degenerate) {
+        //首尾重合时按到首点的距离
+        for (unsigned int i = first + 1; i < last; i++) {
+            const float px = x[i] - ax, py = y[i] - ay;
+            const float d = px * px + py * py;
+            maxValue = d > maxValue ? d : maxValue;
+        }
+    } else {
+        for (unsigned int i = first + 1; i < last; i++) {
+            const float c = dx * (y[i] - ay) - dy * (x[i] - ax);
+            const float d = c * c;
+            maxValue = d > maxValue ? d : maxValue;
+        }
+    }
+    maxCross2 = maxValue;
+    if (maxValue <= 0.0f)
+        return first;
+
+    //第二趟：定位最大值所在的下标
+    for (unsigned int i = first + 1; i < last; i++) {
+        const float px = x[i] - ax, py = y[i] - ay;
+        float d;
+        if (degenerate) {
+            d = px * px + py * py;
+        } else {
+            const float c = dx * py - dy * px;
+            d = c * c;
+        }
+        if (d == maxValue)
+            return i;
+    }
+    return first;
+}
+
+// Douglas-Peucker，标记[first, last]之间需要保留的点（不含两端）
+unsigned int simplifyRange(const float* x, const float* y, unsigned int first, unsigned int last,
+                           float tolerance, std::vector<unsigned char>& keep, std::vector<unsigned int>& stack)
+{
+    unsigned int kept = 0;
+    const float tolerance2 = tolerance * tolerance;
+    stack.clear();
+    stack.push_back(first);
+    stack.push_back(last);
+    while (!stack.empty()) {
+        unsigned int e = stack.back(); stack.pop_back();
+        unsigned int s = stack.back(); stack.pop_back();
+        if (e <= s + 1)
+            continue;
+
+        float maxCross2;
+        unsigned int index = farthestPoint(x, y, s, e, maxCross2);
+        const float dx = x[e] - x[s], dy = y[e] - y[s];
+        float length2 = dx * dx + dy * dy;
+        //首尾重合时maxCross2就是距离平方
+        if (length2 == 0.0f)
+            length2 = 1.0f;
+        if (index == s || maxCross2 <= tolerance2 * length2)
+            continue;
+
+        keep[index] = 1;
+        kept++;
+        stack.push_back(s);
+        stack.push_back(index);
+        stack.push_back(index);
+        stack.push_back(e);
+    }
+    return kept;
+}
+
+}
+
+unsigned int Math::simplify(const PointBuffer& points, float tolerance, bool closed, std::vector<unsigned char>& keep)
+{
+    const unsigned int n = points.size();
+    keep.assign(n, 0);
+    if (tolerance <= 0.0f || n <= (closed ? 4u : 2u)) {
+        keep.assign(n, 1);
+        return n;
+    }
+
+    const float* x = points.x();
+    const float* y = points.y();
+    std::vector<unsigned int> stack;
+    keep[0] = 1;
+    keep[n-1] = 1;
+    unsigned int kept = 2;
+    if (closed) {
+        //从离起点最远的点把环分成两条链，分别简化；末点到起点的闭合边不参与简化
+        unsigned int split = 0;
+        float maxDist2 = -1.0f;
+        for (unsigned int i = 1; i < n - 1; i++) {
+            const float dx = x[i] - x[0], dy = y[i] - y[0];
+            const float d = dx * dx + dy * dy;
+            if (d > maxDist2) {
+                maxDist2 = d;
+                split = i;
+            }
+        }
+        keep[split] = 1;
+        kept++;
+        kept += simplifyRange(x, y, 0, split, tolerance, keep, stack);
+        kept += simplifyRange(x, y, split, n - 1, tolerance, keep, stack);
+    } else {
+        kept += simplifyRange(x, y, 0, n - 1, tolerance, keep, stack);
+    }
+    return kept;
+}
+
+void Math::simplify(const PointBuffer& points, float tolerance, bool closed, PointBuffer& result)
+{
+    std::vector<unsigned char> keep;
+    unsigned int kept = simplify(points, tolerance, closed, keep);
+    result.clear();
+    result.setOrigin(points.getOrigin());
+    result.reserve(kept);
+    for (unsigned int i = 0; i < points.size(); i++) {
+        if (keep[i])
+            result.push_back(points.getPoint(i));
+    }
+}
+
+Math::LineString Math::simplify(const LineString& line, float tolerance, bool closed)
+{
+    if (line.empty())
+        return line;
+    PointBuffer points(line.size());
+    points.setOrigin(osg::Vec3d(line[0].x(), line[0].y(), 0.0));
+    points.append(&line[0], &line[0] + line.size());
+    std::vector<unsigned char> keep;
+    unsigned int kept = simplify(points, tolerance, closed, keep);
+    LineString result;
+    result.reserve(kept);
+    for (unsigned int i = 0; i < line.size(); i++) {
+        if (keep[i])
+            result.push_back(line[i]);
+    }
+    return result;
+}
+
+float Math::quantizeTolerance(float tolerance, float baseTolerance)
+{
+    if (tolerance < baseTolerance || baseTolerance <= 0.0f)
+        return 0.0f;
+    return baseTolerance * powf(2.0f, floorf(log2f(tolerance / baseTolerance)));
+}
@@ -0,0 +1,39 @@
+#ifndef PLOTTINGSIMPLIFY_H
+#define PLOTTINGSIMPLIFY_H
+
+#include "PlottingMath.h"
+#include "PointBuffer.h"
+
+/**
+ * 显示用的折线简化（Douglas-Peucker）
+ * 距离计算在PointBuffer的x、y分量数组上进行，求最远点分两趟：先求最大距离（可向量化的归约），
+ * 再定位下标，每一段只遍历一次；用显式栈代替递归。
+ * 首尾点总是保留；闭合环额外保留离起点最远的点，简化后至少是三角形，不会退化成线段。
+ */
+namespace Math {
+
+/**
+ * 简化点串
+ * @param points 输入点
+ * @param tolerance 允许的最大垂直距离，单位与坐标相同，不大于0时原样输出
+ * @param closed 是否为闭合环（多边形外形），首尾点不必重复
+ * @param keep 输出与points等长的标记，保留的点为1
+ * @return 保留的点数
+ */
+unsigned int simplify(const PointBuffer& points, float tolerance, bool closed, std::vector<unsigned char>& keep);
+
+// 同上，结果按原顺序写入result
+void simplify(const PointBuffer& points, float tolerance, bool closed, PointBuffer& result);
+LineString simplify(const LineString& line, float tolerance, bool closed = false);
+
+/**
+ * 按LOD级别量化简化容差
+ * 容差取baseTolerance的2的整数次幂倍中不超过tolerance的最大值，
+ * 视图在同一级别内缩放时结果不变，避免预览轮廓随每次移动跳动
+ * @return 量化后的容差，tolerance小于baseTolerance（最细一级）时返回0，不再简化
+ */
+float quantizeTolerance(float tolerance, float baseTolerance);
+
+}
+
+#endif
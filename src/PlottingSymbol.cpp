@@ -29,43 +29,23 @@
 #include <osgEarth/Metrics>
 #include <iostream>
 
-#include "DrawLineTool.h"
-#include "DrawRectangleTool.h"
-#include "DrawPolygonTool.h"
-#include "DrawCircleTool.h"
-#include "GeoStraightArrow.h"
-#include "GeoDoubleArrow.h"
-#include "GeoDiagonalArrow.h"
-#include "GeoGatheringPlace.h"
-#include "GeoLune.h"
-#include "GeoParallelSearch.h"
-#include "GeoSectorSearch.h"
+#include "SymbolTypeRegistry.h"
+#include "GeoRangeRings.h"
+#include "DrawProfiler.h"
+#include "InputRecorder.h"
+#include "LocationProvider.h"
+#include "KernelCheck.h"
+#include "VectorTiler.h"
+#include "GenerationService.h"
+#include "SymbolFeed.h"
+#include "TrackSymbols.h"
+#include "TemporalSymbols.h"
+#include "PlottingGeodesic.h"
 
 #define LC "[viewer] "
 
-enum ToolType {
-    TOOL_CLEAR, // 清除绘制
-    TOOL_DRAW_LINE, // 线
-    TOOL_DRAW_CIRCLE, // 圈
-    TOOL_DRAW_POLYGON, // 多边形
-    TOOL_DRAW_RECTANGLE, // 矩形
-    TOOL_MEASURE_HEIGHT, // 高度测量
-    TOOL_PLACE_MARK, // 点标记
-    TOOL_IMAGE_OVERLAY, // 遮盖标记
-    TOOL_DRAW_ARROWED_LINE, // 箭头
-    TOOL_DRAW_BEZIER_CURVE, // 曲线
-    TOOL_RADIAL_LOS,
-    TOOL_MEASURE_AREA, // 面积测量
-    TOOL_MEASURE_DISTANCE, // 距离测量
-    TOOL_MEASURE_ANGLE, // 角度测量
-    TOOL_DRAW_STRAIGHTARROW, // 直箭头
-    TOOL_DRAW_DOUBLEARROW, // 双箭头
-    TOOL_DRAW_DIAGONALARROW, // 斜箭头
-    TOOL_DRAW_GATHERINGPLACE, // 聚居区
-    TOOL_DRAW_GEOLUNE, // 弓形
-    TOOL_DRAW_PARALLELSEARCH, //平行搜寻区
-    TOOL_DRAW_SECTORSEARCH, //扇形搜寻区
-};
+// 清除绘制，其余工具以符号类型（DrawTool::DrawType）标识
+const int TOOL_CLEAR = -1;
 
 using namespace osgEarth;
 using namespace osgEarth::Util;
@@ -75,15 +55,78 @@ usage(const char* name)
 {
     OE_NOTICE 
         << "\nUsage: " << name << " file.earth" << std::endl
+        << "    --trace <file.json>     : write a chrome://tracing file of the drawing tools" << std::endl
+        << "    --record <file.txt>     : record mouse and key input of the drawing tools" << std::endl
+        << "    --replay <file.txt>     : replay recorded input without rendering and print timings" << std::endl
+        << "    --symbol-plugin <lib>   : load additional symbol types from a shared library" << std::endl
+        << "    --pick <mode>           : screen picking of the drawing tools: scene (default), heightfield or analytic" << std::endl
+        << "    --kernel-record <file>  : record reference outlines of all symbol types for a random corpus" << std::endl
+        << "    --kernel-check <file>   : recompute the recorded corpus and compare with the reference outlines" << std::endl
+        << "    --kernel-tolerance <d>  : degrees allowed by --kernel-check beyond 2 float ulps (default 1e-5)" << std::endl
+        << "    --kernel-samples <n>    : samples per symbol type for --kernel-record (default 200)" << std::endl
+        << "    --tile-dir <dir>        : export the drawn symbols as vector tiles (F11, or after --replay)" << std::endl
+        << "    --tile-zoom <min> <max> : zoom levels of the vector tiles (default 0 14)" << std::endl
+        << "    --tile-check <dir>      : export a circle into <dir> and check its outline and tiles, then exit" << std::endl
+        << "    --serve <port>          : serve symbol outlines to other processes on 127.0.0.1:<port>" << std::endl
+        << "    --serve-workers <n>     : worker threads of --serve (default: hardware threads)" << std::endl
+        << "    --serve-batch <n>       : maximum requests computed per batch (default 64)" << std::endl
+        << "    --serve-connections <n> : maximum connections served at once (default 64)" << std::endl
+        << "    --load-test <port>      : measure throughput and latency of a running --serve" << std::endl
+        << "    --load-connections <n>  : connections of --load-test (default 4)" << std::endl
+        << "    --load-window <n>       : requests in flight per connection (default 32)" << std::endl
+        << "    --load-seconds <s>      : duration of --load-test (default 10)" << std::endl
+        << "    --feed <name>           : create a shared-memory symbol feed and apply its records every frame" << std::endl
+        << "    --feed-capacity <n>     : records in the --feed ring buffer (default 65536)" << std::endl
+        << "    --feed-bench <name>     : push create/update records into a running --feed and report the rate" << std::endl
+        << "    --feed-symbols <n>      : symbols of --feed-bench (default 10000)" << std::endl
+        << "    --feed-rate <n>         : updates per second of --feed-bench (default 100000)" << std::endl
+        << "    --feed-seconds <s>      : duration of --feed-bench (default 10)" << std::endl
+        << "    --tracks <n>            : attach n live symbols to simulated moving units" << std::endl
+        << "    --track-rate <hz>       : control-point updates per symbol per second (default 10)" << std::endl
+        << "    --track-threads <n>     : threads recomputing --tracks outlines (default: hardware threads)" << std::endl
+        << "    --track-frames <n>      : render n frames with --tracks, print frame times and exit" << std::endl
+        << "    --plan <file>           : play back a plan of keyframed, time-bounded symbols" << std::endl
+        << "    --plan-random <n>       : play back a random 24-hour plan of n symbols instead" << std::endl
+        << "    --plan-save <file>      : write the --plan-random plan to a file and exit" << std::endl
+        << "    --plan-bench            : time playback and scrubbing of the plan (default 50000 random symbols) and exit" << std::endl
+        << "    --geodesic <km>         : draw arrows, search legs and lines along geodesics, densified to <km> segments" << std::endl
+        << "                              (also --serve, the symbol feed, tracks, plans and tile export)" << std::endl
+        << "    --geodesic-bench        : compare the fast geodesic solver with exact Vincenty and exit" << std::endl
+        << "    --arc-check             : check the arc recurrence against exact cos/sin, exit nonzero if out of bounds" << std::endl
+        << "    --range-rings <n>       : rings drawn by the range-rings tool (default 5)" << std::endl
+        << "    --range-sectors         : the range-rings tool draws sectors, a third click sets the end edge" << std::endl
         << MapNodeHelper().usage() << std::endl;
 
     return 0;
 }
 
 std::map<int, osg::ref_ptr<osgGA::GUIEventHandler>> g_toolMap;
-std::vector<ToolType> g_toolTypes;
+std::vector<int> g_toolTypes;
 int g_currToolIndex = 0;
 osg::Group* g_drawGroup = NULL;
+std::string g_tileDir;
+unsigned int g_tileMinZoom = 0, g_tileMaxZoom = 14;
+double g_geodesicSegment = 0.0; // 大地线模式的加密间距（米），为0时关闭
+SymbolFeedHandler* g_feedHandler = NULL;
+osg::Group* g_feedGroup = NULL; // 推送的符号，不受清除工具影响
+TrackSymbolLayer* g_trackLayer = NULL;
+TrackSimulator* g_trackSimulator = NULL;
+TemporalPlan g_plan;
+TemporalPlayer* g_planPlayer = NULL;
+TrackSymbolLayer* g_planLayer = NULL;
+
+// 把绘制的符号导出为矢量瓦片
+bool exportTiles(std::ostream& log)
+{
+    if (g_tileDir.empty() || !g_drawGroup)
+        return false;
+    VectorTiler tiler(g_tileMinZoom, g_tileMaxZoom);
+    tiler.setGeodesicSegment(g_geodesicSegment);
+    tiler.addNode(g_drawGroup);
+    if (g_feedGroup)
+        tiler.addNode(g_feedGroup);
+    return tiler.write(g_tileDir, log);
+}
 
 // 初始化工具集
 void initTools(osgEarth::MapNode* mapNode) {
@@ -91,39 +134,22 @@ void initTools(osgEarth::MapNode* mapNode) {
     mapNode->addChild(g_drawGroup);
     g_toolTypes.push_back(TOOL_CLEAR);
 
-    g_toolMap[TOOL_DRAW_LINE] = new DrawLineTool(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_LINE);
-
-    g_toolMap[TOOL_DRAW_RECTANGLE] = new DrawRectangleTool(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_RECTANGLE);
-
-    g_toolMap[TOOL_DRAW_POLYGON] = new DrawPolygonTool(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_POLYGON);
-
-    g_toolMap[TOOL_DRAW_CIRCLE] = new DrawCircleTool(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_CIRCLE);
-
-    g_toolMap[TOOL_DRAW_STRAIGHTARROW] = new GeoStraightArrow(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_STRAIGHTARROW);
-    g_toolMap[TOOL_DRAW_DOUBLEARROW] = new GeoDoubleArrow(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_DOUBLEARROW);
-    g_toolMap[TOOL_DRAW_DIAGONALARROW] = new GeoDiagonalArrow(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_DIAGONALARROW);
-    g_toolMap[TOOL_DRAW_GATHERINGPLACE] = new GeoGatheringPlace(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_GATHERINGPLACE);
-    g_toolMap[TOOL_DRAW_GEOLUNE] = new GeoLune(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_GEOLUNE);
-    g_toolMap[TOOL_DRAW_PARALLELSEARCH] = new GeoParallelSearch(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_PARALLELSEARCH);
-    g_toolMap[TOOL_DRAW_SECTORSEARCH] = new GeoSectorSearch(mapNode, g_drawGroup);
-    g_toolTypes.push_back(TOOL_DRAW_SECTORSEARCH);
+    // 按注册顺序创建全部符号的工具，包括插件中的符号
+    const std::vector<SymbolType>& types = SymbolTypeRegistry::instance()->getTypes();
+    for (auto it = types.begin(); it != types.end(); it++) {
+        g_toolMap[it->type] = it->factory(mapNode, g_drawGroup);
+        g_toolTypes.push_back(it->type);
+    }
 }
 
 // 设置当前激活工具
-void setActivateTool(osgViewer::View* view, ToolType type)
+void setActivateTool(osgViewer::View* view, int type)
 {
     for (auto it = g_toolMap.begin(); it != g_toolMap.end(); it++) {
         view->removeEventHandler(it->second);
+        DrawTool* tool = dynamic_cast<DrawTool*>(it->second.get());
+        if (tool)
+            tool->clearSelection();
     }
 
     auto& fi = g_toolMap.find(type);
@@ -133,7 +159,13 @@ void setActivateTool(osgViewer::View* view, ToolType type)
     }
 
     if (type == TOOL_CLEAR) {
-        g_drawGroup->removeChildren(0, g_drawGroup->getNumChildren());
+        // 各工具放下未完成的绘制；清除本身进入撤销栈，被清除的符号由命令持有，不回收到对象池
+        for (auto it = g_toolMap.begin(); it != g_toolMap.end(); it++) {
+            DrawTool* tool = dynamic_cast<DrawTool*>(it->second.get());
+            if (tool)
+                tool->releaseNodes();
+        }
+        CommandManager::instance()->callCommand(new ClearCommand(g_drawGroup));
     }
 }
 
@@ -168,6 +200,32 @@ public:
                     break;
                 }
 
+                case osgGA::GUIEventAdapter::KEY_F9: // 打印绘制耗时统计
+                    DrawProfiler::instance()->dump(osgEarth::notify(osg::NOTICE));
+                    if (g_feedHandler)
+                        g_feedHandler->dump(osgEarth::notify(osg::NOTICE));
+                    if (g_trackLayer)
+                        g_trackLayer->dump(osgEarth::notify(osg::NOTICE));
+                    if (g_trackSimulator)
+                        g_trackSimulator->dump(osgEarth::notify(osg::NOTICE));
+                    if (g_planPlayer)
+                        g_planPlayer->dump(osgEarth::notify(osg::NOTICE));
+                    if (g_planLayer)
+                        g_planLayer->dump(osgEarth::notify(osg::NOTICE));
+                    return true;
+
+                case osgGA::GUIEventAdapter::KEY_F10: // 清空绘制耗时统计
+                    DrawProfiler::instance()->reset();
+                    if (g_trackLayer)
+                        g_trackLayer->resetStats();
+                    if (g_planLayer)
+                        g_planLayer->resetStats();
+                    return true;
+
+                case osgGA::GUIEventAdapter::KEY_F11: // 导出矢量瓦片
+                    exportTiles(osgEarth::notify(osg::NOTICE));
+                    return true;
+
                 }
             }
 
@@ -193,7 +251,115 @@ main(int argc, char** argv)
     float vfov = -1.0f;
     arguments.read("--vfov", vfov);
 
-    
+    // 输出chrome://tracing格式的trace文件，可在chrome或Perfetto中与每帧的耗时对照
+    std::string traceFile;
+    if ( arguments.read("--trace", traceFile) )
+        Metrics::setMetricsBackend(new ChromeMetricsBackend(traceFile));
+
+    std::string recordFile, replayFile;
+    arguments.read("--record", recordFile);
+    arguments.read("--replay", replayFile);
+    // 插件的类型同样参与下面的基准对比和生成服务，须先于它们加载
+    std::string symbolPlugin;
+    while ( arguments.read("--symbol-plugin", symbolPlugin) )
+        SymbolTypeRegistry::instance()->loadPlugin(symbolPlugin);
+
+    // 大地线模式及其精度、速度测量
+    double geodesicKm = 0.0;
+    if ( arguments.read("--geodesic", geodesicKm) )
+        g_geodesicSegment = geodesicKm * 1000.0;
+    if ( arguments.read("--geodesic-bench") )
+        return Math::Geodesic::bench(std::cout) ? 0 : 1;
+    if ( arguments.read("--arc-check") )
+        return Math::checkArc(std::cout) ? 0 : 1;
+
+    std::string pickMode = "scene";
+    arguments.read("--pick", pickMode);
+
+    unsigned int rangeRingCount = GeoRangeRings::DEFAULT_RING_COUNT;
+    arguments.read("--range-rings", rangeRingCount);
+    bool rangeSectors = arguments.read("--range-sectors");
+
+    arguments.read("--tile-dir", g_tileDir);
+    arguments.read("--tile-zoom", g_tileMinZoom, g_tileMaxZoom);
+    std::string tileCheckDir;
+    arguments.read("--tile-check", tileCheckDir);
+
+    // 符号外形的基准对比，不需要地图和窗口
+    std::string kernelRecordFile, kernelCheckFile;
+    double kernelTolerance = 1.0e-5;
+    unsigned int kernelSamples = 200;
+    arguments.read("--kernel-tolerance", kernelTolerance);
+    arguments.read("--kernel-samples", kernelSamples);
+    if ( arguments.read("--kernel-record", kernelRecordFile) )
+        return KernelCheck(kernelSamples).record(kernelRecordFile, std::cout) ? 0 : 1;
+    if ( arguments.read("--kernel-check", kernelCheckFile) )
+        return KernelCheck().check(kernelCheckFile, kernelTolerance, std::cout) ? 0 : 1;
+
+    // 外形生成服务及其压力测试，同样不需要地图和窗口
+    unsigned int servePort = 0, serveWorkers = 0, serveBatch = 64, serveConnections = 64;
+    unsigned int loadConnections = 4, loadWindow = 32;
+    double loadSeconds = 10.0;
+    arguments.read("--serve-workers", serveWorkers);
+    arguments.read("--serve-batch", serveBatch);
+    arguments.read("--serve-connections", serveConnections);
+    arguments.read("--load-connections", loadConnections);
+    arguments.read("--load-window", loadWindow);
+    arguments.read("--load-seconds", loadSeconds);
+    if ( arguments.read("--serve", servePort) )
+    {
+        GenerationService service(servePort, serveWorkers, serveBatch, 4096, serveConnections);
+        service.setGeodesicSegment(g_geodesicSegment);
+        return service.run(std::cout) ? 0 : 1;
+    }
+    if ( arguments.read("--load-test", servePort) )
+        return GenerationLoadTest(servePort, loadConnections, loadWindow, loadSeconds).run(std::cout) ? 0 : 1;
+
+    // 共享内存的符号推送，--feed-bench作为推送进程运行
+    std::string feedName;
+    unsigned int feedCapacity = 65536, feedSymbols = 10000, feedRate = 100000;
+    double feedSeconds = 10.0;
+    arguments.read("--feed-capacity", feedCapacity);
+    arguments.read("--feed-symbols", feedSymbols);
+    arguments.read("--feed-rate", feedRate);
+    arguments.read("--feed-seconds", feedSeconds);
+    if ( arguments.read("--feed-bench", feedName) )
+        return SymbolFeedBench(feedSymbols, feedRate, feedSeconds).run(feedName, std::cout) ? 0 : 1;
+    arguments.read("--feed", feedName);
+
+    // 跟随模拟目标高频更新的符号
+    unsigned int trackSymbols = 0, trackThreads = 0, trackFrames = 0;
+    double trackRate = 10.0;
+    arguments.read("--tracks", trackSymbols);
+    arguments.read("--track-rate", trackRate);
+    arguments.read("--track-threads", trackThreads);
+    arguments.read("--track-frames", trackFrames);
+
+    // 带时间窗口和关键帧的行动计划
+    std::string planFile, planSaveFile;
+    unsigned int planSymbols = 0;
+    bool planLoaded = false;
+    if ( arguments.read("--plan", planFile) )
+    {
+        if ( !g_plan.read(planFile, std::cout) )
+            return 1;
+        planLoaded = true;
+    }
+    else if ( arguments.read("--plan-random", planSymbols) )
+    {
+        g_plan.generate(planSymbols);
+        planLoaded = true;
+    }
+    if ( arguments.read("--plan-save", planSaveFile) )
+        return g_plan.write(planSaveFile) ? 0 : 1;
+    if ( arguments.read("--plan-bench") )
+    {
+        if ( !planLoaded )
+            g_plan.generate(50000);
+        osg::ref_ptr<osg::EllipsoidModel> ellipsoid = new osg::EllipsoidModel;
+        return TemporalPlayer::bench(g_plan, ellipsoid.get(), std::cout) ? 0 : 1;
+    }
+
 
     // create a viewer:
     osgViewer::Viewer viewer(arguments);
@@ -228,8 +394,105 @@ main(int argc, char** argv)
     if ( node )
     {
         viewer.setSceneData( node );
+        MapNode* mapNode = MapNode::get(node);
+        if ( !tileCheckDir.empty() )
+            return VectorTiler::check(mapNode, tileCheckDir, std::cout) ? 0 : 1;
+
+        // 拾取方式，解析地形不需要地图数据和渲染环境，覆盖全球，对应1920x1080的窗口
+        osg::ref_ptr<LocationProvider> locationProvider;
+        if ( pickMode == "heightfield" )
+            locationProvider = new HeightFieldLocationProvider(mapNode);
+        else if ( pickMode == "analytic" )
+            locationProvider = new AnalyticLocationProvider(-180.0, -90.0, 180.0, 90.0, 1920.0, 1080.0);
+        else
+            locationProvider = new SceneLocationProvider(mapNode);
+
+        // 录制需要先于快捷键和绘制工具看到事件
+        if ( !recordFile.empty() )
+            viewer.addEventHandler(new InputRecorder(recordFile, locationProvider.get()));
         viewer.addEventHandler(new Shortcuts(&viewer));
-        initTools(MapNode::get(node));
+        initTools(mapNode);
+        for (auto it = g_toolMap.begin(); it != g_toolMap.end(); it++) {
+            DrawTool* tool = dynamic_cast<DrawTool*>(it->second.get());
+            if (tool)
+            {
+                tool->setLocationProvider(locationProvider.get());
+                tool->setGeodesicSegment(g_geodesicSegment);
+            }
+        }
+        auto rangeTool = g_toolMap.find(DrawTool::DRAW_RANGERINGS);
+        GeoRangeRings* rangeRings = rangeTool != g_toolMap.end() ? dynamic_cast<GeoRangeRings*>(rangeTool->second.get()) : NULL;
+        if (rangeRings)
+        {
+            rangeRings->setRingCount(rangeRingCount);
+            rangeRings->setSectorMode(rangeSectors);
+        }
+
+        if ( !feedName.empty() )
+        {
+            SymbolFeedChannel* channel = SymbolFeedChannel::create(feedName, feedCapacity);
+            if ( channel )
+            {
+                // 推送的符号单独成组，清除工具不回收它们
+                g_feedGroup = new osg::Group;
+                mapNode->addChild(g_feedGroup);
+                g_feedHandler = new SymbolFeedHandler(channel, mapNode, g_feedGroup);
+                g_feedHandler->setGeodesicSegment(g_geodesicSegment);
+                viewer.addEventHandler(g_feedHandler);
+            }
+            else
+                OE_WARN << "Failed to create symbol feed " << feedName << " (the name may be in use by another viewer)" << std::endl;
+        }
+
+        std::unique_ptr<TrackSimulator> trackSimulator;
+        if ( trackSymbols > 0 )
+        {
+            g_trackLayer = new TrackSymbolLayer(mapNode->getMapSRS()->getEllipsoid(), trackThreads);
+            g_trackLayer->setGeodesicSegment(g_geodesicSegment);
+            mapNode->addChild(g_trackLayer);
+            trackSimulator.reset(new TrackSimulator(g_trackLayer, trackSymbols, trackRate));
+            trackSimulator->start();
+            g_trackSimulator = trackSimulator.get();
+        }
+
+        if ( planLoaded )
+        {
+            g_planLayer = new TrackSymbolLayer(mapNode->getMapSRS()->getEllipsoid());
+            g_planLayer->setGeodesicSegment(g_geodesicSegment);
+            mapNode->addChild(g_planLayer);
+            g_planPlayer = new TemporalPlayer(&g_plan, g_planLayer);
+            viewer.addEventHandler(g_planPlayer);
+        }
+
+        if ( !replayFile.empty() )
+        {
+            // 回放时不打开窗口，直接把录制的事件交给工具，输出各阶段耗时
+            InputPlayer player(replayFile);
+            if ( !player.valid() )
+            {
+                OE_WARN << "Failed to read input recording " << replayFile << std::endl;
+                return -1;
+            }
+            double ms = player.replay(viewer);
+            std::cout << "Replayed " << player.getNumEvents() << " events in " << ms << " ms"
+                << " (recorded " << player.getRecordedDuration() << " s)" << std::endl;
+            DrawProfiler::instance()->dump(std::cout);
+            if ( !g_tileDir.empty() && !exportTiles(std::cout) )
+                return 1;
+            return 0;
+        }
+
+        if ( g_trackLayer && trackFrames > 0 )
+        {
+            // 固定帧数的测量，不关闭垂直同步时帧间隔不低于刷新周期
+            viewer.realize();
+            for (unsigned int i = 0; i < trackFrames && !viewer.done(); i++)
+                viewer.frame();
+            g_trackLayer->dump(std::cout);
+            trackSimulator->dump(std::cout);
+            return 0;
+        }
+
         Metrics::run(viewer);
     }
     else
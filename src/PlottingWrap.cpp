@@ -0,0 +1,191 @@
+#include "PlottingWrap.h"
+#include "PlottingClip.h"
+#include <osg/Vec3d>
+
+namespace {
+
+const double DEG = osg::PI / 180.0;
+
+// 经度范围的归约，循环中只有min/max，没有分支
+void longitudeRange(const Math::LineString& points, float& minLon, float& maxLon)
+{
+    for (unsigned int i = 0; i < points.size(); i++) {
+        minLon = osg::minimum(minLon, points[i].x());
+        maxLon = osg::maximum(maxLon, points[i].x());
+    }
+}
+
+}
+
+namespace Math {
+
+LocalFrame::LocalFrame(const LineString& controlPoints)
+    : _mode(IDENTITY)
+    , _lon0(0.0)
+    , _lat0(0.0)
+    , _sinLat0(0.0)
+    , _cosLat0(1.0)
+    , _scale(1.0)
+{
+    // 纬度绝对值和相邻经度差的最大值，两个归约之后只有一次判断
+    float maxLat = 0.0f, maxStep = 0.0f;
+    for (unsigned int i = 0; i < controlPoints.size(); i++)
+        maxLat = osg::maximum(maxLat, fabsf(controlPoints[i].y()));
+    for (unsigned int i = 1; i < controlPoints.size(); i++)
+        maxStep = osg::maximum(maxStep, fabsf(controlPoints[i].x() - controlPoints[i - 1].x()));
+    if (maxLat <= POLAR_BLEND_LATITUDE && maxStep <= 180.0f)
+        return;
+
+    if (maxLat <= POLAR_BLEND_LATITUDE) {
+        _mode = UNWRAP;
+        return;
+    }
+
+    // 控制点单位向量的平均方向作为原点
+    _mode = AZIMUTHAL;
+    osg::Vec3d center;
+    for (unsigned int i = 0; i < controlPoints.size(); i++) {
+        double lon = controlPoints[i].x() * DEG, lat = controlPoints[i].y() * DEG;
+        center += osg::Vec3d(cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat));
+    }
+    center.normalize();
+    _lat0 = asin(osg::clampBetween(center.z(), -1.0, 1.0));
+    _lon0 = atan2(center.y(), center.x());
+    _sinLat0 = sin(_lat0);
+    _cosLat0 = cos(_lat0);
+    // 过渡区内与经纬度平面的横向比例混合
+    double t = osg::clampBetween((maxLat - POLAR_BLEND_LATITUDE) / (POLAR_LATITUDE - POLAR_BLEND_LATITUDE), 0.0f, 1.0f);
+    _scale = t + (1.0 - t) / cos(osg::minimum(fabs(_lat0), (double)POLAR_LATITUDE * DEG));
+    _lat0 /= DEG;
+    _lon0 /= DEG;
+}
+
+void LocalFrame::forward(LineString& points) const
+{
+    if (_mode == UNWRAP) {
+        for (unsigned int i = 1; i < points.size(); i++)
+            points[i].x() = unwrapLongitude(points[i].x(), points[i - 1].x());
+        return;
+    }
+    if (_mode != AZIMUTHAL)
+        return;
+
+    for (unsigned int i = 0; i < points.size(); i++) {
+        double lat = points[i].y() * DEG, dlon = (points[i].x() - _lon0) * DEG;
+        double sinLat = sin(lat), cosLat = cos(lat), cosDlon = cos(dlon);
+        // 到原点的角距离c和方位角a
+        double c = acos(osg::clampBetween(_sinLat0 * sinLat + _cosLat0 * cosLat * cosDlon, -1.0, 1.0)) / DEG;
+        double a = atan2(sin(dlon) * cosLat, _cosLat0 * sinLat - _sinLat0 * cosLat * cosDlon);
+        points[i].set(_lon0 + _scale * c * sin(a), _lat0 + c * cos(a));
+    }
+}
+
+void LocalFrame::inverse(LineString& points) const
+{
+    if (_mode != AZIMUTHAL)
+        return;
+
+    for (unsigned int i = 0; i < points.size(); i++) {
+        double dx = (points[i].x() - _lon0) / _scale, dy = points[i].y() - _lat0;
+        double c = sqrt(dx * dx + dy * dy) * DEG;
+        double a = atan2(dx, dy);
+        double sinC = sin(c), cosC = cos(c);
+        double sinLat = osg::clampBetween(_sinLat0 * cosC + _cosLat0 * sinC * cos(a), -1.0, 1.0);
+        // 原点在极点时也不退化的形式
+        double lon = _lon0 + atan2(sin(a) * sinC, _cosLat0 * cosC - _sinLat0 * sinC * cos(a)) / DEG;
+        // 经度沿折线保持连续
+        float reference = i == 0 ? (float)_lon0 : points[i - 1].x();
+        points[i].set(unwrapLongitude((float)lon, reference), (float)(asin(sinLat) / DEG));
+    }
+}
+
+bool crossesAntimeridian(const MultiLineString& outline)
+{
+    float minLon = 0.0f, maxLon = 0.0f;
+    for (unsigned int i = 0; i < outline.size(); i++)
+        longitudeRange(outline[i], minLon, maxLon);
+    return minLon < -180.0f || maxLon > 180.0f;
+}
+
+void splitAtAntimeridian(MultiLineString& outline, bool closed)
+{
+    if (!crossesAntimeridian(outline))
+        return;
+
+    MultiLineString result;
+    LineString part, piece;
+    MultiLineString pieces;
+    for (unsigned int i = 0; i < outline.size(); i++) {
+        part.swap(outline[i]);
+        float minLon = 0.0f, maxLon = 0.0f;
+        if (!part.empty())
+            minLon = maxLon = part[0].x();
+        longitudeRange(part, minLon, maxLon);
+        if (part.empty() || (minLon >= -180.0f && maxLon <= 180.0f)) {
+            result.push_back(part);
+            continue;
+        }
+
+        if (closed) {
+            // 闭合边展开后与起点相差约360度时外环环绕极点：经过极点闭合成经度方向上展开的多边形
+            const osg::Vec2 front = part.front(), back = part.back();
+            float closing = unwrapLongitude(front.x(), back.x());
+            if (fabsf(closing - front.x()) > 180.0f) {
+                float pole = 0.0f;
+                for (unsigned int k = 0; k < part.size(); k++)
+                    pole += part[k].y();
+                pole = pole >= 0.0f ? 90.0f : -90.0f;
+                part.push_back(osg::Vec2(closing, front.y()));
+                part.push_back(osg::Vec2(closing, pole));
+                part.push_back(osg::Vec2(front.x(), pole));
+                minLon = osg::minimum(minLon, closing);
+                maxLon = osg::maximum(maxLon, closing);
+            }
+        }
+
+        // 按360度一条的经度带裁剪，再平移回[-180, 180]
+        const int first = (int)floorf((minLon + 180.0f) / 360.0f);
+        const int last = (int)floorf((maxLon + 180.0f) / 360.0f);
+        for (int k = first; k <= last; k++) {
+            const float shift = 360.0f * k;
+            const Extent strip(shift - 180.0f, -90.0f, shift + 180.0f, 90.0f);
+            pieces.clear();
+            if (closed) {
+                clipPolygon(part, strip, piece);
+                if (piece.size() >= 3)
+                    pieces.push_back(piece);
+            } else {
+                clipLineString(part, strip, pieces);
+            }
+            for (unsigned int p = 0; p < pieces.size(); p++) {
+                for (unsigned int q = 0; q < pieces[p].size(); q++)
+                    pieces[p][q].x() -= shift;
+                result.push_back(pieces[p]);
+            }
+        }
+    }
+    outline.swap(result);
+}
+
+MultiLineString generateOutline(OutlineGenerator generator, const std::vector<osg::Vec2>& controlPoints, bool split,
+    const Geodesic* geodesic, double maxSegment)
+{
+    LocalFrame frame(controlPoints);
+    MultiLineString outline;
+    if (frame.mode() == LocalFrame::IDENTITY) {
+        outline = generator(controlPoints);
+    } else {
+        LineString local(controlPoints);
+        frame.forward(local);
+        outline = generator(local);
+        for (unsigned int i = 0; i < outline.size(); i++)
+            frame.inverse(outline[i]);
+    }
+    if (geodesic && maxSegment > 0.0)
+        geodesic->densify(outline, maxSegment);
+    if (split)
+        splitAtAntimeridian(outline, outline.size() == 1);
+    return outline;
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef PLOTTINGWRAP_H
+#define PLOTTINGWRAP_H
+
+#include <math.h>
+
+#include "PlottingMath.h"
+#include "PlottingGeodesic.h"
+
+/**
+ * 跨日期变更线和极区的外形生成
+ * 生成函数都把经纬度当作平面坐标：跨越±180度的箭头会绕地球一周，极区的符号会被压扁。
+ * 这里先把控制点转换到连续的局部坐标系中生成，再转换回经纬度并在日期变更线处切分。
+ * 常见情况（不跨日期变更线、不在极区）只多两次min/max归约，不做任何转换。
+ */
+namespace Math {
+
+// 控制点纬度超过该值（度）时在方位等距的局部坐标系中生成外形
+const float POLAR_BLEND_LATITUDE = 70.0f;
+// 控制点纬度超过该值（度）时局部坐标系为真正的方位等距投影，外形不再变形
+const float POLAR_LATITUDE = 80.0f;
+
+// 把lon加减360的整数倍，使其与reference相差不超过180度
+inline float unwrapLongitude(float lon, float reference)
+{
+    return lon - 360.0f * floorf((lon - reference + 180.0f) / 360.0f);
+}
+
+/**
+ * 生成外形用的局部坐标系
+ * IDENTITY  常见情况，不做转换
+ * UNWRAP    相邻控制点经度相差超过180度，依次展开为连续的经度
+ * AZIMUTHAL 有控制点纬度超过POLAR_BLEND_LATITUDE，以控制点的球面中心为原点做方位等距投影，坐标以度为单位。
+ *           最高纬度达到POLAR_LATITUDE时横向不缩放，外形与在赤道附近绘制时一致；
+ *           两个阈值之间横向缩放从原点纬度余弦的倒数（原点附近与经纬度一致）逐渐过渡到1，
+ *           控制点跨过阈值时外形连续变化
+ */
+class LocalFrame {
+public:
+    enum Mode { IDENTITY, UNWRAP, AZIMUTHAL };
+
+    explicit LocalFrame(const LineString& controlPoints);
+
+    Mode mode() const { return _mode; }
+
+    // 经纬度转换到局部坐标系（原位）
+    void forward(LineString& points) const;
+    // 局部坐标系转换回经纬度（原位），经度沿折线连续，可能超出±180
+    void inverse(LineString& points) const;
+
+private:
+    Mode _mode;
+    double _lon0, _lat0; // 原点（度）
+    double _sinLat0, _cosLat0;
+    double _scale; // 横向缩放
+};
+
+// 外形的经度是否超出[-180, 180]
+bool crossesAntimeridian(const MultiLineString& outline);
+
+/**
+ * 在日期变更线处切分外形，各部分平移回[-180, 180]
+ * 输入的经度沿各部分连续（LocalFrame::inverse的输出）；完全在范围内的部分原样保留。
+ * closed为true时各部分是多边形外环，环绕极点的外环先经过极点闭合再切分。
+ */
+void splitAtAntimeridian(MultiLineString& outline, bool closed);
+
+// 与SymbolTypeRegistry中的OutlineFunction相同
+typedef MultiLineString (*OutlineGenerator)(const std::vector<osg::Vec2>& controlPoints);
+
+/**
+ * 跨日期变更线和极区安全地生成外形
+ * 只有一部分的外形按多边形外环处理，与SymbolFeed、TrackSymbols中的约定一致
+ * @param split 是否在日期变更线处切分；转换到地心坐标绘制时不需要切分，连续的经度没有接缝
+ * @param geodesic 不为NULL时在切分之前把外形的各边加密为大地线（大地线模式）
+ * @param maxSegment 大地线模式下相邻点的最大距离（米）
+ */
+MultiLineString generateOutline(OutlineGenerator generator, const std::vector<osg::Vec2>& controlPoints, bool split = true,
+    const Geodesic* geodesic = NULL, double maxSegment = 0.0);
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include "PointBuffer.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+
+using namespace Math;
+
+PointBuffer::PointBuffer()
+    : _block(NULL)
+    , _x(NULL)
+    , _y(NULL)
+    , _z(NULL)
+    , _size(0)
+    , _capacity(0)
+{
+}
+
+PointBuffer::PointBuffer(unsigned int capacity)
+    : _block(NULL)
+    , _x(NULL)
+    , _y(NULL)
+    , _z(NULL)
+    , _size(0)
+    , _capacity(0)
+{
+    reserve(capacity);
+}
+
+PointBuffer::PointBuffer(const PointBuffer& other)
+    : _block(NULL)
+    , _x(NULL)
+    , _y(NULL)
+    , _z(NULL)
+    , _size(0)
+    , _capacity(0)
+{
+    reserve(other._size);
+    _origin = other._origin;
+    memcpy(_x, other._x, other._size * sizeof(float));
+    memcpy(_y, other._y, other._size * sizeof(float));
+    memcpy(_z, other._z, other._size * sizeof(float));
+    _size = other._size;
+}
+
+PointBuffer& PointBuffer::operator=(const PointBuffer& other)
+{
+    if (this != &other) {
+        PointBuffer copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+PointBuffer::~PointBuffer()
+{
+    free(_block);
+}
+
+void PointBuffer::swap(PointBuffer& other)
+{
+    std::swap(_block, other._block);
+    std::swap(_x, other._x);
+    std::swap(_y, other._y);
+    std::swap(_z, other._z);
+    std::swap(_origin, other._origin);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+}
+
+void PointBuffer::reserve(unsigned int capacity)
+{
+    if (capacity <= _capacity)
+        return;
+
+    // 每个分量数组的长度取ALIGNMENT的整数倍，三个数组的起始地址都对齐
+    const unsigned int floatsPerAlignment = ALIGNMENT / sizeof(float);
+    capacity = (capacity + floatsPerAlignment - 1) / floatsPerAlignment * floatsPerAlignment;
+    void* block = malloc(3 * capacity * sizeof(float) + ALIGNMENT - 1);
+    if (!block)
+        throw std::bad_alloc();
+    uintptr_t aligned = ((uintptr_t)block + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1);
+    float* x = (float*)aligned;
+    float* y = x + capacity;
+    float* z = y + capacity;
+    if (_size) {
+        memcpy(x, _x, _size * sizeof(float));
+        memcpy(y, _y, _size * sizeof(float));
+        memcpy(z, _z, _size * sizeof(float));
+    }
+    free(_block);
+    _block = block;
+    _x = x;
+    _y = y;
+    _z = z;
+    _capacity = capacity;
+}
+
+void PointBuffer::setOrigin(const osg::Vec3d& origin)
+{
+    if (_size) {
+        const float dx = (float)(_origin.x() - origin.x());
+        const float dy = (float)(_origin.y() - origin.y());
+        const float dz = (float)(_origin.z() - origin.z());
+        for (unsigned int i = 0; i < _size; i++) {
+            _x[i] += dx;
+            _y[i] += dy;
+            _z[i] += dz;
+        }
+    }
+    _origin = origin;
+}
+
+void PointBuffer::resize(unsigned int size)
+{
+    reserve(size);
+    if (size > _size) {
+        memset(_x + _size, 0, (size - _size) * sizeof(float));
+        memset(_y + _size, 0, (size - _size) * sizeof(float));
+        memset(_z + _size, 0, (size - _size) * sizeof(float));
+    }
+    _size = size;
+}
+
+void PointBuffer::append(const osg::Vec2* begin, const osg::Vec2* end)
+{
+    unsigned int n = end - begin;
+    reserve(_size + n);
+    float* __restrict x = _x + _size;
+    float* __restrict y = _y + _size;
+    float* __restrict z = _z + _size;
+    const double ox = _origin.x(), oy = _origin.y();
+    const float oz = (float)-_origin.z();
+    for (unsigned int i = 0; i < n; i++) {
+        x[i] = (float)(begin[i].x() - ox);
+        y[i] = (float)(begin[i].y() - oy);
+        z[i] = oz;
+    }
+    _size += n;
+}
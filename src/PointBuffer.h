@@ -0,0 +1,92 @@
+#ifndef POINTBUFFER_H
+#define POINTBUFFER_H
+
+#include <osg/Vec2>
+#include <osg/Vec3>
+#include <osg/Vec3d>
+
+namespace Math {
+
+/**
+ * 结构数组（SoA）形式的点缓冲
+ * x、y、z分别存放在32字节对齐的连续数组中，抽稀等逐点计算按分量顺序遍历，编译器可以直接向量化。
+ * 接口与LineString的push_back/back/clear一致，PlottingKernels中的生成核可以直接写入。
+ *
+ * 分量数组存放相对double原点的float偏移：经度180度处float只有约1.5米的精度，地心坐标更只有约0.5米，
+ * 偏移则在符号范围内保持亚毫米精度。operator[]和getPoint在double中加回原点，不损失精度。
+ * 原点默认为0，与直接存放坐标等价；大坐标的点串应在添加点之前用setOrigin设为其中某点。
+ */
+class PointBuffer {
+public:
+    enum { ALIGNMENT = 32 };
+
+    PointBuffer();
+    explicit PointBuffer(unsigned int capacity);
+    PointBuffer(const PointBuffer& other);
+    PointBuffer& operator=(const PointBuffer& other);
+    ~PointBuffer();
+
+    unsigned int size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    unsigned int capacity() const { return _capacity; }
+    void clear() { _size = 0; }
+    // 分配失败时抛出std::bad_alloc，与std::vector一致
+    void reserve(unsigned int capacity);
+    // 新增的点坐标为0
+    void resize(unsigned int size);
+
+    /**
+     * 设置原点，已有的点平移为相对新原点的偏移，坐标不变
+     */
+    void setOrigin(const osg::Vec3d& origin);
+    const osg::Vec3d& getOrigin() const { return _origin; }
+
+    void push_back(const osg::Vec2& point)
+    {
+        push_back(osg::Vec3d(point.x(), point.y(), 0.0));
+    }
+    void push_back(const osg::Vec3& point)
+    {
+        push_back(osg::Vec3d(point));
+    }
+    void push_back(const osg::Vec3d& point)
+    {
+        if (_size == _capacity)
+            reserve(_capacity ? _capacity * 2 : 64);
+        _x[_size] = (float)(point.x() - _origin.x());
+        _y[_size] = (float)(point.y() - _origin.y());
+        _z[_size] = (float)(point.z() - _origin.z());
+        _size++;
+    }
+
+    osg::Vec2 operator[](unsigned int i) const { return osg::Vec2(_origin.x() + _x[i], _origin.y() + _y[i]); }
+    osg::Vec2 back() const { return (*this)[_size-1]; }
+    osg::Vec3d getPoint(unsigned int i) const { return _origin + osg::Vec3d(_x[i], _y[i], _z[i]); }
+
+    // 各分量数组，存放相对原点的偏移，长度为size()
+    float* x() { return _x; }
+    float* y() { return _y; }
+    float* z() { return _z; }
+    const float* x() const { return _x; }
+    const float* y() const { return _y; }
+    const float* z() const { return _z; }
+
+    // 追加[begin, end)中的二维点，z为0
+    void append(const osg::Vec2* begin, const osg::Vec2* end);
+
+private:
+    void swap(PointBuffer& other);
+
+    // x、y、z共用一块内存，_block为未对齐的原始指针
+    void* _block;
+    float* _x;
+    float* _y;
+    float* _z;
+    osg::Vec3d _origin;
+    unsigned int _size;
+    unsigned int _capacity;
+};
+
+}
+
+#endif
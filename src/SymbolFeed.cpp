@@ -0,0 +1,460 @@
+#include "SymbolFeed.h"
+#include "FeaturePool.h"
+#include "PlottingWrap.h"
+#include "SymbolTypeRegistry.h"
+#include <osg/ValueObject>
+#include <osgEarthSymbology/LineSymbol>
+#include <osgEarthSymbology/PolygonSymbol>
+#include <osgEarthSymbology/AltitudeSymbol>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <string.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace osgEarth;
+using namespace osgEarth::Symbology;
+using namespace osgEarth::Annotation;
+
+namespace {
+const uint32_t FEED_MAGIC = 0x53594d46; // "SYMF"
+const uint32_t FEED_VERSION = 1;
+}
+
+struct SymbolFeedChannel::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    char pad0[48];
+    std::atomic<uint64_t> head; // 写位置，只由推送方修改
+    char pad1[56];
+    std::atomic<uint64_t> tail; // 读位置，只由视图修改
+    char pad2[56];
+};
+
+SymbolFeedChannel::SymbolFeedChannel()
+    : _owner(false)
+    , _handle(NULL)
+    , _memory(NULL)
+    , _size(0)
+    , _header(NULL)
+    , _records(NULL)
+{
+}
+
+SymbolFeedChannel::~SymbolFeedChannel()
+{
+#ifdef _WIN32
+    if (_memory)
+        UnmapViewOfFile(_memory);
+    if (_handle)
+        CloseHandle((HANDLE)_handle);
+#else
+    if (_memory)
+        munmap(_memory, _size);
+    if (_owner)
+        shm_unlink(_name.c_str());
+#endif
+}
+
+SymbolFeedChannel* SymbolFeedChannel::create(const std::string& name, unsigned int capacity)
+{
+    unsigned int rounded = 1;
+    while (rounded < capacity)
+        rounded <<= 1;
+    SymbolFeedChannel* channel = new SymbolFeedChannel;
+    if (!channel->map(name, rounded, true)) {
+        delete channel;
+        return NULL;
+    }
+    return channel;
+}
+
+SymbolFeedChannel* SymbolFeedChannel::open(const std::string& name)
+{
+    SymbolFeedChannel* channel = new SymbolFeedChannel;
+    if (!channel->map(name, 0, false)) {
+        delete channel;
+        return NULL;
+    }
+    return channel;
+}
+
+bool SymbolFeedChannel::map(const std::string& name, unsigned int capacity, bool create)
+{
+#ifdef _WIN32
+    _name = name;
+#else
+    // POSIX共享内存名以/开头
+    _name = name.empty() || name[0] != '/' ? "/" + name : name;
+#endif
+    _owner = create;
+
+    size_t size = sizeof(Header);
+    if (create)
+        size += (size_t)capacity * sizeof(SymbolFeedRecord);
+
+#ifdef _WIN32
+    HANDLE handle;
+    if (create) {
+        handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                    (DWORD)((uint64_t)size >> 32), (DWORD)size, _name.c_str());
+        // 同名映射已存在时返回的是别人的映射，不能重新初始化
+        if (handle && GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(handle);
+            _owner = false;
+            return false;
+        }
+    } else {
+        handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, _name.c_str());
+    }
+    if (!handle)
+        return false;
+    _handle = handle;
+    if (!create) {
+        // 先只映射头部读出容量
+        void* header = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Header));
+        if (!header)
+            return false;
+        const Header* h = (const Header*)header;
+        bool valid = h->magic == FEED_MAGIC && h->version == FEED_VERSION && h->recordSize == sizeof(SymbolFeedRecord);
+        size += (size_t)h->capacity * sizeof(SymbolFeedRecord);
+        UnmapViewOfFile(header);
+        if (!valid)
+            return false;
+    }
+    _memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    // 同名共享内存已存在时失败：它可能属于另一个正在运行的进程，重新初始化会清掉其队列，
+    // 析构时shm_unlink也会删掉别人的名字。崩溃遗留的需要手动删除（/dev/shm下）
+    int fd = shm_open(_name.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+    if (fd < 0) {
+        _owner = false;
+        return false;
+    }
+    if (create) {
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            return false;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+            close(fd);
+            return false;
+        }
+        size = st.st_size;
+    }
+    _memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (_memory == MAP_FAILED) {
+        _memory = NULL;
+        return false;
+    }
+#endif
+    if (!_memory)
+        return false;
+    _size = size;
+    _header = (Header*)_memory;
+    _records = (SymbolFeedRecord*)((char*)_memory + sizeof(Header));
+
+    if (create) {
+        Header* header = new (_memory) Header;
+        header->magic = FEED_MAGIC;
+        header->version = FEED_VERSION;
+        header->capacity = capacity;
+        header->recordSize = sizeof(SymbolFeedRecord);
+        header->head.store(0);
+        header->tail.store(0);
+        return true;
+    }
+    return _header->magic == FEED_MAGIC && _header->version == FEED_VERSION
+        && _header->recordSize == sizeof(SymbolFeedRecord)
+        && sizeof(Header) + (size_t)_header->capacity * sizeof(SymbolFeedRecord) <= _size;
+}
+
+bool SymbolFeedChannel::push(const SymbolFeedRecord& record)
+{
+    const uint64_t head = _header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = _header->tail.load(std::memory_order_acquire);
+    if (head - tail >= _header->capacity)
+        return false;
+    memcpy(&_records[head & (_header->capacity - 1)], &record, sizeof(SymbolFeedRecord));
+    _header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool SymbolFeedChannel::pop(SymbolFeedRecord& record)
+{
+    const uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+    const uint64_t head = _header->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return false;
+    memcpy(&record, &_records[tail & (_header->capacity - 1)], sizeof(SymbolFeedRecord));
+    _header->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+unsigned int SymbolFeedChannel::capacity() const
+{
+    return _header->capacity;
+}
+
+unsigned int SymbolFeedChannel::size() const
+{
+    return (unsigned int)(_header->head.load(std::memory_order_acquire) - _header->tail.load(std::memory_order_acquire));
+}
+
+uint64_t SymbolFeedChannel::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SymbolFeedHandler::SymbolFeedHandler(SymbolFeedChannel* channel, MapNode* mapNode, osg::Group* drawGroup)
+    : _channel(channel)
+    , _mapNode(mapNode)
+    , _drawGroup(drawGroup)
+    , _maxRecordsPerFrame(100000)
+    , _geodesicSegment(0.0)
+    , _received(0)
+    , _applied(0)
+    , _totalLatency(0.0)
+    , _maxLatency(0.0)
+{
+    const osg::EllipsoidModel* ellipsoid = mapNode->getMapSRS()->getEllipsoid();
+    _geodesic = Math::Geodesic(ellipsoid->getRadiusEquator(), 1.0 - ellipsoid->getRadiusPolar() / ellipsoid->getRadiusEquator());
+    // 与标绘工具一致的默认样式：半透明填充白边的多边形，贴地的折线
+    Style polygonStyle;
+    polygonStyle.getOrCreate<PolygonSymbol>()->fill()->color() = Color(Color::Yellow, 0.25);
+    LineSymbol* outline = polygonStyle.getOrCreate<LineSymbol>();
+    outline->stroke()->color() = Color::White;
+    outline->stroke()->width() = 2.0f;
+    outline->stroke()->widthUnits() = Units::PIXELS;
+    polygonStyle.getOrCreate<AltitudeSymbol>()->clamping() = AltitudeSymbol::CLAMP_TO_TERRAIN;
+    polygonStyle.getOrCreate<AltitudeSymbol>()->technique() = AltitudeSymbol::TECHNIQUE_DRAPE;
+    setStyle(0, polygonStyle, true);
+
+    Style lineStyle;
+    LineSymbol* line = lineStyle.getOrCreate<LineSymbol>();
+    line->stroke()->color() = Color::Yellow;
+    line->stroke()->width() = 2.0f;
+    line->stroke()->widthUnits() = Units::PIXELS;
+    lineStyle.getOrCreate<AltitudeSymbol>()->clamping() = AltitudeSymbol::CLAMP_TO_TERRAIN;
+    lineStyle.getOrCreate<AltitudeSymbol>()->technique() = AltitudeSymbol::TECHNIQUE_DRAPE;
+    setStyle(1, lineStyle, false);
+}
+
+SymbolFeedHandler::~SymbolFeedHandler()
+{
+    delete _channel;
+}
+
+void SymbolFeedHandler::setStyle(unsigned int styleId, const Style& style, bool polygon)
+{
+    StyleEntry& entry = _styles[styleId];
+    entry.style = style;
+    entry.polygon = polygon;
+}
+
+bool SymbolFeedHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+    if (ea.getEventType() != osgGA::GUIEventAdapter::FRAME || !_channel)
+        return false;
+
+    _records.clear();
+    _latest.clear();
+    SymbolFeedRecord record;
+    while (_records.size() < _maxRecordsPerFrame && _channel->pop(record)) {
+        _latest[record.id] = _records.size();
+        _records.push_back(record);
+    }
+    if (_records.empty())
+        return false;
+
+    // 每个符号只应用本帧最后一条记录
+    const uint64_t now = SymbolFeedChannel::now();
+    for (unsigned int i = 0; i < _records.size(); i++) {
+        const SymbolFeedRecord& r = _records[i];
+        double latency = (now - r.timestamp) / 1000.0;
+        _totalLatency += latency;
+        _maxLatency = osg::maximum(_maxLatency, latency);
+        if (_latest[r.id] == i) {
+            apply(r);
+            _applied++;
+        }
+    }
+    _received += _records.size();
+    aa.requestRedraw();
+    return false;
+}
+
+void SymbolFeedHandler::apply(const SymbolFeedRecord& record)
+{
+    if (record.op == SymbolFeedRecord::OP_DELETE) {
+        remove(record.id);
+        return;
+    }
+
+    std::map<unsigned int, StyleEntry>::const_iterator style = _styles.find(record.styleId);
+    if (style == _styles.end())
+        style = _styles.begin();
+
+    std::vector<osg::Vec2> controlPoints(osg::minimum(record.numControlPoints, (uint32_t)SymbolFeedRecord::MAX_CONTROL_POINTS));
+    for (unsigned int i = 0; i < controlPoints.size(); i++)
+        controlPoints[i].set(record.controlPoints[i][0], record.controlPoints[i][1]);
+    const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(record.type);
+    if (symbolType && controlPoints.size() < symbolType->minControlPoints)
+        return;
+    Math::MultiLineString outline;
+    if (symbolType && symbolType->outline)
+        outline = Math::generateOutline(symbolType->outline, controlPoints, false, &_geodesic, _geodesicSegment);
+    else
+        outline.push_back(controlPoints);
+    if (outline.empty())
+        return;
+
+    // 几何类型或样式变化时换一个节点
+    const bool polygon = style->second.polygon && outline.size() == 1;
+    std::map<uint64_t, Symbol>::iterator it = _symbols.find(record.id);
+    if (it != _symbols.end() && (it->second.polygon != polygon || it->second.styleId != style->first)) {
+        remove(record.id);
+        it = _symbols.end();
+    }
+    if (it == _symbols.end()) {
+        Symbol symbol;
+        symbol.node = FeaturePool::instance()->acquire(_mapNode, polygon ? Geometry::TYPE_POLYGON : Geometry::TYPE_MULTI, style->second.style);
+        symbol.node->setUserValue("drawType", (int)record.type);
+        symbol.styleId = style->first;
+        symbol.polygon = polygon;
+        _drawGroup->addChild(symbol.node);
+        it = _symbols.insert(std::make_pair(record.id, symbol)).first;
+    } else if (it->second.node->getNumParents() == 0) {
+        // 节点被外部从组中移除时重新挂接
+        _drawGroup->addChild(it->second.node.get());
+    }
+
+    FeatureNode* node = it->second.node.get();
+    Geometry* geom = node->getFeature()->getGeometry();
+    if (polygon) {
+        DrawTool::setGeometryPoints(geom, outline[0]);
+    } else {
+        MultiGeometry* multiGeom = dynamic_cast<MultiGeometry*>(geom);
+        if (!multiGeom || !DrawTool::updateMultiGeometry(multiGeom, outline))
+            return;
+    }
+    node->init();
+}
+
+void SymbolFeedHandler::remove(uint64_t id)
+{
+    std::map<uint64_t, Symbol>::iterator it = _symbols.find(id);
+    if (it == _symbols.end())
+        return;
+    _drawGroup->removeChild(it->second.node.get());
+    FeaturePool::instance()->release(it->second.node.get());
+    _symbols.erase(it);
+}
+
+void SymbolFeedHandler::dump(std::ostream& out) const
+{
+    out << "[SymbolFeed] " << _received << " records received, " << _applied << " applied, "
+        << _symbols.size() << " symbols, " << (_channel ? _channel->size() : 0) << " pending" << std::endl;
+    if (_received)
+        out << "[SymbolFeed] latency mean " << std::fixed << std::setprecision(1) << _totalLatency / _received
+            << " us, max " << _maxLatency << " us (push to frame)" << std::endl;
+}
+
+SymbolFeedBench::SymbolFeedBench(unsigned int symbols, unsigned int rate, double seconds)
+    : _symbols(osg::maximum(symbols, 1u))
+    , _rate(osg::maximum(rate, 1u))
+    , _seconds(seconds)
+{
+}
+
+bool SymbolFeedBench::run(const std::string& name, std::ostream& log)
+{
+    std::unique_ptr<SymbolFeedChannel> channel(SymbolFeedChannel::open(name));
+    if (!channel) {
+        log << "Failed to open symbol feed " << name << std::endl;
+        return false;
+    }
+
+    // 只推送有外形函数的符号，每个符号取最少的控制点数
+    std::vector<const SymbolType*> types;
+    const std::vector<SymbolType>& allTypes = SymbolTypeRegistry::instance()->getTypes();
+    for (unsigned int i = 0; i < allTypes.size(); i++) {
+        if (allTypes[i].outline && allTypes[i].minControlPoints <= SymbolFeedRecord::MAX_CONTROL_POINTS)
+            types.push_back(&allTypes[i]);
+    }
+    if (types.empty())
+        return false;
+
+    std::vector<SymbolFeedRecord> records(_symbols);
+    unsigned int state = 1;
+    for (unsigned int i = 0; i < _symbols; i++) {
+        SymbolFeedRecord& record = records[i];
+        memset(&record, 0, sizeof(record));
+        const SymbolType* type = types[i % types.size()];
+        record.op = SymbolFeedRecord::OP_CREATE;
+        record.type = type->type;
+        record.id = i + 1;
+        record.styleId = type->type == DrawTool::DRAW_PARALLELSEARCH || type->type == DrawTool::DRAW_SECTORSEARCH
+                || type->type == DrawTool::DRAW_RANGERINGS ? 1 : 0;
+        record.numControlPoints = osg::maximum(type->minControlPoints, 2u);
+        state = state * 1664525u + 1013904223u;
+        float lon = -170.0f + 340.0f * (state >> 8) / 16777216.0f;
+        state = state * 1664525u + 1013904223u;
+        float lat = -70.0f + 140.0f * (state >> 8) / 16777216.0f;
+        for (unsigned int k = 0; k < record.numControlPoints; k++) {
+            record.controlPoints[k][0] = lon + 0.1f * k;
+            record.controlPoints[k][1] = lat + 0.05f * (k % 2);
+        }
+    }
+
+    const uint64_t start = SymbolFeedChannel::now();
+    uint64_t pushed = 0, full = 0, pushNs = 0, maxPushNs = 0;
+    const uint64_t total = _symbols + (uint64_t)(_rate * _seconds);
+    while (pushed < total) {
+        // 按速率限流，创建记录不限流
+        double elapsed = (SymbolFeedChannel::now() - start) / 1.0e9;
+        if (pushed >= _symbols && pushed - _symbols >= _rate * elapsed) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        SymbolFeedRecord& record = records[pushed % _symbols];
+        if (pushed >= _symbols) {
+            record.op = SymbolFeedRecord::OP_UPDATE;
+            for (unsigned int k = 0; k < record.numControlPoints; k++)
+                record.controlPoints[k][0] += 0.001f;
+        }
+        record.timestamp = SymbolFeedChannel::now();
+        if (!channel->push(record)) {
+            full++;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+        uint64_t ns = SymbolFeedChannel::now() - record.timestamp;
+        pushNs += ns;
+        maxPushNs = osg::maximum(maxPushNs, ns);
+        pushed++;
+    }
+    double seconds = (SymbolFeedChannel::now() - start) / 1.0e9;
+    log << std::fixed << std::setprecision(1)
+        << "Pushed " << pushed << " records (" << _symbols << " symbols) in " << seconds << " s: "
+        << pushed / seconds << " records/s, buffer full " << full << " times" << std::endl
+        << "push mean " << (double)pushNs / pushed << " ns, max " << maxPushNs << " ns" << std::endl;
+    return true;
+}
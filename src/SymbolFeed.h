@@ -0,0 +1,167 @@
+#ifndef SYMBOLFEED_H
+#define SYMBOLFEED_H 1
+
+#include <osgEarth/MapNode>
+#include <osgEarthAnnotation/FeatureNode>
+#include <osgEarthSymbology/Style>
+#include <osgGA/GUIEventHandler>
+#include <stdint.h>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "PlottingGeodesic.h"
+
+/**
+ * 外部进程推送的符号记录
+ * 定长，直接在共享内存的环形缓冲中读写，不做序列化
+ */
+struct SymbolFeedRecord {
+    enum { MAX_CONTROL_POINTS = 64 };
+    enum Op {
+        OP_CREATE = 1, // 创建，id已存在时按更新处理
+        OP_UPDATE = 2, // 更新控制点和样式，id不存在时按创建处理
+        OP_DELETE = 3,
+    };
+
+    uint32_t op;
+    int32_t type; // 符号类型（SymbolType::type）
+    uint64_t id; // 由推送方分配的符号标识
+    uint32_t styleId; // SymbolFeedHandler::setStyle中登记的样式
+    uint32_t numControlPoints;
+    uint64_t timestamp; // 推送时刻，steady_clock的纳秒数，用于统计接收延迟
+    float controlPoints[MAX_CONTROL_POINTS][2]; // 经度、纬度
+};
+
+/**
+ * 共享内存中的单生产者单消费者环形缓冲
+ * 头部记录容量和读写位置，读写位置各占一个缓存行；推送方只写写位置，视图只写读位置，
+ * 两边都不加锁。缓冲满时push立即返回false，由推送方决定丢弃还是重试。
+ * 共享内存由视图创建（create），推送进程按同一名字打开（open）。
+ */
+class SymbolFeedChannel {
+public:
+    ~SymbolFeedChannel();
+
+    /**
+     * 创建共享内存，同名的已经存在时返回NULL，不会改动别人的队列
+     * @param name 共享内存名，POSIX下对应/dev/shm中的文件
+     * @param capacity 记录数，向上取2的幂
+     */
+    static SymbolFeedChannel* create(const std::string& name, unsigned int capacity = 65536);
+    // 打开已创建的共享内存，名字不存在或格式不符时返回NULL
+    static SymbolFeedChannel* open(const std::string& name);
+
+    // 推送一条记录，缓冲满时返回false
+    bool push(const SymbolFeedRecord& record);
+    // 取出一条记录，缓冲空时返回false
+    bool pop(SymbolFeedRecord& record);
+
+    unsigned int capacity() const;
+    // 缓冲中尚未取出的记录数
+    unsigned int size() const;
+
+    // steady_clock的纳秒数，与SymbolFeedRecord::timestamp一致
+    static uint64_t now();
+
+private:
+    struct Header;
+
+    SymbolFeedChannel();
+    SymbolFeedChannel(const SymbolFeedChannel&);
+    SymbolFeedChannel& operator=(const SymbolFeedChannel&);
+
+    bool map(const std::string& name, unsigned int capacity, bool create);
+
+    std::string _name;
+    bool _owner; // 创建者析构时删除共享内存
+    void* _handle;
+    void* _memory;
+    size_t _size;
+    Header* _header;
+    SymbolFeedRecord* _records;
+};
+
+/**
+ * 每帧从SymbolFeedChannel取出记录并更新绘制组
+ * 一帧中同一符号的多条记录只应用最后一条；外形由注册表的外形函数计算，没有外形函数的类型直接用控制点。
+ * 样式决定几何类型：多边形样式下单环的外形画为多边形，其余画为折线。
+ * 要素节点从FeaturePool获取，删除时回收，不进入撤销栈。
+ * 符号的生命周期由推送方决定，应挂在单独的组中，不受清除工具影响，只由OP_DELETE删除。
+ */
+class SymbolFeedHandler : public osgGA::GUIEventHandler {
+public:
+    // channel由处理器持有，析构时释放
+    SymbolFeedHandler(SymbolFeedChannel* channel, osgEarth::MapNode* mapNode, osg::Group* drawGroup);
+    ~SymbolFeedHandler();
+
+    virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
+
+    /**
+     * 登记样式，默认0为多边形样式，1为折线样式
+     * @param polygon 是否为多边形样式
+     */
+    void setStyle(unsigned int styleId, const osgEarth::Symbology::Style& style, bool polygon);
+
+    // 大地线模式：外形的各边加密为大地线，相邻点不超过meters米；为0时关闭
+    void setGeodesicSegment(double meters) { _geodesicSegment = meters; }
+
+    // 每帧最多处理的记录数，其余留在缓冲中下一帧处理
+    void setMaxRecordsPerFrame(unsigned int count) { _maxRecordsPerFrame = count; }
+
+    // 打印接收记录数和延迟统计
+    void dump(std::ostream& out) const;
+
+private:
+    struct StyleEntry {
+        osgEarth::Symbology::Style style;
+        bool polygon;
+    };
+    struct Symbol {
+        osg::ref_ptr<osgEarth::Annotation::FeatureNode> node;
+        unsigned int styleId;
+        bool polygon;
+    };
+
+    void apply(const SymbolFeedRecord& record);
+    void remove(uint64_t id);
+
+    SymbolFeedChannel* _channel;
+    osgEarth::MapNode* _mapNode;
+    osg::Group* _drawGroup;
+    unsigned int _maxRecordsPerFrame;
+    Math::Geodesic _geodesic;
+    double _geodesicSegment;
+    std::map<unsigned int, StyleEntry> _styles;
+    std::map<uint64_t, Symbol> _symbols;
+
+    // 本帧取出的记录，以及每个id最后一条记录的下标
+    std::vector<SymbolFeedRecord> _records;
+    std::map<uint64_t, unsigned int> _latest;
+
+    // 统计
+    uint64_t _received;
+    uint64_t _applied;
+    double _totalLatency; // 微秒
+    double _maxLatency;
+};
+
+/**
+ * 推送方的压力测试，模拟一个外部进程
+ * 先为symbols个符号推送创建记录，之后按rate条每秒轮流更新它们的控制点（整体平移），
+ * 持续seconds秒；缓冲满时等待视图取出后重试。报告实际速率、缓冲满的次数和单次push的耗时。
+ */
+class SymbolFeedBench {
+public:
+    SymbolFeedBench(unsigned int symbols = 10000, unsigned int rate = 100000, double seconds = 10.0);
+
+    bool run(const std::string& name, std::ostream& log);
+
+private:
+    unsigned int _symbols;
+    unsigned int _rate;
+    double _seconds;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "SymbolTypeRegistry.h"
+#include <osgEarth/Notify>
+
+#include "DrawLineTool.h"
+#include "DrawRectangleTool.h"
+#include "DrawPolygonTool.h"
+#include "DrawCircleTool.h"
+#include "GeoStraightArrow.h"
+#include "GeoDoubleArrow.h"
+#include "GeoDiagonalArrow.h"
+#include "GeoGatheringPlace.h"
+#include "GeoLune.h"
+#include "GeoParallelSearch.h"
+#include "GeoSectorSearch.h"
+#include "GeoRangeRings.h"
+
+#define LC "[SymbolTypeRegistry] "
+
+SymbolTypeRegistry::SymbolTypeRegistry()
+{
+    registerBuiltins();
+}
+
+SymbolTypeRegistry *SymbolTypeRegistry::instance()
+{
+    static SymbolTypeRegistry ins;
+    return &ins;
+}
+
+bool SymbolTypeRegistry::registerType(const SymbolType& symbolType)
+{
+    if (!symbolType.factory || _index.find(symbolType.type) != _index.end()) {
+        OE_WARN << LC << "Symbol type " << symbolType.type << " (" << symbolType.name << ") is already registered or has no factory" << std::endl;
+        return false;
+    }
+    _index[symbolType.type] = _types.size();
+    _types.push_back(symbolType);
+    return true;
+}
+
+const SymbolType* SymbolTypeRegistry::getType(int type) const
+{
+    std::map<int, unsigned int>::const_iterator it = _index.find(type);
+    return it != _index.end() ? &_types[it->second] : NULL;
+}
+
+bool SymbolTypeRegistry::loadPlugin(const std::string& libraryName)
+{
+    osg::ref_ptr<osgDB::DynamicLibrary> library = osgDB::DynamicLibrary::loadLibrary(libraryName);
+    if (!library.valid()) {
+        OE_WARN << LC << "Failed to load symbol plugin " << libraryName << std::endl;
+        return false;
+    }
+
+    RegisterSymbolsFunction registerSymbols = (RegisterSymbolsFunction)library->getProcAddress("registerPlottingSymbols");
+    if (!registerSymbols) {
+        OE_WARN << LC << libraryName << " does not export registerPlottingSymbols" << std::endl;
+        return false;
+    }
+
+    registerSymbols(this);
+    _plugins.push_back(library);
+    return true;
+}
+
+void SymbolTypeRegistry::registerBuiltins()
+{
+    SymbolType types[] = {
+        { DrawTool::DRAW_LINE, "Line", 2, 0, &createTool<DrawLineTool>, NULL },
+        { DrawTool::DRAW_RECTANGLE, "Rectangle", 2, 2, &createTool<DrawRectangleTool>, NULL },
+        { DrawTool::DRAW_POLYGON, "Polygon", 3, 0, &createTool<DrawPolygonTool>, NULL },
+        { DrawTool::DRAW_CIRCLE, "Circle", 2, 2, &createTool<DrawCircleTool>, NULL },
+        { DrawTool::DRAW_STRAIGHTARROW, "StraightArrow", 2, 0, &createTool<GeoStraightArrow>, &GeoStraightArrow::calculateOutline },
+        { DrawTool::DRAW_DOUBLEARROW, "DoubleArrow", 4, 4, &createTool<GeoDoubleArrow>, &GeoDoubleArrow::calculateOutline },
+        { DrawTool::DRAW_DIAGONALARROW, "DiagonalArrow", 2, 0, &createTool<GeoDiagonalArrow>, &GeoDiagonalArrow::calculateOutline },
+        { DrawTool::DRAW_GATHERINGPLACE, "GatheringPlace", 2, 2, &createTool<GeoGatheringPlace>, &GeoGatheringPlace::calculateOutline },
+        { DrawTool::DRAW_GEOLUNE, "Lune", 2, 3, &createTool<GeoLune>, &GeoLune::calculateOutline },
+        { DrawTool::DRAW_PARALLELSEARCH, "ParallelSearch", 2, 0, &createTool<GeoParallelSearch>, &GeoParallelSearch::calculateOutline },
+        { DrawTool::DRAW_SECTORSEARCH, "SectorSearch", 2, 2, &createTool<GeoSectorSearch>, &GeoSectorSearch::calculateOutline },
+        { DrawTool::DRAW_RANGERINGS, "RangeRings", 2, 0, &createTool<GeoRangeRings>, &GeoRangeRings::calculateOutline },
+    };
+    for (unsigned int i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+        registerType(types[i]);
+}
@@ -0,0 +1,75 @@
+#ifndef SYMBOLTYPEREGISTRY_H
+#define SYMBOLTYPEREGISTRY_H 1
+
+#include <osgDB/DynamicLibrary>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "DrawTool.h"
+#include "PlottingMath.h"
+
+class SymbolTypeRegistry;
+
+// 创建绘制工具
+typedef DrawTool* (*ToolFactory)(osgEarth::MapNode* mapNode, osg::Group* drawGroup);
+// 由控制点计算符号外形，不依赖工具实例，可以直接批量调用
+typedef Math::MultiLineString (*OutlineFunction)(const std::vector<osg::Vec2>& controlPoints);
+// 插件导出的注册函数，函数名为registerPlottingSymbols
+typedef void (*RegisterSymbolsFunction)(SymbolTypeRegistry* registry);
+
+// 以构造函数(mapNode, drawGroup)创建工具T的工厂
+template<class T>
+DrawTool* createTool(osgEarth::MapNode* mapNode, osg::Group* drawGroup)
+{
+    return new T(mapNode, drawGroup);
+}
+
+/**
+ * 符号类型描述
+ */
+struct SymbolType {
+    int type; // 符号类型，内置符号为DrawTool::DrawType的值，插件从DrawTool::DRAW_USER开始编号
+    std::string name;
+    unsigned int minControlPoints; // 生成外形至少需要的控制点数
+    unsigned int maxControlPoints; // 最多的控制点数，0表示不限
+    ToolFactory factory;
+    OutlineFunction outline; // 为NULL时符号外形就是控制点本身（线、多边形等）
+};
+
+/**
+ * 符号类型注册表
+ * 内置符号和插件中的符号在启动时注册，工具集由注册表创建，
+ * 批量生成时可以按类型直接取外形函数，不经过DrawTool的虚函数。
+ */
+class SymbolTypeRegistry {
+public:
+    static SymbolTypeRegistry* instance();
+
+    // 注册符号类型，类型已存在时返回false
+    bool registerType(const SymbolType& symbolType);
+    const SymbolType* getType(int type) const;
+    // 按注册顺序排列的全部类型
+    const std::vector<SymbolType>& getTypes() const { return _types; }
+
+    /**
+     * 加载符号插件
+     * 插件需要导出 extern "C" void registerPlottingSymbols(SymbolTypeRegistry*)
+     * @param libraryName 动态库路径
+     */
+    bool loadPlugin(const std::string& libraryName);
+
+private:
+    SymbolTypeRegistry();
+    SymbolTypeRegistry(const SymbolTypeRegistry&);
+    SymbolTypeRegistry& operator=(const SymbolTypeRegistry&);
+
+    // 注册内置符号
+    void registerBuiltins();
+
+    std::vector<SymbolType> _types;
+    std::map<int, unsigned int> _index; // 类型到_types下标
+    std::vector<osg::ref_ptr<osgDB::DynamicLibrary> > _plugins;
+};
+
+#endif
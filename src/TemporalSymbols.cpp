@@ -0,0 +1,537 @@
+#include "TemporalSymbols.h"
+#include "SymbolTypeRegistry.h"
+#include <osgEarth/Notify>
+#include <osg/Timer>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#define LC "[TemporalPlayer] "
+
+namespace {
+// 前进后退的步长（秒）
+const double SEEK_STEP = 300.0;
+
+float nextRandom(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+void printStats(std::ostream& out, const char* name, std::vector<double>& values)
+{
+    if (values.empty())
+        return;
+    double total = 0.0;
+    for (unsigned int i = 0; i < values.size(); i++)
+        total += values[i];
+    std::sort(values.begin(), values.end());
+    out << LC << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+        << " mean " << std::setw(8) << total / values.size()
+        << "  p50 " << std::setw(8) << values[values.size() / 2]
+        << "  p99 " << std::setw(8) << values[osg::minimum((unsigned int)(values.size() * 0.99), (unsigned int)values.size() - 1)]
+        << "  max " << std::setw(8) << values.back() << " ms" << std::endl;
+}
+
+// 时刻格式化为h:mm:ss
+std::string formatTime(double seconds)
+{
+    long long s = (long long)osg::maximum(seconds, 0.0);
+    std::ostringstream out;
+    out << s / 3600 << ":" << std::setfill('0') << std::setw(2) << s / 60 % 60 << ":" << std::setw(2) << s % 60;
+    return out.str();
+}
+
+// 回放速度，不受流上fixed等格式的影响
+std::string formatRate(double rate)
+{
+    std::ostringstream out;
+    out << rate << "x";
+    return out.str();
+}
+}
+
+void TimeIntervalIndex::build(const std::vector<double>& begins, const std::vector<double>& ends)
+{
+    _begins = begins;
+    _ends = ends;
+    const size_t n = _begins.size();
+    _maxEnds.resize(n);
+    _maxLevel = -1;
+    if (n == 0)
+        return;
+
+    // 偶数下标为叶子；last为最右侧不完整路径上的最大终点，补齐缺失的右子树
+    size_t lastI = 0;
+    double last = 0.0;
+    for (size_t i = 0; i < n; i += 2) {
+        lastI = i;
+        last = _maxEnds[i] = _ends[i];
+    }
+    int k = 1;
+    for (; ((size_t)1 << k) <= n; k++) {
+        const size_t x = (size_t)1 << (k - 1), i0 = (x << 1) - 1, step = x << 2;
+        for (size_t i = i0; i < n; i += step) {
+            double left = _maxEnds[i - x];
+            double right = i + x < n ? _maxEnds[i + x] : last;
+            _maxEnds[i] = osg::maximum(_ends[i], osg::maximum(left, right));
+        }
+        // lastI移到父节点
+        lastI = (lastI >> k & 1) ? lastI - x : lastI + x;
+        if (lastI < n && _maxEnds[lastI] > last)
+            last = _maxEnds[lastI];
+    }
+    _maxLevel = k - 1;
+}
+
+void TimeIntervalIndex::query(double t, std::vector<unsigned int>& result) const
+{
+    result.clear();
+    if (_maxLevel < 0)
+        return;
+
+    // 中序遍历，w表示左子树是否已处理，结果自然按下标升序
+    struct Item {
+        int level;
+        size_t x;
+        int w;
+    };
+    Item stack[64];
+    int top = 0;
+    const size_t n = _begins.size();
+    stack[top].level = _maxLevel;
+    stack[top].x = ((size_t)1 << _maxLevel) - 1;
+    stack[top++].w = 0;
+    while (top > 0) {
+        const Item z = stack[--top];
+        if (z.level <= 3) {
+            // 小子树直接顺序扫描
+            size_t i0 = z.x >> z.level << z.level;
+            size_t i1 = osg::minimum(i0 + ((size_t)1 << (z.level + 1)) - 1, n);
+            for (size_t i = i0; i < i1 && _begins[i] <= t; i++) {
+                if (t < _ends[i])
+                    result.push_back(i);
+            }
+        } else if (z.w == 0) {
+            const size_t y = z.x - ((size_t)1 << (z.level - 1));
+            stack[top].level = z.level;
+            stack[top].x = z.x;
+            stack[top++].w = 1;
+            if (y >= n || _maxEnds[y] > t) {
+                stack[top].level = z.level - 1;
+                stack[top].x = y;
+                stack[top++].w = 0;
+            }
+        } else if (z.x < n && _begins[z.x] <= t) {
+            if (t < _ends[z.x])
+                result.push_back(z.x);
+            stack[top].level = z.level - 1;
+            stack[top].x = z.x + ((size_t)1 << (z.level - 1));
+            stack[top++].w = 0;
+        }
+    }
+}
+
+TemporalPlan::TemporalPlan()
+    : _begin(0.0)
+    , _end(0.0)
+{
+}
+
+bool TemporalPlan::read(const std::string& fileName, std::ostream& log)
+{
+    std::ifstream in(fileName.c_str());
+    if (!in.is_open()) {
+        log << "Failed to open plan " << fileName << std::endl;
+        return false;
+    }
+
+    _symbols.clear();
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream record(line);
+        std::string keyword;
+        record >> keyword;
+        if (keyword == "symbol") {
+            TemporalSymbol symbol;
+            int type = 0;
+            float r = 1.0f, g = 1.0f, b = 0.0f, a = 1.0f;
+            record >> symbol.id >> type >> symbol.begin >> symbol.end >> r >> g >> b >> a;
+            if (record.fail() || symbol.end <= symbol.begin) {
+                log << fileName << ":" << lineNumber << ": bad symbol" << std::endl;
+                return false;
+            }
+            symbol.type = type;
+            symbol.color.set(r, g, b, a);
+            _symbols.push_back(symbol);
+        } else if (keyword == "key") {
+            TemporalSymbol::Keyframe keyframe;
+            record >> keyframe.time;
+            osg::Vec2 point;
+            while (record >> point.x() >> point.y())
+                keyframe.controlPoints.push_back(point);
+            if (_symbols.empty() || keyframe.controlPoints.empty()
+                || (!_symbols.back().keyframes.empty() && _symbols.back().keyframes[0].controlPoints.size() != keyframe.controlPoints.size())) {
+                log << fileName << ":" << lineNumber << ": bad keyframe" << std::endl;
+                return false;
+            }
+            _symbols.back().keyframes.push_back(keyframe);
+        } else {
+            log << fileName << ":" << lineNumber << ": unknown record " << keyword << std::endl;
+            return false;
+        }
+    }
+    finalize();
+    log << "Read " << _symbols.size() << " symbols from " << fileName << ", " << formatTime(_begin)
+        << " - " << formatTime(_end) << std::endl;
+    return true;
+}
+
+bool TemporalPlan::write(const std::string& fileName) const
+{
+    std::ofstream out(fileName.c_str());
+    if (!out.is_open())
+        return false;
+
+    out << "# symbol id type begin end r g b a\n# key time x1 y1 ... xn yn\n";
+    for (unsigned int i = 0; i < _symbols.size(); i++) {
+        const TemporalSymbol& symbol = _symbols[i];
+        out << std::setprecision(10) << "symbol " << symbol.id << " " << symbol.type << " " << symbol.begin << " " << symbol.end
+            << std::setprecision(3) << " " << symbol.color.r() << " " << symbol.color.g() << " " << symbol.color.b() << " " << symbol.color.a() << "\n";
+        for (unsigned int k = 0; k < symbol.keyframes.size(); k++) {
+            const TemporalSymbol::Keyframe& keyframe = symbol.keyframes[k];
+            out << std::setprecision(10) << "key " << keyframe.time << std::setprecision(9);
+            for (unsigned int p = 0; p < keyframe.controlPoints.size(); p++)
+                out << " " << keyframe.controlPoints[p].x() << " " << keyframe.controlPoints[p].y();
+            out << "\n";
+        }
+    }
+    return out.good();
+}
+
+void TemporalPlan::generate(unsigned int symbols, double duration)
+{
+    const DrawTool::DrawType types[] = {
+        DrawTool::DRAW_STRAIGHTARROW,
+        DrawTool::DRAW_DIAGONALARROW,
+        DrawTool::DRAW_DOUBLEARROW,
+        DrawTool::DRAW_GATHERINGPLACE,
+        DrawTool::DRAW_PARALLELSEARCH,
+        DrawTool::DRAW_SECTORSEARCH,
+    };
+    const unsigned int numTypes = sizeof(types) / sizeof(types[0]);
+    const osg::Vec4 colors[] = {
+        osg::Vec4(1.0f, 0.2f, 0.2f, 1.0f),
+        osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f),
+        osg::Vec4(0.2f, 0.6f, 1.0f, 1.0f),
+    };
+    const osg::Vec2 center(110.0f, 30.0f);
+    const float radius = 10.0f;
+
+    _symbols.clear();
+    _symbols.reserve(symbols);
+    unsigned int state = 1;
+    for (unsigned int i = 0; i < symbols; i++) {
+        const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(types[i % numTypes]);
+        if (!symbolType)
+            continue;
+
+        TemporalSymbol symbol;
+        symbol.id = i + 1;
+        symbol.type = symbolType->type;
+        symbol.color = colors[i % 3];
+        double length = 600.0 + nextRandom(state) * (4.0 * 3600.0 - 600.0);
+        symbol.begin = nextRandom(state) * osg::maximum(duration - length, 0.0);
+        symbol.end = symbol.begin + length;
+
+        float heading = nextRandom(state) * 2.0f * osg::PI;
+        float speed = 0.0002f + 0.0008f * nextRandom(state); // 度每秒
+        osg::Vec2 forward(cosf(heading), sinf(heading));
+        osg::Vec2 side(-forward.y(), forward.x());
+        osg::Vec2 position(center.x() + (nextRandom(state) * 2.0f - 1.0f) * radius,
+            center.y() + (nextRandom(state) * 2.0f - 1.0f) * radius * 0.5f);
+
+        // 关键帧均匀分布在时间窗口内，偶数区段停留不动
+        const unsigned int numKeys = 2 + i % 3;
+        const unsigned int numPoints = osg::maximum(symbolType->minControlPoints, 2u);
+        for (unsigned int k = 0; k < numKeys; k++) {
+            TemporalSymbol::Keyframe keyframe;
+            keyframe.time = symbol.begin + length * k / (numKeys - 1);
+            if (k > 0 && k % 2 == 1)
+                position += forward * (speed * (float)(length / (numKeys - 1)));
+            keyframe.controlPoints.resize(numPoints);
+            for (unsigned int p = 0; p < numPoints; p++)
+                keyframe.controlPoints[p] = position + forward * (0.05f * p) + side * (0.02f * (p % 2));
+            symbol.keyframes.push_back(keyframe);
+        }
+        _symbols.push_back(symbol);
+    }
+    finalize();
+}
+
+void TemporalPlan::addSymbol(const TemporalSymbol& symbol)
+{
+    _symbols.push_back(symbol);
+}
+
+namespace {
+bool keyframeLess(const TemporalSymbol::Keyframe& a, const TemporalSymbol::Keyframe& b)
+{
+    return a.time < b.time;
+}
+
+bool beginLess(const TemporalSymbol& a, const TemporalSymbol& b)
+{
+    return a.begin < b.begin;
+}
+
+bool noKeyframes(const TemporalSymbol& symbol)
+{
+    return symbol.keyframes.empty();
+}
+}
+
+void TemporalPlan::finalize()
+{
+    _symbols.erase(std::remove_if(_symbols.begin(), _symbols.end(), noKeyframes), _symbols.end());
+    for (unsigned int i = 0; i < _symbols.size(); i++)
+        std::stable_sort(_symbols[i].keyframes.begin(), _symbols[i].keyframes.end(), keyframeLess);
+    std::stable_sort(_symbols.begin(), _symbols.end(), beginLess);
+
+    std::vector<double> begins(_symbols.size()), ends(_symbols.size());
+    _begin = _symbols.empty() ? 0.0 : _symbols.front().begin;
+    _end = _begin;
+    for (unsigned int i = 0; i < _symbols.size(); i++) {
+        begins[i] = _symbols[i].begin;
+        ends[i] = _symbols[i].end;
+        _end = osg::maximum(_end, ends[i]);
+    }
+    _index.build(begins, ends);
+}
+
+TemporalPlayer::TemporalPlayer(const TemporalPlan* plan, TrackSymbolLayer* layer)
+    : _plan(plan)
+    , _layer(layer)
+    , _time(plan->getBegin())
+    , _rate(60.0)
+    , _playing(true)
+    , _lastFrameTime(-1.0)
+    , _updatedTime(-1.0)
+    , _segments(plan->getSymbols().size(), 0)
+    , _updates(0)
+    , _entered(0)
+    , _left(0)
+    , _interpolated(0)
+    , _totalMs(0.0)
+    , _maxMs(0.0)
+{
+}
+
+bool TemporalPlayer::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+    switch (ea.getEventType()) {
+    case osgGA::GUIEventAdapter::FRAME:
+        if (_playing && _lastFrameTime >= 0.0) {
+            setTime(_time + (ea.getTime() - _lastFrameTime) * _rate);
+            if (_time >= _plan->getEnd())
+                _playing = false;
+        }
+        _lastFrameTime = ea.getTime();
+        update();
+        return false;
+
+    case osgGA::GUIEventAdapter::KEYDOWN:
+        switch (ea.getKey()) {
+        case 'p':
+            _playing = !_playing;
+            break;
+        case '[':
+            _rate *= 0.5;
+            break;
+        case ']':
+            _rate *= 2.0;
+            break;
+        case ',':
+            setTime(_time - SEEK_STEP);
+            break;
+        case '.':
+            setTime(_time + SEEK_STEP);
+            break;
+        default:
+            return false;
+        }
+        OE_NOTICE << LC << formatTime(_time) << (_playing ? " playing " : " paused ") << formatRate(_rate) << ", "
+            << _previous.size() << " symbols active" << std::endl;
+        aa.requestRedraw();
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void TemporalPlayer::setTime(double time)
+{
+    _time = osg::clampBetween(time, _plan->getBegin(), _plan->getEnd());
+}
+
+void TemporalPlayer::update()
+{
+    if (_time == _updatedTime)
+        return;
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    const std::vector<TemporalSymbol>& symbols = _plan->getSymbols();
+    _plan->getIndex().query(_time, _active);
+
+    // 两个升序集合归并，得到离开、进入和保持的符号
+    unsigned int i = 0, j = 0;
+    while (i < _previous.size() || j < _active.size()) {
+        if (j == _active.size() || (i < _previous.size() && _previous[i] < _active[j])) {
+            _layer->removeSymbol(symbols[_previous[i]].id);
+            _left++;
+            i++;
+            continue;
+        }
+
+        const unsigned int index = _active[j];
+        const TemporalSymbol& symbol = symbols[index];
+        const bool entered = i == _previous.size() || _active[j] < _previous[i];
+        unsigned int segment = findSegment(symbol, _time, _segments[index]);
+        if (entered) {
+            interpolate(symbol, segment, _time, _points);
+            _layer->addSymbol(symbol.id, symbol.type, _points, symbol.color);
+            _entered++;
+        } else {
+            if (segment != _segments[index] || isMoving(symbol, segment)) {
+                interpolate(symbol, segment, _time, _points);
+                _layer->setControlPoints(symbol.id, _points);
+                _interpolated++;
+            }
+            i++;
+        }
+        _segments[index] = segment;
+        j++;
+    }
+    _previous.swap(_active);
+    _updatedTime = _time;
+
+    double ms = osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick());
+    _updates++;
+    _totalMs += ms;
+    _maxMs = osg::maximum(_maxMs, ms);
+}
+
+unsigned int TemporalPlayer::findSegment(const TemporalSymbol& symbol, double t, unsigned int hint)
+{
+    const std::vector<TemporalSymbol::Keyframe>& keyframes = symbol.keyframes;
+    const unsigned int m = keyframes.size();
+    // 顺序回放时多数落在上次的区段或下一个区段
+    for (unsigned int s = hint; s <= osg::minimum(hint + 1, m); s++) {
+        if ((s == 0 || keyframes[s - 1].time <= t) && (s == m || keyframes[s].time > t))
+            return s;
+    }
+    unsigned int low = 0, high = m;
+    while (low < high) {
+        unsigned int mid = (low + high) / 2;
+        if (keyframes[mid].time <= t)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+bool TemporalPlayer::isMoving(const TemporalSymbol& symbol, unsigned int segment)
+{
+    return segment > 0 && segment < symbol.keyframes.size()
+        && symbol.keyframes[segment - 1].controlPoints != symbol.keyframes[segment].controlPoints;
+}
+
+void TemporalPlayer::interpolate(const TemporalSymbol& symbol, unsigned int segment, double t, std::vector<osg::Vec2>& points)
+{
+    const std::vector<TemporalSymbol::Keyframe>& keyframes = symbol.keyframes;
+    if (segment == 0) {
+        points = keyframes.front().controlPoints;
+        return;
+    }
+    if (segment >= keyframes.size()) {
+        points = keyframes.back().controlPoints;
+        return;
+    }
+
+    const TemporalSymbol::Keyframe& a = keyframes[segment - 1];
+    const TemporalSymbol::Keyframe& b = keyframes[segment];
+    const float s = (float)((t - a.time) / (b.time - a.time));
+    points.resize(a.controlPoints.size());
+    for (unsigned int i = 0; i < points.size(); i++)
+        points[i] = a.controlPoints[i] + (b.controlPoints[i] - a.controlPoints[i]) * s;
+}
+
+void TemporalPlayer::dump(std::ostream& out) const
+{
+    out << LC << formatTime(_time) << (_playing ? " playing " : " paused ") << formatRate(_rate) << ", "
+        << _previous.size() << " of " << _plan->getSymbols().size() << " symbols active" << std::endl;
+    if (_updates)
+        out << LC << _updates << " updates, mean " << std::fixed << std::setprecision(3) << _totalMs / _updates
+            << " ms, max " << _maxMs << " ms; " << _entered << " entered, " << _left << " left, "
+            << _interpolated << " interpolated" << std::endl;
+}
+
+bool TemporalPlayer::bench(const TemporalPlan& plan, const osg::EllipsoidModel* ellipsoid, std::ostream& log, double rate, unsigned int jumps)
+{
+    if (plan.getSymbols().empty())
+        return false;
+
+    osg::ref_ptr<TrackSymbolLayer> layer = new TrackSymbolLayer(ellipsoid);
+    osg::ref_ptr<TemporalPlayer> player = new TemporalPlayer(&plan, layer.get());
+    osg::Timer* timer = osg::Timer::instance();
+    std::vector<double> playerMs, layerMs;
+    unsigned int frame = 0;
+    double active = 0.0;
+
+    // 按60帧每秒顺序回放
+    const double step = osg::maximum(rate, 1.0) / 60.0;
+    for (double t = plan.getBegin(); t < plan.getEnd(); t += step, frame++) {
+        osg::Timer_t t0 = timer->tick();
+        player->setTime(t);
+        player->update();
+        osg::Timer_t t1 = timer->tick();
+        layer->update(frame / 60.0);
+        osg::Timer_t t2 = timer->tick();
+        playerMs.push_back(timer->delta_m(t0, t1));
+        layerMs.push_back(timer->delta_m(t1, t2));
+        active += player->_previous.size();
+    }
+    log << LC << plan.getSymbols().size() << " symbols over " << formatTime(plan.getEnd() - plan.getBegin())
+        << ", playback at " << formatRate(rate) << ": " << playerMs.size() << " frames, "
+        << std::fixed << std::setprecision(0) << active / playerMs.size() << " symbols active on average" << std::endl;
+    printStats(log, "playback", playerMs);
+    printStats(log, "playback layer", layerMs);
+
+    // 随机跳转，每次大部分活动符号都要进出
+    playerMs.clear();
+    layerMs.clear();
+    unsigned int state = 7;
+    for (unsigned int i = 0; i < jumps; i++, frame++) {
+        double t = plan.getBegin() + nextRandom(state) * (plan.getEnd() - plan.getBegin());
+        osg::Timer_t t0 = timer->tick();
+        player->setTime(t);
+        player->update();
+        osg::Timer_t t1 = timer->tick();
+        layer->update(frame / 60.0);
+        osg::Timer_t t2 = timer->tick();
+        playerMs.push_back(timer->delta_m(t0, t1));
+        layerMs.push_back(timer->delta_m(t1, t2));
+    }
+    log << LC << jumps << " random jumps" << std::endl;
+    printStats(log, "scrub", playerMs);
+    printStats(log, "scrub layer", layerMs);
+    player->dump(log);
+    return true;
+}
@@ -0,0 +1,161 @@
+#ifndef TEMPORALSYMBOLS_H
+#define TEMPORALSYMBOLS_H 1
+
+#include <osgGA/GUIEventHandler>
+#include <stdint.h>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "DrawTool.h"
+#include "TrackSymbols.h"
+
+/**
+ * 带时间窗口和关键帧的符号
+ * 只在[begin, end)内显示；控制点在相邻关键帧之间线性插值，第一个关键帧之前和最后一个之后保持不变
+ */
+struct TemporalSymbol {
+    struct Keyframe {
+        double time; // 秒，从计划开始计
+        std::vector<osg::Vec2> controlPoints;
+    };
+
+    uint64_t id;
+    int type; // 符号类型，见SymbolTypeRegistry
+    double begin;
+    double end;
+    osg::Vec4 color;
+    std::vector<Keyframe> keyframes; // 按时间升序，各关键帧的控制点数相同
+};
+
+/**
+ * 时间区间索引
+ * 区间按起点排序存放，在数组上隐式地组织成平衡二叉树：下标i的层数为其末尾连续1的个数，
+ * 每个节点记录子树中最大的终点。查询时跳过最大终点不超过t的子树和起点大于t的部分，
+ * 复杂度O(log n + k)，除终点外每个区间只多一个double。
+ */
+class TimeIntervalIndex {
+public:
+    TimeIntervalIndex() : _maxLevel(-1) {}
+
+    // begins必须升序
+    void build(const std::vector<double>& begins, const std::vector<double>& ends);
+
+    // 把包含t（begin <= t < end）的区间下标按升序写入result
+    void query(double t, std::vector<unsigned int>& result) const;
+
+    unsigned int size() const { return _begins.size(); }
+
+private:
+    std::vector<double> _begins;
+    std::vector<double> _ends;
+    std::vector<double> _maxEnds; // 以该下标为根的子树中最大的终点
+    int _maxLevel;
+};
+
+/**
+ * 行动计划，一组TemporalSymbol和它们的时间区间索引
+ */
+class TemporalPlan {
+public:
+    TemporalPlan();
+
+    /**
+     * 读写文本格式的计划，每行一条记录，#开头为注释：
+     *   symbol id type begin end r g b a
+     *   key time x1 y1 ... xn yn        （属于前面最近的symbol）
+     */
+    bool read(const std::string& fileName, std::ostream& log);
+    bool write(const std::string& fileName) const;
+
+    /**
+     * 随机生成计划，用于测量
+     * 时间窗口10分钟到4小时，落在[0, duration)内，每个符号2到4个关键帧，部分区段停留不动
+     */
+    void generate(unsigned int symbols, double duration = 86400.0);
+
+    void addSymbol(const TemporalSymbol& symbol);
+    // 按开始时间排序并建立索引，添加符号后需要调用；没有关键帧的符号被丢弃
+    void finalize();
+
+    const std::vector<TemporalSymbol>& getSymbols() const { return _symbols; }
+    const TimeIntervalIndex& getIndex() const { return _index; }
+    double getBegin() const { return _begin; }
+    double getEnd() const { return _end; }
+
+private:
+    std::vector<TemporalSymbol> _symbols;
+    TimeIntervalIndex _index;
+    double _begin;
+    double _end;
+};
+
+/**
+ * 计划回放
+ * 每帧按回放时刻查询索引，与上一次的活动集合比较：进入时间窗口的符号加入TrackSymbolLayer，
+ * 离开的移除；仍在窗口内的符号只有处于两个不同的关键帧之间，或换了关键帧区段时才插值，
+ * 停在关键帧上的符号没有开销。外形的生成和顶点更新由TrackSymbolLayer在更新遍历中并行完成。
+ *
+ * 快捷键：p播放/暂停，[ ]速度减半/加倍，, .后退/前进5分钟
+ */
+class TemporalPlayer : public osgGA::GUIEventHandler {
+public:
+    // plan在回放期间需要保持有效
+    TemporalPlayer(const TemporalPlan* plan, TrackSymbolLayer* layer);
+
+    virtual bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
+
+    // 回放时刻（秒），限制在计划的时间范围内
+    void setTime(double time);
+    double getTime() const { return _time; }
+
+    // 每秒实际时间对应的计划时间（秒），默认60
+    void setRate(double rate) { _rate = rate; }
+    double getRate() const { return _rate; }
+
+    void setPlaying(bool on) { _playing = on; }
+    bool getPlaying() const { return _playing; }
+
+    // 按当前回放时刻更新活动符号，时刻未变时直接返回
+    void update();
+
+    // 打印活动符号数和每次更新的耗时
+    void dump(std::ostream& out) const;
+
+    /**
+     * 无渲染的测量：先按rate顺序回放整个计划，再随机跳转jumps次，
+     * 分别报告回放（查询、比较、插值）和TrackSymbolLayer更新（外形生成、顶点更新）的耗时
+     */
+    static bool bench(const TemporalPlan& plan, const osg::EllipsoidModel* ellipsoid, std::ostream& log,
+        double rate = 600.0, unsigned int jumps = 1000);
+
+private:
+    // 关键帧区段：时刻t之前（含t）的关键帧个数，hint为上一次的结果
+    static unsigned int findSegment(const TemporalSymbol& symbol, double t, unsigned int hint);
+    // 区段是否在两个不同的关键帧之间
+    static bool isMoving(const TemporalSymbol& symbol, unsigned int segment);
+    static void interpolate(const TemporalSymbol& symbol, unsigned int segment, double t, std::vector<osg::Vec2>& points);
+
+    const TemporalPlan* _plan;
+    osg::ref_ptr<TrackSymbolLayer> _layer;
+    double _time;
+    double _rate;
+    bool _playing;
+    double _lastFrameTime; // 上一帧的参考时刻，用于推进回放时钟
+    double _updatedTime; // 上一次update的回放时刻，<0表示尚未更新
+
+    std::vector<unsigned int> _active; // 活动符号在计划中的下标，升序
+    std::vector<unsigned int> _previous;
+    std::vector<unsigned int> _segments; // 每个符号最近一次应用的关键帧区段
+    std::vector<osg::Vec2> _points;
+
+    // 统计
+    unsigned int _updates;
+    unsigned int _entered;
+    unsigned int _left;
+    unsigned int _interpolated;
+    double _totalMs;
+    double _maxMs;
+};
+
+#endif
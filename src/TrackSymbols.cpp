@@ -0,0 +1,598 @@
+#include "TrackSymbols.h"
+#include "PlottingWrap.h"
+#include "SymbolTypeRegistry.h"
+#include <osg/LineWidth>
+#include <osg/Timer>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+// 符号偏离原点超过该距离（米）后换原点，float在该范围内的精度约为1厘米
+const double RECENTER_DISTANCE = 100000.0;
+// 工作线程每次领取的符号数
+const unsigned int CHUNK_SIZE = 16;
+
+double percentile(std::vector<double>& values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    unsigned int n = osg::minimum((unsigned int)(p * values.size()), (unsigned int)values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+void printStats(std::ostream& out, const char* name, std::vector<double>& values)
+{
+    double total = 0.0, max = 0.0;
+    for (unsigned int i = 0; i < values.size(); i++) {
+        total += values[i];
+        max = osg::maximum(max, values[i]);
+    }
+    out << "[TrackSymbols]   " << std::left << std::setw(10) << name << std::right
+        << " mean " << std::setw(8) << (values.empty() ? 0.0 : total / values.size())
+        << "  p50 " << std::setw(8) << percentile(values, 0.5)
+        << "  p99 " << std::setw(8) << percentile(values, 0.99)
+        << "  max " << std::setw(8) << max << std::endl;
+}
+}
+
+/**
+ * 固定线程数的并行循环，每帧复用，不反复创建线程
+ * 调用线程也参与计算，全部完成后run才返回
+ */
+class TrackSymbolLayer::WorkerPool {
+public:
+    explicit WorkerPool(unsigned int numThreads)
+        : _generation(0)
+        , _quit(false)
+        , _func(NULL)
+        , _count(0)
+        , _busy(0)
+        , _next(0)
+    {
+        for (unsigned int i = 1; i < numThreads; i++)
+            _threads.push_back(std::thread(&WorkerPool::work, this));
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+        }
+        _start.notify_all();
+        for (unsigned int i = 0; i < _threads.size(); i++)
+            _threads[i].join();
+    }
+
+    // 对[0, count)中的每个i执行func(i)
+    void run(unsigned int count, const std::function<void(unsigned int)>& func)
+    {
+        if (_threads.empty() || count <= CHUNK_SIZE) {
+            for (unsigned int i = 0; i < count; i++)
+                func(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _func = &func;
+            _count = count;
+            _next = 0;
+            _busy = _threads.size();
+            _generation++;
+        }
+        _start.notify_all();
+        runChunks(func, count);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _busy == 0; });
+        _func = NULL;
+    }
+
+private:
+    void work()
+    {
+        unsigned int generation = 0;
+        for (;;) {
+            const std::function<void(unsigned int)>* func;
+            unsigned int count;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _start.wait(lock, [&]() { return _quit || _generation != generation; });
+                if (_quit)
+                    return;
+                generation = _generation;
+                func = _func;
+                count = _count;
+            }
+            runChunks(*func, count);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _busy--;
+            }
+            _done.notify_one();
+        }
+    }
+
+    void runChunks(const std::function<void(unsigned int)>& func, unsigned int count)
+    {
+        for (;;) {
+            unsigned int first = _next.fetch_add(CHUNK_SIZE);
+            if (first >= count)
+                return;
+            unsigned int last = osg::minimum(first + CHUNK_SIZE, count);
+            for (unsigned int i = first; i < last; i++)
+                func(i);
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    unsigned int _generation;
+    bool _quit;
+    const std::function<void(unsigned int)>* _func;
+    unsigned int _count;
+    unsigned int _busy; // 尚未完成本轮的工作线程数
+    std::atomic<unsigned int> _next;
+};
+
+class TrackSymbolLayer::UpdateCallback : public osg::NodeCallback {
+public:
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        const osg::FrameStamp* fs = nv->getFrameStamp();
+        static_cast<TrackSymbolLayer*>(node)->update(fs ? fs->getReferenceTime() : osg::Timer::instance()->time_s());
+        traverse(node, nv);
+    }
+};
+
+TrackSymbolLayer::TrackSymbolLayer(const osg::EllipsoidModel* ellipsoid, unsigned int numThreads)
+    : _ellipsoid(ellipsoid)
+    , _altitude(50.0)
+    , _geodesic(ellipsoid->getRadiusEquator(), 1.0 - ellipsoid->getRadiusPolar() / ellipsoid->getRadiusEquator())
+    , _geodesicSegment(0.0)
+    , _pool(new WorkerPool(numThreads ? numThreads : osg::maximum(std::thread::hardware_concurrency(), 1u)))
+    , _nextSample(0)
+    , _lastTime(-1.0)
+{
+    osg::StateSet* stateSet = getOrCreateStateSet();
+    stateSet->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    stateSet->setAttributeAndModes(new osg::LineWidth(2.0f));
+    setUpdateCallback(new UpdateCallback);
+    _symbols.reserve(16384);
+}
+
+TrackSymbolLayer::~TrackSymbolLayer()
+{
+}
+
+void TrackSymbolLayer::setControlPoints(uint64_t id, const std::vector<osg::Vec2>& controlPoints)
+{
+    Command command;
+    command.op = Command::SET;
+    command.id = id;
+    command.type = DrawTool::DRAW_LINE;
+    command.controlPoints = controlPoints;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingCommands.push_back(command);
+}
+
+void TrackSymbolLayer::addSymbol(uint64_t id, int type, const std::vector<osg::Vec2>& controlPoints, const osg::Vec4& color)
+{
+    Command command;
+    command.op = Command::ADD;
+    command.id = id;
+    command.type = type;
+    command.controlPoints = controlPoints;
+    command.color = color;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingCommands.push_back(command);
+}
+
+void TrackSymbolLayer::removeSymbol(uint64_t id)
+{
+    Command command;
+    command.op = Command::REMOVE;
+    command.id = id;
+    command.type = DrawTool::DRAW_LINE;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingCommands.push_back(command);
+}
+
+void TrackSymbolLayer::pushDeltas(const TrackDelta* deltas, unsigned int count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingDeltas.insert(_pendingDeltas.end(), deltas, deltas + count);
+}
+
+void TrackSymbolLayer::update(double time)
+{
+    osg::Timer* timer = osg::Timer::instance();
+    osg::Timer_t t0 = timer->tick();
+
+    // 交换出本帧的变化，推送方只在交换的瞬间与更新线程竞争锁
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _commands.swap(_pendingCommands);
+        _deltas.swap(_pendingDeltas);
+    }
+    for (unsigned int i = 0; i < _commands.size(); i++)
+        apply(_commands[i]);
+    _commands.clear();
+    if (!_retired.empty()) {
+        _dirty.erase(std::remove_if(_dirty.begin(), _dirty.end(), [](const Symbol* s) { return s->removed; }), _dirty.end());
+        for (unsigned int i = 0; i < _retired.size() && _free.size() < MAX_FREE_SYMBOLS; i++)
+            _free.push_back(std::move(_retired[i]));
+        _retired.clear();
+    }
+    for (unsigned int i = 0; i < _deltas.size(); i++) {
+        const TrackDelta& d = _deltas[i];
+        std::unordered_map<uint64_t, std::unique_ptr<Symbol> >::iterator it = _symbols.find(d.id);
+        if (it == _symbols.end())
+            continue;
+        Symbol* symbol = it->second.get();
+        std::vector<osg::Vec2>& points = symbol->controlPoints;
+        if (d.index == TrackDelta::ALL_POINTS) {
+            for (unsigned int k = 0; k < points.size(); k++)
+                points[k] += d.delta;
+        } else if (d.index < points.size()) {
+            points[d.index] += d.delta;
+        } else {
+            continue;
+        }
+        markDirty(symbol);
+    }
+    _deltas.clear();
+    osg::Timer_t t1 = timer->tick();
+
+    _pool->run(_dirty.size(), [this](unsigned int i) { compute(*_dirty[i]); });
+    osg::Timer_t t2 = timer->tick();
+
+    for (unsigned int i = 0; i < _dirty.size(); i++)
+        patch(*_dirty[i]);
+    osg::Timer_t t3 = timer->tick();
+
+    FrameSample sample;
+    sample.interval = _lastTime < 0.0 ? 0.0 : (time - _lastTime) * 1000.0;
+    sample.apply = timer->delta_m(t0, t1);
+    sample.compute = timer->delta_m(t1, t2);
+    sample.patch = timer->delta_m(t2, t3);
+    sample.recomputed = _dirty.size();
+    if (_lastTime >= 0.0) {
+        if (_samples.size() < MAX_SAMPLES)
+            _samples.push_back(sample);
+        else
+            _samples[_nextSample++ % MAX_SAMPLES] = sample;
+    }
+    _lastTime = time;
+    _dirty.clear();
+}
+
+void TrackSymbolLayer::apply(Command& command)
+{
+    std::unordered_map<uint64_t, std::unique_ptr<Symbol> >::iterator it = _symbols.find(command.id);
+    if (command.op == Command::SET) {
+        if (it != _symbols.end()) {
+            it->second->controlPoints.swap(command.controlPoints);
+            markDirty(it->second.get());
+        }
+        return;
+    }
+    if (it != _symbols.end()) {
+        detach(std::move(it->second));
+        _symbols.erase(it);
+    }
+    if (command.op == Command::REMOVE)
+        return;
+
+    // 优先复用移除的符号，节点和顶点数组的容量都保留
+    std::unique_ptr<Symbol> symbol;
+    if (!_free.empty()) {
+        symbol = std::move(_free.back());
+        _free.pop_back();
+        osg::Vec4Array* colors = static_cast<osg::Vec4Array*>(symbol->geometry->getColorArray());
+        (*colors)[0] = command.color;
+        colors->dirty();
+    } else {
+        symbol.reset(new Symbol);
+        symbol->vertices = new osg::Vec3Array;
+        symbol->vertices->setDataVariance(osg::Object::DYNAMIC);
+        osg::Vec4Array* colors = new osg::Vec4Array;
+        colors->push_back(command.color);
+        symbol->geometry = new osg::Geometry;
+        symbol->geometry->setDataVariance(osg::Object::DYNAMIC);
+        symbol->geometry->setUseDisplayList(false);
+        symbol->geometry->setUseVertexBufferObjects(true);
+        symbol->geometry->setVertexArray(symbol->vertices.get());
+        symbol->geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+        symbol->transform = new osg::MatrixTransform;
+        symbol->transform->addChild(symbol->geometry.get());
+    }
+    symbol->id = command.id;
+    symbol->symbolType = SymbolTypeRegistry::instance()->getType(command.type);
+    if (symbol->symbolType && !symbol->symbolType->outline)
+        symbol->symbolType = NULL;
+    symbol->controlPoints.swap(command.controlPoints);
+    symbol->closed = false;
+    symbol->recenter = false;
+    symbol->dirty = false;
+    symbol->removed = false;
+
+    // 原点取第一个控制点，compute中不必立即换原点
+    symbol->origin = osg::Vec3d();
+    if (!symbol->controlPoints.empty()) {
+        const osg::Vec2& p = symbol->controlPoints[0];
+        _ellipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians((double)p.y()), osg::DegreesToRadians((double)p.x()), _altitude,
+            symbol->origin.x(), symbol->origin.y(), symbol->origin.z());
+    }
+    symbol->transform->setMatrix(osg::Matrixd::translate(symbol->origin));
+    symbol->childIndex = _children.size();
+    _children.push_back(symbol.get());
+    addChild(symbol->transform.get());
+
+    Symbol* s = symbol.get();
+    _symbols[command.id] = std::move(symbol);
+    markDirty(s);
+}
+
+void TrackSymbolLayer::detach(std::unique_ptr<Symbol> symbol)
+{
+    // 与最后一个子节点交换后移除，大量符号同时移除时不必逐个查找
+    const unsigned int last = _children.size() - 1;
+    if (symbol->childIndex != last) {
+        Symbol* moved = _children[last];
+        moved->childIndex = symbol->childIndex;
+        _children[moved->childIndex] = moved;
+        setChild(moved->childIndex, moved->transform.get());
+    }
+    _children.pop_back();
+    removeChildren(last, 1);
+    symbol->removed = true;
+    _retired.push_back(std::move(symbol));
+}
+
+void TrackSymbolLayer::markDirty(Symbol* symbol)
+{
+    if (symbol->dirty)
+        return;
+    symbol->dirty = true;
+    _dirty.push_back(symbol);
+}
+
+void TrackSymbolLayer::compute(Symbol& symbol) const
+{
+    const std::vector<osg::Vec2>& controlPoints = symbol.controlPoints;
+    Math::MultiLineString outline;
+    if (symbol.symbolType) {
+        if (controlPoints.size() >= symbol.symbolType->minControlPoints)
+            outline = Math::generateOutline(symbol.symbolType->outline, controlPoints, false, &_geodesic, _geodesicSegment);
+    } else if (!controlPoints.empty()) {
+        outline.push_back(controlPoints);
+    }
+
+    symbol.parts.resize(outline.size());
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < outline.size(); i++) {
+        symbol.parts[i] = outline[i].size();
+        total += outline[i].size();
+    }
+    // 有外形函数的单环外形是多边形的边界
+    symbol.closed = symbol.symbolType && outline.size() == 1;
+
+    // 原位覆盖顶点，点数不变时不分配内存
+    osg::Vec3Array& vertices = *symbol.vertices;
+    vertices.resize(total);
+    unsigned int k = 0;
+    for (unsigned int i = 0; i < outline.size(); i++) {
+        const Math::LineString& line = outline[i];
+        for (unsigned int j = 0; j < line.size(); j++) {
+            osg::Vec3d p;
+            _ellipsoid->convertLatLongHeightToXYZ(osg::DegreesToRadians((double)line[j].y()), osg::DegreesToRadians((double)line[j].x()), _altitude,
+                p.x(), p.y(), p.z());
+            if (k == 0 && (p - symbol.origin).length2() > RECENTER_DISTANCE * RECENTER_DISTANCE) {
+                symbol.origin = p;
+                symbol.recenter = true;
+            }
+            vertices[k++] = p - symbol.origin;
+        }
+    }
+}
+
+void TrackSymbolLayer::patch(Symbol& symbol)
+{
+    symbol.dirty = false;
+    if (symbol.recenter) {
+        symbol.transform->setMatrix(osg::Matrixd::translate(symbol.origin));
+        symbol.recenter = false;
+    }
+
+    // 每条折线一个DrawArrays，只在折线数变化时增删
+    osg::Geometry* geometry = symbol.geometry.get();
+    const GLenum mode = symbol.closed ? GL_LINE_LOOP : GL_LINE_STRIP;
+    while (geometry->getNumPrimitiveSets() > symbol.parts.size())
+        geometry->removePrimitiveSet(geometry->getNumPrimitiveSets() - 1);
+    while (geometry->getNumPrimitiveSets() < symbol.parts.size())
+        geometry->addPrimitiveSet(new osg::DrawArrays(mode));
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < symbol.parts.size(); i++) {
+        static_cast<osg::DrawArrays*>(geometry->getPrimitiveSet(i))->set(mode, first, symbol.parts[i]);
+        first += symbol.parts[i];
+    }
+
+    symbol.vertices->dirty();
+    geometry->dirtyBound();
+}
+
+void TrackSymbolLayer::dump(std::ostream& out) const
+{
+    std::vector<double> interval, apply, compute, patch, total;
+    unsigned int recomputed = 0, maxRecomputed = 0;
+    for (unsigned int i = 0; i < _samples.size(); i++) {
+        const FrameSample& s = _samples[i];
+        interval.push_back(s.interval);
+        apply.push_back(s.apply);
+        compute.push_back(s.compute);
+        patch.push_back(s.patch);
+        total.push_back(s.apply + s.compute + s.patch);
+        recomputed += s.recomputed;
+        maxRecomputed = osg::maximum(maxRecomputed, s.recomputed);
+    }
+
+    out << "[TrackSymbols] " << _symbols.size() << " symbols, " << _samples.size() << " frames, "
+        << (_samples.empty() ? 0 : recomputed / _samples.size()) << " symbols recomputed per frame (max "
+        << maxRecomputed << ")" << std::endl;
+    if (_samples.empty())
+        return;
+    out << std::fixed << std::setprecision(3);
+    printStats(out, "frame", interval);
+    printStats(out, "update", total);
+    printStats(out, "apply", apply);
+    printStats(out, "compute", compute);
+    printStats(out, "patch", patch);
+    out << "[TrackSymbols] times in ms; frame is the interval between update traversals" << std::endl;
+}
+
+void TrackSymbolLayer::resetStats()
+{
+    _samples.clear();
+    _nextSample = 0;
+    _lastTime = -1.0;
+}
+
+TrackSimulator::TrackSimulator(TrackSymbolLayer* layer, unsigned int symbols, double rate)
+    : _layer(layer)
+    , _numSymbols(symbols)
+    , _rate(osg::maximum(rate, 0.1))
+    , _running(false)
+    , _ticks(0)
+    , _deltas(0)
+    , _startTime(0.0)
+{
+}
+
+TrackSimulator::~TrackSimulator()
+{
+    stop();
+}
+
+void TrackSimulator::start(const osg::Vec2& center, float radius)
+{
+    stop();
+
+    // 箭头挂在目标上指向运动方向，搜寻区跟随目标平移
+    const DrawTool::DrawType types[] = {
+        DrawTool::DRAW_STRAIGHTARROW,
+        DrawTool::DRAW_DIAGONALARROW,
+        DrawTool::DRAW_DOUBLEARROW,
+        DrawTool::DRAW_PARALLELSEARCH,
+        DrawTool::DRAW_SECTORSEARCH,
+    };
+    const unsigned int numTypes = sizeof(types) / sizeof(types[0]);
+    const osg::Vec4 colors[] = {
+        osg::Vec4(1.0f, 0.2f, 0.2f, 1.0f),
+        osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f),
+        osg::Vec4(0.2f, 0.6f, 1.0f, 1.0f),
+    };
+
+    _units.clear();
+    unsigned int state = 1;
+    for (unsigned int i = 0; i < _numSymbols; i++) {
+        const DrawTool::DrawType type = types[i % numTypes];
+        const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(type);
+        if (!symbolType)
+            continue;
+
+        state = state * 1664525u + 1013904223u;
+        float x = (state >> 8) / 16777216.0f * 2.0f - 1.0f;
+        state = state * 1664525u + 1013904223u;
+        float y = (state >> 8) / 16777216.0f * 2.0f - 1.0f;
+        state = state * 1664525u + 1013904223u;
+        float heading = (state >> 8) / 16777216.0f * 2.0f * osg::PI;
+        // 约100到300节
+        state = state * 1664525u + 1013904223u;
+        float speed = (0.0005f + 0.001f * (state >> 8) / 16777216.0f);
+
+        Unit unit;
+        unit.id = i + 1;
+        unit.velocity.set(speed * cosf(heading), speed * sinf(heading));
+        unit.phase = heading;
+        unit.swingIndex = TrackDelta::ALL_POINTS;
+
+        // 控制点沿运动方向排列，间隔0.05度，偶数点向一侧偏开
+        const unsigned int numPoints = osg::maximum(symbolType->minControlPoints, 2u);
+        osg::Vec2 position(center.x() + x * radius, center.y() + y * radius * 0.5f);
+        osg::Vec2 forward(cosf(heading), sinf(heading));
+        osg::Vec2 side(-forward.y(), forward.x());
+        std::vector<osg::Vec2> controlPoints(numPoints);
+        for (unsigned int k = 0; k < numPoints; k++)
+            controlPoints[k] = position + forward * (0.05f * k) + side * (0.02f * (k % 2));
+        if (type == DrawTool::DRAW_STRAIGHTARROW || type == DrawTool::DRAW_DIAGONALARROW)
+            unit.swingIndex = numPoints - 1;
+
+        _layer->addSymbol(unit.id, type, controlPoints, colors[i % 3]);
+        _units.push_back(unit);
+    }
+
+    _ticks = 0;
+    _deltas = 0;
+    _startTime = osg::Timer::instance()->time_s();
+    _running = true;
+    _thread = std::thread(&TrackSimulator::run, this);
+}
+
+void TrackSimulator::stop()
+{
+    _running = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void TrackSimulator::run()
+{
+    const double period = 1.0 / _rate;
+    std::vector<TrackDelta> deltas;
+    deltas.reserve(_units.size() * 2);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    while (_running) {
+        const float t = (float)(_ticks * period);
+        deltas.clear();
+        for (unsigned int i = 0; i < _units.size(); i++) {
+            const Unit& unit = _units[i];
+            TrackDelta delta;
+            delta.id = unit.id;
+            delta.index = TrackDelta::ALL_POINTS;
+            delta.delta = unit.velocity * (float)period;
+            deltas.push_back(delta);
+            if (unit.swingIndex != TrackDelta::ALL_POINTS) {
+                // 箭头头部以2秒为周期左右摆动约0.01度
+                float w = osg::PI * (float)period;
+                delta.index = unit.swingIndex;
+                delta.delta.set(0.0f, 0.01f * w * cosf(osg::PI * t + unit.phase));
+                deltas.push_back(delta);
+            }
+        }
+        _layer->pushDeltas(deltas.data(), deltas.size());
+        _deltas += deltas.size();
+        _ticks++;
+
+        next += std::chrono::microseconds((long long)(period * 1.0e6));
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void TrackSimulator::dump(std::ostream& out) const
+{
+    double seconds = osg::Timer::instance()->time_s() - _startTime;
+    if (seconds <= 0.0)
+        return;
+    out << "[TrackSymbols] simulator " << _units.size() << " symbols, " << _ticks << " ticks ("
+        << std::fixed << std::setprecision(1) << _ticks / seconds << " Hz), "
+        << _deltas / seconds << " deltas/s" << std::endl;
+}
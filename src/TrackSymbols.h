@@ -0,0 +1,190 @@
+#ifndef TRACKSYMBOLS_H
+#define TRACKSYMBOLS_H 1
+
+#include <osg/CoordinateSystemNode>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/MatrixTransform>
+#include <stdint.h>
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DrawTool.h"
+
+struct SymbolType;
+
+// 跟随目标运动的符号的控制点增量
+struct TrackDelta {
+    enum { ALL_POINTS = 0xffffffff };
+
+    uint64_t id;
+    unsigned int index; // 控制点下标，ALL_POINTS表示全部控制点整体平移
+    osg::Vec2 delta; // 经度、纬度增量（度）
+};
+
+/**
+ * 高频更新的跟踪符号层
+ * 符号挂在运动目标上，外部按控制点增量推送变化，不经过FeatureNode::init()重建：
+ * 更新遍历中先应用本帧收到的增量，再由线程池并行重算有变化的符号外形并直接写入各自的顶点数组，
+ * 最后在更新线程中调整图元区间、标记顶点数组和包围球失效。顶点数组只在容量不够时重新分配。
+ *
+ * 顶点为相对符号原点的地心坐标，原点放在每个符号的MatrixTransform中，
+ * 符号移出原点RECENTER_DISTANCE后换原点，保证float的精度。
+ * 符号画为离椭球面固定高度的折线（单环的外形画为闭合线），不贴地形，
+ * 贴地需要重建覆盖纹理，无法做到逐顶点的原位修改。
+ * 几何的DataVariance为DYNAMIC，多线程渲染时绘制线程在更新遍历前已处理完这些几何。
+ */
+class TrackSymbolLayer : public osg::Group {
+public:
+    /**
+     * @param ellipsoid 地图的椭球，用于经纬度转地心坐标
+     * @param numThreads 计算外形的线程数（含更新线程），为0时取硬件线程数
+     */
+    TrackSymbolLayer(const osg::EllipsoidModel* ellipsoid, unsigned int numThreads = 0);
+
+    // 以下函数可以在任意线程调用，在下一次更新时按调用顺序生效，同一帧中先处理增删和设置再应用增量
+    void addSymbol(uint64_t id, int type, const std::vector<osg::Vec2>& controlPoints, const osg::Vec4& color);
+    void removeSymbol(uint64_t id);
+    // 整体替换控制点，id不存在时忽略
+    void setControlPoints(uint64_t id, const std::vector<osg::Vec2>& controlPoints);
+    void pushDeltas(const TrackDelta* deltas, unsigned int count);
+    void pushDelta(const TrackDelta& delta) { pushDeltas(&delta, 1); }
+
+    // 离椭球面的高度（米），只影响之后重算的符号
+    void setAltitude(double altitude) { _altitude = altitude; }
+    double getAltitude() const { return _altitude; }
+
+    // 大地线模式：外形的各边加密为大地线，相邻点不超过meters米，为0时关闭；只影响之后重算的符号
+    void setGeodesicSegment(double meters) { _geodesicSegment = meters; }
+    double getGeodesicSegment() const { return _geodesicSegment; }
+
+    /**
+     * 执行一次更新，由更新遍历调用，没有视图时也可以直接调用
+     * @param time 帧时刻（秒），用于统计帧间隔
+     */
+    void update(double time);
+
+    unsigned int getNumSymbols() const { return _symbols.size(); }
+
+    // 打印帧间隔、更新各阶段耗时和每帧重算的符号数
+    void dump(std::ostream& out) const;
+    void resetStats();
+
+protected:
+    virtual ~TrackSymbolLayer();
+
+private:
+    class UpdateCallback;
+    class WorkerPool;
+
+    struct Symbol {
+        uint64_t id;
+        const SymbolType* symbolType; // 类型未注册时为NULL，外形就是控制点
+        std::vector<osg::Vec2> controlPoints;
+        osg::ref_ptr<osg::MatrixTransform> transform;
+        osg::ref_ptr<osg::Geometry> geometry;
+        osg::ref_ptr<osg::Vec3Array> vertices;
+        osg::Vec3d origin; // 地心坐标
+        std::vector<unsigned int> parts; // 每条折线的点数
+        unsigned int childIndex; // transform在本层子节点中的下标
+        bool closed;
+        bool recenter; // 原点已变化，需要更新transform
+        bool dirty; // 已在_dirty中
+        bool removed; // 本帧已移除，应用完本帧的变化后回收
+    };
+
+    struct Command {
+        enum Op { ADD, REMOVE, SET } op;
+        uint64_t id;
+        int type;
+        std::vector<osg::Vec2> controlPoints;
+        osg::Vec4 color;
+    };
+
+    // 一帧的统计，耗时单位毫秒
+    struct FrameSample {
+        double interval; // 与上一帧的间隔
+        double apply;
+        double compute;
+        double patch;
+        unsigned int recomputed;
+    };
+
+    void apply(Command& command);
+    void markDirty(Symbol* symbol);
+    // 从场景中移除符号，应用完本帧的变化后放入回收列表
+    void detach(std::unique_ptr<Symbol> symbol);
+    // 工作线程中执行：计算外形并写入顶点数组
+    void compute(Symbol& symbol) const;
+    // 更新线程中执行：更新原点、图元区间并标记失效
+    void patch(Symbol& symbol);
+
+    osg::ref_ptr<const osg::EllipsoidModel> _ellipsoid;
+    double _altitude;
+    Math::Geodesic _geodesic;
+    double _geodesicSegment;
+    std::unique_ptr<WorkerPool> _pool;
+    std::unordered_map<uint64_t, std::unique_ptr<Symbol> > _symbols;
+    std::vector<Symbol*> _dirty;
+    std::vector<Symbol*> _children; // 与子节点一一对应
+    std::vector<std::unique_ptr<Symbol> > _retired; // 本帧移除的符号
+    std::vector<std::unique_ptr<Symbol> > _free; // 可复用的符号，最多MAX_FREE_SYMBOLS个
+
+    // 其他线程推送的变化，更新时整体交换出来
+    std::mutex _mutex;
+    std::vector<Command> _pendingCommands, _commands;
+    std::vector<TrackDelta> _pendingDeltas, _deltas;
+
+    enum { MAX_SAMPLES = 65536, MAX_FREE_SYMBOLS = 16384 };
+    std::vector<FrameSample> _samples; // 超过MAX_SAMPLES后循环覆盖
+    unsigned int _nextSample;
+    double _lastTime;
+};
+
+/**
+ * 模拟运动目标，在后台线程中按固定频率向TrackSymbolLayer推送增量
+ * 目标散布在center附近，各自匀速直线运动，带动所挂符号整体平移；
+ * 箭头类符号的最后一个控制点另外做小幅摆动，模拟单个控制点的变化。
+ */
+class TrackSimulator {
+public:
+    /**
+     * @param symbols 符号数
+     * @param rate 每个符号每秒的更新次数
+     */
+    TrackSimulator(TrackSymbolLayer* layer, unsigned int symbols = 10000, double rate = 10.0);
+    ~TrackSimulator();
+
+    void start(const osg::Vec2& center = osg::Vec2(110.0f, 30.0f), float radius = 10.0f);
+    void stop();
+
+    // 打印实际的更新频率和增量数
+    void dump(std::ostream& out) const;
+
+private:
+    struct Unit {
+        uint64_t id;
+        osg::Vec2 velocity; // 度每秒
+        unsigned int swingIndex; // 摆动的控制点，ALL_POINTS表示不摆动
+        float phase;
+    };
+
+    void run();
+
+    osg::ref_ptr<TrackSymbolLayer> _layer;
+    unsigned int _numSymbols;
+    double _rate;
+    std::vector<Unit> _units;
+    std::thread _thread;
+    std::atomic<bool> _running;
+    std::atomic<uint64_t> _ticks;
+    std::atomic<uint64_t> _deltas;
+    double _startTime;
+};
+
+#endif
@@ -0,0 +1,652 @@
+#include "VectorTiler.h"
+#include "DisplayLod.h"
+#include "PlottingSimplify.h"
+#include "PlottingWrap.h"
+#include "SymbolTypeRegistry.h"
+#include <osg/NodeVisitor>
+#include <osg/Timer>
+#include <osg/Vec2d>
+#include <osg/ValueObject>
+#include <osgDB/FileUtils>
+#include <osgEarth/MapNode>
+#include <osgEarth/Notify>
+#include <osgEarthAnnotation/CircleNode>
+#include <osgEarthAnnotation/FeatureNode>
+#include <osgEarthAnnotation/RectangleNode>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+using namespace osgEarth::Symbology;
+
+#define LC "[VectorTiler] "
+
+namespace {
+
+// Web墨卡托的纬度范围
+const double MAX_LATITUDE = 85.0511287798;
+// 简化容差，单位为瓦片坐标
+const float TILE_SIMPLIFY_TOLERANCE = 1.0f;
+// 最大级别，再高时瓦片列号超出目录数组和int的范围
+const unsigned int MAX_ZOOM = 22;
+// CircleNode没有指定段数时整圆的点数
+const unsigned int CIRCLE_SEGMENTS = 90;
+
+// 经纬度到[0, 1]的墨卡托坐标，y向下
+inline void project(double lon, double lat, double& x, double& y)
+{
+    lat = osg::clampBetween(lat, -MAX_LATITUDE, MAX_LATITUDE);
+    double sinLat = sin(osg::DegreesToRadians(lat));
+    x = (lon + 180.0) / 360.0;
+    y = 0.5 - log((1.0 + sinLat) / (1.0 - sinLat)) / (4.0 * osg::PI);
+}
+
+// protobuf的编码，只用到varint和length-delimited两种类型
+class ProtobufWriter {
+public:
+    void varint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            _data.push_back((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        _data.push_back((char)value);
+    }
+    void uint(unsigned int field, uint64_t value)
+    {
+        varint(field << 3);
+        varint(value);
+    }
+    void bytes(unsigned int field, const std::string& value)
+    {
+        varint((field << 3) | 2);
+        varint(value.size());
+        _data.append(value);
+    }
+    void packed(unsigned int field, const std::vector<uint32_t>& values)
+    {
+        ProtobufWriter writer;
+        for (unsigned int i = 0; i < values.size(); i++)
+            writer.varint(values[i]);
+        bytes(field, writer.data());
+    }
+    const std::string& data() const { return _data; }
+
+private:
+    std::string _data;
+};
+
+// MVT的几何指令
+enum Command { MOVE_TO = 1, LINE_TO = 2, CLOSE_PATH = 7 };
+
+inline uint32_t command(Command id, unsigned int count)
+{
+    return (id & 0x7) | (count << 3);
+}
+
+// 左移负数是未定义行为，按无符号数移位
+inline uint32_t zigzag(int value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline uint64_t tileKey(int x, int y)
+{
+    return ((uint64_t)x << 32) | (uint32_t)y;
+}
+
+/**
+ * 线段ab经过的瓦片，坐标单位为瓦片，瓦片四周扩展margin
+ * 逐列求线段在该列（含扩展）内的纵向范围，只枚举真正经过的瓦片
+ */
+void segmentTiles(double ax, double ay, double bx, double by, double margin, int n, std::vector<uint64_t>& keys)
+{
+    if (ax > bx) {
+        std::swap(ax, bx);
+        std::swap(ay, by);
+    }
+    const int tx0 = osg::clampBetween((int)floor(ax - margin), 0, n - 1);
+    const int tx1 = osg::clampBetween((int)floor(bx + margin), 0, n - 1);
+    for (int tx = tx0; tx <= tx1; tx++) {
+        double y0 = ay, y1 = by;
+        if (bx > ax) {
+            double t0 = osg::clampBetween((tx - margin - ax) / (bx - ax), 0.0, 1.0);
+            double t1 = osg::clampBetween((tx + 1 + margin - ax) / (bx - ax), 0.0, 1.0);
+            y0 = ay + t0 * (by - ay);
+            y1 = ay + t1 * (by - ay);
+        }
+        if (y0 > y1)
+            std::swap(y0, y1);
+        const int ty0 = osg::clampBetween((int)floor(y0 - margin), 0, n - 1);
+        const int ty1 = osg::clampBetween((int)floor(y1 + margin), 0, n - 1);
+        for (int ty = ty0; ty <= ty1; ty++)
+            keys.push_back(tileKey(tx, ty));
+    }
+}
+
+/**
+ * 多边形内部的瓦片：按瓦片行的中线求与各环的交点，奇偶规则配对后填充其间的瓦片
+ * 只与边界相交的瓦片由segmentTiles给出
+ */
+void interiorTiles(const std::vector<std::vector<osg::Vec2d> >& rings, int ty0, int ty1, int n, std::vector<uint64_t>& keys)
+{
+    std::vector<double> crossings;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        const double y = ty + 0.5;
+        crossings.clear();
+        for (unsigned int r = 0; r < rings.size(); r++) {
+            const std::vector<osg::Vec2d>& ring = rings[r];
+            for (unsigned int i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+                const osg::Vec2d& a = ring[j];
+                const osg::Vec2d& b = ring[i];
+                if ((a.y() > y) != (b.y() > y))
+                    crossings.push_back(a.x() + (y - a.y()) / (b.y() - a.y()) * (b.x() - a.x()));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (unsigned int k = 0; k + 1 < crossings.size(); k += 2) {
+            const int tx0 = osg::clampBetween((int)floor(crossings[k]), 0, n - 1);
+            const int tx1 = osg::clampBetween((int)floor(crossings[k + 1]), 0, n - 1);
+            for (int tx = tx0; tx <= tx1; tx++)
+                keys.push_back(tileKey(tx, ty));
+        }
+    }
+}
+
+/**
+ * 把瓦片坐标的点串编码为几何指令，坐标取整后去掉连续重复点
+ * 多边形按MVT的约定把外环调整为正面积（瓦片坐标y向下时为顺时针）
+ * @param cursor 上一个点，指令中的坐标是相对它的增量
+ * @return 点数不足或面积为0时不编码，返回false
+ */
+bool encodePath(const Math::LineString& points, bool polygon, int cursor[2], std::vector<uint32_t>& geometry)
+{
+    std::vector<int> xy;
+    xy.reserve(points.size() * 2);
+    for (unsigned int i = 0; i < points.size(); i++) {
+        int x = (int)floor(points[i].x() + 0.5f);
+        int y = (int)floor(points[i].y() + 0.5f);
+        if (!xy.empty() && xy[xy.size()-2] == x && xy[xy.size()-1] == y)
+            continue;
+        xy.push_back(x);
+        xy.push_back(y);
+    }
+    unsigned int n = xy.size() / 2;
+    if (polygon && n > 1 && xy[0] == xy[2*n-2] && xy[1] == xy[2*n-1])
+        n--;
+    if (n < (polygon ? 3u : 2u))
+        return false;
+
+    bool reverse = false;
+    if (polygon) {
+        int64_t area = 0;
+        for (unsigned int i = 0, j = n - 1; i < n; j = i++)
+            area += (int64_t)xy[2*j] * xy[2*i+1] - (int64_t)xy[2*i] * xy[2*j+1];
+        if (area == 0)
+            return false;
+        reverse = area < 0;
+    }
+
+    for (unsigned int k = 0; k < n; k++) {
+        unsigned int i = reverse ? n - 1 - k : k;
+        if (k == 0)
+            geometry.push_back(command(MOVE_TO, 1));
+        else if (k == 1)
+            geometry.push_back(command(LINE_TO, n - 1));
+        geometry.push_back(zigzag(xy[2*i] - cursor[0]));
+        geometry.push_back(zigzag(xy[2*i+1] - cursor[1]));
+        cursor[0] = xy[2*i];
+        cursor[1] = xy[2*i+1];
+    }
+    if (polygon)
+        geometry.push_back(command(CLOSE_PATH, 1));
+    return true;
+}
+
+// 收集场景中的要素节点
+// 落图的符号节点：绘制工具和推送通道提交节点时都记录了drawType
+class SymbolNodeCollector : public osg::NodeVisitor {
+public:
+    SymbolNodeCollector() : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::Node& node)
+    {
+        int drawType = -1;
+        if (node.getUserValue("drawType", drawType)) {
+            nodes.push_back(&node);
+            return;
+        }
+        traverse(node);
+    }
+
+    std::vector<osg::Node*> nodes;
+};
+
+osgEarth::GeoPoint toGeographic(const osgEarth::GeoPoint& point)
+{
+    osgEarth::GeoPoint geo;
+    if (!point.isValid() || !point.transform(point.getSRS()->getGeographicSRS(), geo))
+        return osgEarth::GeoPoint();
+    return geo;
+}
+
+// FeatureNode的各部分，显示用的几何按视图距离简化过，取完整精度的外形
+void collectFeature(osgEarth::Annotation::FeatureNode* node, Math::MultiLineString& polygons, Math::MultiLineString& lines)
+{
+    if (!node->getFeature() || !node->getFeature()->getGeometry())
+        return;
+    osg::ref_ptr<Geometry> geometry = node->getFeature()->getGeometry();
+    DisplayLodCallback* lod = DisplayLodCallback::get(node);
+    Geometry* full = lod ? lod->createFullGeometry(geometry.get()) : NULL;
+    if (full)
+        geometry = full;
+
+    GeometryIterator it(geometry.get(), false);
+    while (it.hasMore()) {
+        Geometry* part = it.next();
+        Math::LineString points(part->size());
+        for (unsigned int k = 0; k < part->size(); k++)
+            points[k].set((*part)[k].x(), (*part)[k].y());
+        if (part->getType() == Geometry::TYPE_POLYGON) {
+            polygons.push_back(points);
+        } else {
+            if (part->getType() == Geometry::TYPE_RING && !points.empty())
+                points.push_back(points.front());
+            lines.push_back(points);
+        }
+    }
+}
+
+/**
+ * CircleNode的外形：从圆心沿各方位角按大地线正解取点
+ * 整圆和扇形（pie）为多边形，不闭合的圆弧为折线。CircleNode的角度从东向逆时针量，换算为从北顺时针的方位角
+ */
+void collectCircle(const Math::Geodesic& geodesic, const osgEarth::Annotation::CircleNode* circle,
+                   Math::MultiLineString& polygons, Math::MultiLineString& lines)
+{
+    const osgEarth::GeoPoint center = toGeographic(circle->getPosition());
+    const double radius = circle->getRadius().as(osgEarth::Units::METERS);
+    if (!center.isValid() || radius <= 0.0)
+        return;
+    const double start = circle->getArcStart().as(osgEarth::Units::DEGREES);
+    const double span = osg::clampBetween(circle->getArcEnd().as(osgEarth::Units::DEGREES) - start, 0.0, 360.0);
+    const bool full = span >= 360.0;
+    const unsigned int segments = circle->getNumSegments() > 0 ? circle->getNumSegments() : CIRCLE_SEGMENTS;
+    const unsigned int count = osg::maximum((unsigned int)ceil(segments * span / 360.0), 2u);
+
+    Math::LineString points;
+    for (unsigned int k = 0; k < (full ? count : count + 1); k++) {
+        double lon, lat;
+        if (geodesic.direct(center.x(), center.y(), 90.0 - (start + span * k / count), radius, lon, lat))
+            points.push_back(osg::Vec2(lon, lat));
+    }
+    if (full) {
+        polygons.push_back(points);
+    } else if (circle->getPie()) {
+        points.push_back(osg::Vec2(center.x(), center.y()));
+        polygons.push_back(points);
+    } else {
+        lines.push_back(points);
+    }
+}
+
+// RectangleNode的外形：四个角点
+void collectRectangle(const osgEarth::Annotation::RectangleNode* rectangle, Math::MultiLineString& polygons)
+{
+    typedef osgEarth::Annotation::RectangleNode RectangleNode;
+    const RectangleNode::Corner corners[4] = {
+        RectangleNode::CORNER_LOWER_LEFT, RectangleNode::CORNER_LOWER_RIGHT,
+        RectangleNode::CORNER_UPPER_RIGHT, RectangleNode::CORNER_UPPER_LEFT
+    };
+    Math::LineString points;
+    for (unsigned int i = 0; i < 4; i++) {
+        const osgEarth::GeoPoint corner = toGeographic(rectangle->getCorner(corners[i]));
+        if (!corner.isValid())
+            return;
+        points.push_back(osg::Vec2(corner.x(), corner.y()));
+    }
+    polygons.push_back(points);
+}
+
+}
+
+VectorTiler::VectorTiler(unsigned int minZoom, unsigned int maxZoom, unsigned int extent, unsigned int buffer)
+    : _minZoom(osg::minimum(minZoom, MAX_ZOOM))
+    , _maxZoom(osg::minimum(osg::maximum(minZoom, maxZoom), MAX_ZOOM))
+    , _extent(extent)
+    , _buffer(buffer)
+    , _geodesicSegment(0.0)
+{
+}
+
+void VectorTiler::addNode(osg::Node* root)
+{
+    SymbolNodeCollector collector;
+    root->accept(collector);
+    for (unsigned int i = 0; i < collector.nodes.size(); i++) {
+        osg::Node* node = collector.nodes[i];
+        int drawType = -1;
+        node->getUserValue("drawType", drawType);
+        const SymbolType* symbolType = SymbolTypeRegistry::instance()->getType(drawType);
+
+        Math::MultiLineString polygons, lines;
+        if (osgEarth::Annotation::FeatureNode* featureNode = dynamic_cast<osgEarth::Annotation::FeatureNode*>(node)) {
+            collectFeature(featureNode, polygons, lines);
+        } else if (osgEarth::Annotation::CircleNode* circle = dynamic_cast<osgEarth::Annotation::CircleNode*>(node)) {
+            collectCircle(_geodesic, circle, polygons, lines);
+        } else if (osgEarth::Annotation::RectangleNode* rectangle = dynamic_cast<osgEarth::Annotation::RectangleNode*>(node)) {
+            collectRectangle(rectangle, polygons);
+        } else {
+            // 标记、标注等没有外形
+            OE_NOTICE << LC << "Not exporting " << node->className() << " (symbol type " << drawType << "): no outline" << std::endl;
+            continue;
+        }
+        if (polygons.empty() && lines.empty())
+            continue;
+        addSymbol(symbolType ? symbolType->name : "symbol", polygons, lines);
+    }
+}
+
+void VectorTiler::addSymbol(const std::string& typeName, const Math::MultiLineString& polygons, const Math::MultiLineString& lines)
+{
+    Symbol symbol;
+    symbol.typeName = std::find(_typeNames.begin(), _typeNames.end(), typeName) - _typeNames.begin();
+    if (symbol.typeName == _typeNames.size())
+        _typeNames.push_back(typeName);
+    symbol.polygons = polygons;
+    symbol.lines = lines;
+    // 加密在切分之前，跨日期变更线的边按展开的经度求大地线
+    if (_geodesicSegment > 0.0) {
+        Math::LineString densified;
+        for (unsigned int i = 0; i < symbol.polygons.size(); i++) {
+            _geodesic.densify(symbol.polygons[i], true, _geodesicSegment, densified);
+            symbol.polygons[i].swap(densified);
+        }
+        for (unsigned int i = 0; i < symbol.lines.size(); i++) {
+            _geodesic.densify(symbol.lines[i], false, _geodesicSegment, densified);
+            symbol.lines[i].swap(densified);
+        }
+    }
+    // 瓦片按[-180, 180]划分，跨日期变更线的部分切开后分别落到两侧的瓦片中
+    Math::splitAtAntimeridian(symbol.polygons, true);
+    Math::splitAtAntimeridian(symbol.lines, false);
+
+    const Math::MultiLineString* parts[2] = { &symbol.polygons, &symbol.lines };
+    for (int p = 0; p < 2; p++) {
+        for (unsigned int i = 0; i < parts[p]->size(); i++) {
+            Math::Extent extent = Math::calculateExtent((*parts[p])[i]);
+            if (!extent.valid())
+                continue;
+            if (!symbol.bounds.valid()) {
+                symbol.bounds = extent;
+            } else {
+                symbol.bounds.xMin = osg::minimum(symbol.bounds.xMin, extent.xMin);
+                symbol.bounds.yMin = osg::minimum(symbol.bounds.yMin, extent.yMin);
+                symbol.bounds.xMax = osg::maximum(symbol.bounds.xMax, extent.xMax);
+                symbol.bounds.yMax = osg::maximum(symbol.bounds.yMax, extent.yMax);
+            }
+        }
+    }
+    if (symbol.bounds.valid())
+        _symbols.push_back(symbol);
+}
+
+void VectorTiler::collectTiles(unsigned int z, std::vector<Tile>& tiles) const
+{
+    const int n = 1 << z;
+    const double margin = (double)_buffer / _extent;
+    std::map<uint64_t, unsigned int> index;
+    std::vector<uint64_t> keys;
+    std::vector<std::vector<osg::Vec2d> > rings;
+    std::vector<osg::Vec2d> points;
+    for (unsigned int s = 0; s < _symbols.size(); s++) {
+        const Symbol& symbol = _symbols[s];
+        keys.clear();
+        rings.clear();
+        int ty0 = n, ty1 = -1;
+        const Math::MultiLineString* parts[2] = { &symbol.polygons, &symbol.lines };
+        for (int p = 0; p < 2; p++) {
+            const bool polygon = p == 0;
+            for (unsigned int l = 0; l < parts[p]->size(); l++) {
+                const Math::LineString& part = (*parts[p])[l];
+                if (part.empty())
+                    continue;
+                // 瓦片坐标
+                points.resize(part.size());
+                for (unsigned int k = 0; k < part.size(); k++) {
+                    double x, y;
+                    project(part[k].x(), part[k].y(), x, y);
+                    points[k].set(x * n, y * n);
+                }
+                const unsigned int edges = polygon ? points.size() : points.size() - 1;
+                for (unsigned int k = 0; k < edges; k++) {
+                    const osg::Vec2d& a = points[k];
+                    const osg::Vec2d& b = points[(k + 1) % points.size()];
+                    segmentTiles(a.x(), a.y(), b.x(), b.y(), margin, n, keys);
+                }
+                if (edges == 0)
+                    segmentTiles(points[0].x(), points[0].y(), points[0].x(), points[0].y(), margin, n, keys);
+                if (polygon) {
+                    rings.push_back(points);
+                    for (unsigned int k = 0; k < points.size(); k++) {
+                        ty0 = osg::minimum(ty0, osg::clampBetween((int)floor(points[k].y()), 0, n - 1));
+                        ty1 = osg::maximum(ty1, osg::clampBetween((int)floor(points[k].y()), 0, n - 1));
+                    }
+                }
+            }
+        }
+        if (!rings.empty())
+            interiorTiles(rings, ty0, ty1, n, keys);
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (unsigned int k = 0; k < keys.size(); k++) {
+            std::map<uint64_t, unsigned int>::iterator it = index.find(keys[k]);
+            if (it == index.end()) {
+                it = index.insert(std::make_pair(keys[k], (unsigned int)tiles.size())).first;
+                Tile tile;
+                tile.z = z;
+                tile.x = (unsigned int)(keys[k] >> 32);
+                tile.y = (unsigned int)(keys[k] & 0xffffffffu);
+                tiles.push_back(tile);
+            }
+            tiles[it->second].symbols.push_back(s);
+        }
+    }
+}
+
+std::string VectorTiler::encodeTile(const Tile& tile) const
+{
+    const double scale = (double)(1 << tile.z) * _extent;
+    const double originX = (double)tile.x * _extent, originY = (double)tile.y * _extent;
+    const float buffer = (float)_buffer, size = (float)_extent;
+    const Math::Extent clipExtent(-buffer, -buffer, size + buffer, size + buffer);
+
+    ProtobufWriter layer;
+    layer.uint(15, 2); // version
+    layer.bytes(1, "symbols"); // name
+    std::vector<int> valueIndex(_typeNames.size(), -1);
+    std::vector<unsigned int> values;
+    unsigned int numFeatures = 0;
+
+    Math::LineString local, clipped;
+    Math::MultiLineString pieces;
+    std::vector<uint32_t> geometry;
+    for (unsigned int i = 0; i < tile.symbols.size(); i++) {
+        const Symbol& symbol = _symbols[tile.symbols[i]];
+        const Math::MultiLineString* parts[2] = { &symbol.polygons, &symbol.lines };
+        for (int p = 0; p < 2; p++) {
+            const bool polygon = p == 0;
+            int cursor[2] = { 0, 0 };
+            geometry.clear();
+            for (unsigned int l = 0; l < parts[p]->size(); l++) {
+                const Math::LineString& part = (*parts[p])[l];
+                local.resize(part.size());
+                for (unsigned int k = 0; k < part.size(); k++) {
+                    double x, y;
+                    project(part[k].x(), part[k].y(), x, y);
+                    local[k].set((float)(x * scale - originX), (float)(y * scale - originY));
+                }
+                if (polygon) {
+                    Math::clipPolygon(local, clipExtent, clipped);
+                    encodePath(Math::simplify(clipped, TILE_SIMPLIFY_TOLERANCE, true), true, cursor, geometry);
+                } else {
+                    pieces.clear();
+                    Math::clipLineString(local, clipExtent, pieces);
+                    for (unsigned int k = 0; k < pieces.size(); k++)
+                        encodePath(Math::simplify(pieces[k], TILE_SIMPLIFY_TOLERANCE), false, cursor, geometry);
+                }
+            }
+            if (geometry.empty())
+                continue;
+
+            if (valueIndex[symbol.typeName] < 0) {
+                valueIndex[symbol.typeName] = values.size();
+                values.push_back(symbol.typeName);
+            }
+            std::vector<uint32_t> tags(2);
+            tags[0] = 0; // type
+            tags[1] = valueIndex[symbol.typeName];
+
+            ProtobufWriter feature;
+            feature.uint(1, (uint64_t)tile.symbols[i] * 2 + p + 1); // id，同一符号的多边形和折线要素各有一个
+            feature.packed(2, tags);
+            feature.uint(3, polygon ? 3 : 2); // POLYGON / LINESTRING
+            feature.packed(4, geometry);
+            layer.bytes(2, feature.data());
+            numFeatures++;
+        }
+    }
+    if (numFeatures == 0)
+        return std::string();
+
+    layer.bytes(3, "type"); // keys
+    for (unsigned int i = 0; i < values.size(); i++) {
+        ProtobufWriter value;
+        value.bytes(1, _typeNames[values[i]]); // string_value
+        layer.bytes(4, value.data());
+    }
+    layer.uint(5, _extent);
+
+    ProtobufWriter tileWriter;
+    tileWriter.bytes(3, layer.data());
+    return tileWriter.data();
+}
+
+bool VectorTiler::write(const std::string& directory, std::ostream& log, unsigned int numThreads)
+{
+    if (numThreads == 0)
+        numThreads = osg::maximum(std::thread::hardware_concurrency(), 1u);
+
+    osg::Timer_t start = osg::Timer::instance()->tick();
+    unsigned int totalTiles = 0;
+    std::atomic<unsigned int> failed(0);
+    for (unsigned int z = _minZoom; z <= _maxZoom; z++) {
+        osg::Timer_t zoomStart = osg::Timer::instance()->tick();
+        std::vector<Tile> tiles;
+        collectTiles(z, tiles);
+
+        // 目录在主线程中建好，工作线程只写文件
+        std::vector<bool> columns(1u << z, false);
+        for (unsigned int i = 0; i < tiles.size(); i++) {
+            if (!columns[tiles[i].x]) {
+                columns[tiles[i].x] = true;
+                std::ostringstream path;
+                path << directory << "/" << z << "/" << tiles[i].x;
+                osgDB::makeDirectory(path.str());
+            }
+        }
+
+        std::atomic<unsigned int> next(0), written(0);
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < numThreads; t++) {
+            workers.push_back(std::thread([&]() {
+                for (unsigned int i = next++; i < tiles.size(); i = next++) {
+                    std::string data = encodeTile(tiles[i]);
+                    if (data.empty())
+                        continue;
+                    std::ostringstream path;
+                    path << directory << "/" << tiles[i].z << "/" << tiles[i].x << "/" << tiles[i].y << ".mvt";
+                    std::ofstream out(path.str().c_str(), std::ios::binary);
+                    out.write(data.data(), data.size());
+                    if (out.good())
+                        written++;
+                    else
+                        failed++;
+                }
+            }));
+        }
+        for (unsigned int t = 0; t < workers.size(); t++)
+            workers[t].join();
+
+        totalTiles += written;
+        log << "zoom " << z << ": " << written << " tiles, "
+            << osg::Timer::instance()->delta_m(zoomStart, osg::Timer::instance()->tick()) << " ms" << std::endl;
+    }
+    log << "Wrote " << totalTiles << " tiles of " << _symbols.size() << " symbols to " << directory << " in "
+        << osg::Timer::instance()->delta_m(start, osg::Timer::instance()->tick()) << " ms with "
+        << numThreads << " threads" << std::endl;
+    if (failed)
+        log << failed << " tiles could not be written" << std::endl;
+    return failed == 0;
+}
+
+bool VectorTiler::check(osgEarth::MapNode* mapNode, const std::string& directory, std::ostream& log)
+{
+    // 半径50公里的圆，第8级上只占圆心附近的几个瓦片
+    const double lon = 116.4, lat = 39.9, radius = 50000.0;
+    const unsigned int zoom = 8;
+    // 外环点是float经纬度，经度100多度时约有1米的舍入
+    const double radiusTolerance = 2.0;
+
+    osg::ref_ptr<osg::Group> root = new osg::Group;
+    osg::ref_ptr<osgEarth::Annotation::CircleNode> circle = new osgEarth::Annotation::CircleNode(
+        mapNode, osgEarth::GeoPoint(mapNode->getMapSRS()->getGeographicSRS(), lon, lat, 0.0, osgEarth::ALTMODE_ABSOLUTE),
+        osgEarth::Distance(radius, osgEarth::Units::METERS), Style());
+    circle->setUserValue("drawType", (int)DrawTool::DRAW_CIRCLE);
+    root->addChild(circle.get());
+
+    VectorTiler tiler(zoom, zoom);
+    tiler.addNode(root.get());
+    if (tiler._symbols.size() != 1 || tiler._symbols[0].polygons.size() != 1) {
+        log << LC << "FAILED: the circle was not exported as one polygon" << std::endl;
+        return false;
+    }
+    const Math::LineString& ring = tiler._symbols[0].polygons[0];
+    double maxError = 0.0;
+    for (unsigned int i = 0; i < ring.size(); i++) {
+        double distance, azimuth1, azimuth2;
+        if (!tiler._geodesic.inverse(lon, lat, ring[i].x(), ring[i].y(), distance, azimuth1, azimuth2))
+            return false;
+        maxError = osg::maximum(maxError, fabs(distance - radius));
+    }
+    log << LC << "circle ring: " << ring.size() << " points, max radius error " << maxError << " m" << std::endl;
+    if (ring.size() < 3 || maxError > radiusTolerance) {
+        log << LC << "FAILED: the circle ring does not follow the radius" << std::endl;
+        return false;
+    }
+
+    if (!tiler.write(directory, log, 1))
+        return false;
+    const unsigned int n = 1u << zoom;
+    double x, y;
+    project(lon, lat, x, y);
+    const unsigned int tx = (unsigned int)(x * n), ty = (unsigned int)(y * n);
+    std::ostringstream centerTile, farTile;
+    centerTile << directory << "/" << zoom << "/" << tx << "/" << ty << ".mvt";
+    farTile << directory << "/" << zoom << "/" << (tx + n / 2) % n << "/" << ty << ".mvt";
+    if (!osgDB::fileExists(centerTile.str())) {
+        log << LC << "FAILED: " << centerTile.str() << " was not written" << std::endl;
+        return false;
+    }
+    if (osgDB::fileExists(farTile.str())) {
+        log << LC << "FAILED: " << farTile.str() << " should be empty" << std::endl;
+        return false;
+    }
+    log << LC << "OK" << std::endl;
+    return true;
+}
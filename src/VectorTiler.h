@@ -0,0 +1,87 @@
+#ifndef VECTORTILER_H
+#define VECTORTILER_H 1
+
+#include <osg/Node>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "PlottingClip.h"
+#include "PlottingGeodesic.h"
+
+namespace osgEarth {
+class MapNode;
+}
+
+/**
+ * 把绘制的符号切成Mapbox矢量瓦片（MVT 2.1）
+ * 先从场景中取出全部要素的外形，之后的切片只读这份数据，按Web墨卡托的z/x/y金字塔分给多个线程并行：
+ * 每个瓦片内把外形投影到瓦片坐标，按缓冲区裁剪，再以一个瓦片单位为容差简化，
+ * 所以简化程度随级别自动变化。瓦片写为dir/z/x/y.mvt，只有一个名为symbols的图层，
+ * 要素带有type属性（符号类型名）。符号的多边形和折线是两个要素，id分别为2i+1和2i+2（i为符号序号）。
+ */
+class VectorTiler {
+public:
+    /**
+     * @param minZoom 最小级别
+     * @param maxZoom 最大级别，不超过22
+     * @param extent 瓦片坐标范围
+     * @param buffer 瓦片四周的缓冲区，单位为瓦片坐标，避免相邻瓦片接缝处的线宽被截断
+     */
+    VectorTiler(unsigned int minZoom = 0, unsigned int maxZoom = 14, unsigned int extent = 4096, unsigned int buffer = 64);
+
+    // 收集root下落图符号（FeatureNode、CircleNode和RectangleNode）的外形，圆按WGS84上的大地线取点
+    void addNode(osg::Node* root);
+    /**
+     * 添加一个符号
+     * @param typeName 符号类型名，写为要素的type属性
+     * @param polygons 多边形外环
+     * @param lines 折线
+     */
+    void addSymbol(const std::string& typeName, const Math::MultiLineString& polygons, const Math::MultiLineString& lines);
+    unsigned int getNumSymbols() const { return _symbols.size(); }
+
+    // 大地线模式：之后添加的符号各边加密为WGS84上的大地线，相邻点不超过meters米；为0时关闭
+    void setGeodesicSegment(double meters) { _geodesicSegment = meters; }
+    void clear() { _symbols.clear(); _typeNames.clear(); }
+
+    /**
+     * 切片并写入目录
+     * @param numThreads 线程数，为0时取硬件线程数
+     * @return 全部瓦片写入成功时返回true
+     */
+    bool write(const std::string& directory, std::ostream& log, unsigned int numThreads = 0);
+
+    /**
+     * 导出自检：在mapNode上放一个圆（CircleNode）导出到directory，
+     * 检查外环各点到圆心的距离等于半径、圆心所在的瓦片写出而远处的瓦片没有写出
+     * @return 全部检查通过时返回true
+     */
+    static bool check(osgEarth::MapNode* mapNode, const std::string& directory, std::ostream& log);
+
+private:
+    struct Symbol {
+        unsigned int typeName; // _typeNames下标
+        Math::MultiLineString polygons;
+        Math::MultiLineString lines;
+        Math::Extent bounds;
+    };
+    struct Tile {
+        unsigned int z, x, y;
+        std::vector<unsigned int> symbols;
+    };
+
+    // 外形与瓦片(z, x, y)相交的部分编码为MVT，没有要素时返回空串
+    std::string encodeTile(const Tile& tile) const;
+    // 级别z上与各符号的外形（而不只是包围盒）相交的瓦片
+    void collectTiles(unsigned int z, std::vector<Tile>& tiles) const;
+
+    unsigned int _minZoom, _maxZoom;
+    unsigned int _extent, _buffer;
+    Math::Geodesic _geodesic;
+    double _geodesicSegment;
+    std::vector<Symbol> _symbols;
+    std::vector<std::string> _typeNames;
+};
+
+#endif